@@ -0,0 +1,68 @@
+/// ========================================
+///
+///     BooleanBenchmark.cpp
+///
+///     Sequential MeshMinus vs. MeshMinusMany
+///
+/// ========================================
+
+#include <chrono>
+
+#include "Mesh/MeshBoolean.h"
+#include "Mesh/MeshCreator.h"
+
+double GetElapsedSeconds(const std::chrono::steady_clock::time_point &start) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+int main(int argc, char *argv[]) {
+    /// Drill a grid of holes through a plate
+    int toolNum = argc > 1 ? std::max(1, atoi(argv[1])) : 64;
+    int gridNum = static_cast<int>(std::ceil(std::sqrt(toolNum)));
+    double plateSize = 10.0;
+    double pitch = plateSize / gridNum;
+
+    Mesh *plate = MeshCreator::CreateCuboid(Eigen::Vector3d(plateSize, plateSize, 1.0));
+    std::vector<Mesh *> toolList;
+    for (int i = 0; i < toolNum; i++) {
+        double x = -0.5 * plateSize + (i % gridNum + 0.5) * pitch;
+        double y = -0.5 * plateSize + (i / gridNum + 0.5) * pitch;
+        toolList.push_back(MeshCreator::CreateCylinder(Eigen::Vector3d(x, y, -1), Eigen::Vector3d(x, y, 1), 0.3 * pitch, 16));
+    }
+    printf("Plate: %ld faces, %d tools\n", plate->GetFaceM().rows(), toolNum);
+
+    /// 1. N sequential MeshMinus calls
+    auto start = std::chrono::steady_clock::now();
+    Mesh *sequential = new Mesh(*plate);
+    for (Mesh *tool: toolList) {
+        Mesh *result = MeshBoolean::MeshMinus(sequential, tool);
+        delete sequential;
+        sequential = result;
+    }
+    double sequentialTime = GetElapsedSeconds(start);
+    printf("Sequential MeshMinus: %8.3f s  (%ld faces)\n", sequentialTime, sequential->GetFaceM().rows());
+
+    /// 2. One MeshMinusMany call
+    MeshBoolean::ResetStats();
+    start = std::chrono::steady_clock::now();
+    Mesh *batch = MeshBoolean::MeshMinusMany(plate, toolList);
+    double batchTime = GetElapsedSeconds(start);
+    printf("MeshMinusMany:        %8.3f s  (%ld faces, %ld passes)\n", batchTime, batch->GetFaceM().rows(),
+           MeshBoolean::GetStats().numBatchPass);
+    printf("Speedup: %.1fx\n", sequentialTime / std::max(batchTime, 1e-9));
+
+    /// 3. Both must cut out the same solid; the triangulations may differ, so compare volume and area
+    MeshMassProperties sequentialProp = sequential->ComputeMassProperties();
+    MeshMassProperties batchProp = batch->ComputeMassProperties();
+    auto isClose = [](double a, double b) { return std::abs(a - b) <= 1e-6 * std::max(std::abs(a), std::abs(b)); };
+    bool isAgreed = isClose(sequentialProp.volume, batchProp.volume) && isClose(sequentialProp.area, batchProp.area);
+    printf("Volume: %.9g vs %.9g, area: %.9g vs %.9g  %s\n", sequentialProp.volume, batchProp.volume,
+           sequentialProp.area, batchProp.area, isAgreed ? "(agree)" : "(MISMATCH)");
+
+    delete sequential;
+    delete batch;
+    delete plate;
+    for (Mesh *tool: toolList)
+        delete tool;
+    return isAgreed ? 0 : 1;
+}
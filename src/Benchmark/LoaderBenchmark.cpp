@@ -0,0 +1,56 @@
+/// ========================================
+///
+///     LoaderBenchmark.cpp
+///
+///     igl::readOBJ vs. MeshIO::ReadOBJ
+///
+/// ========================================
+
+#include <chrono>
+#include <iostream>
+#include <filesystem>
+
+#include <igl/readOBJ.h>
+
+#include "Mesh/MeshIO.h"
+
+double GetElapsedSeconds(const std::chrono::steady_clock::time_point &start) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+int main(int argc, char *argv[]) {
+    std::string fileName = argc > 1 ? argv[1] : "../data/bunny.obj";
+    int repeatNum = argc > 2 ? std::max(1, atoi(argv[2])) : 10;
+
+    std::error_code error;
+    double fileMB = static_cast<double>(std::filesystem::file_size(fileName, error)) / (1 << 20);
+    if (error) {
+        std::cout << "Cannot open file: " << fileName << std::endl;
+        return 1;
+    }
+
+    /// 1. igl::readOBJ
+    Eigen::MatrixX3d iglVerM;
+    Eigen::MatrixX3i iglFaceM;
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < repeatNum; i++)
+        igl::readOBJ(fileName, iglVerM, iglFaceM);
+    double iglTime = GetElapsedSeconds(start) / repeatNum;
+
+    /// 2. MeshIO::ReadOBJ
+    Eigen::MatrixX3d verM;
+    Eigen::MatrixX3i faceM;
+    start = std::chrono::steady_clock::now();
+    for (int i = 0; i < repeatNum; i++)
+        MeshIO::ReadOBJ(fileName, verM, faceM);
+    double ioTime = GetElapsedSeconds(start) / repeatNum;
+
+    bool isIdentical = (verM.rows() == iglVerM.rows() && faceM.rows() == iglFaceM.rows() &&
+                        verM == iglVerM && faceM == iglFaceM);
+
+    printf("%s: %.2f MB, %ld vertices, %ld faces\n", fileName.c_str(), fileMB, verM.rows(), faceM.rows());
+    printf("igl::readOBJ:    %8.2f ms  %8.1f MB/s\n", 1000 * iglTime, fileMB / iglTime);
+    printf("MeshIO::ReadOBJ: %8.2f ms  %8.1f MB/s\n", 1000 * ioTime, fileMB / ioTime);
+    printf("Identical: %s\n", isIdentical ? "yes" : "NO");
+    return isIdentical ? 0 : 1;
+}
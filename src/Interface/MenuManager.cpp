@@ -132,6 +132,10 @@ void MenuManager::InitMenu(igl::opengl::glfw::Viewer &viewer, igl::opengl::glfw:
             if (ImGui::SliderInt("Animation Speed", &AnimateSpeed, 1, 8)) {
                 std::cout << "speed is modified to " << AnimateSpeed << std::endl;
             }
+
+            ImGui::Dummy(ImVec2(0.0f, button_verticalGap));
+
+            ImGui::Text("Collisions: %d (depth %.4f)", collision_num, collision_depth);
             ImGui::Dummy(ImVec2(0.0f, gap_between_controlGroups));
         }
 
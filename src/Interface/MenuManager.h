@@ -31,6 +31,10 @@ public:
     bool is_restart = false;
     bool is_Optimize = false;
 
+    /// Colliding pairs and their largest penetration depth in the current frame
+    int collision_num = 0;
+    double collision_depth = 0;
+
 public:
     MenuManager() = default;
 
@@ -0,0 +1,116 @@
+/// ========================================
+///
+///     ModelMatrixPlugin.cpp
+///
+///     Draw objects with a per-object model
+///     matrix applied in the shader
+///
+/// ========================================
+
+#include "ModelMatrixPlugin.h"
+
+#include <igl/PI.h>
+#include <igl/look_at.h>
+#include <igl/frustum.h>
+#include <igl/ortho.h>
+
+ModelMatrixPlugin::ModelMatrixPlugin() {
+    plugin_name = "model_matrix";
+}
+
+/// ========================================
+///            Model Matrices
+/// ========================================
+
+void ModelMatrixPlugin::SetModelMatrix(igl::opengl::ViewerData &data, const Eigen::Affine3d &modelMat) {
+    auto iterator = entryMap.find(data.id);
+    if (iterator == entryMap.end()) {
+        iterator = entryMap.emplace(data.id, ModelEntry{Eigen::Matrix4f::Identity(), data.is_visible}).first;
+        /// Also out of the default draw loop of the current frame
+        data.is_visible = 0;
+    }
+    iterator->second.modelMat = modelMat.matrix().cast<float>();
+}
+
+void ModelMatrixPlugin::ClearModelMatrix(igl::opengl::ViewerData &data) {
+    auto iterator = entryMap.find(data.id);
+    if (iterator == entryMap.end())
+        return;
+    data.is_visible = iterator->second.visibleMask;
+    entryMap.erase(iterator);
+}
+
+bool ModelMatrixPlugin::HasModelMatrix(const igl::opengl::ViewerData &data) const {
+    return entryMap.count(data.id) > 0;
+}
+
+void ModelMatrixPlugin::SetVisible(const igl::opengl::ViewerData &data, bool is_visible) {
+    auto iterator = entryMap.find(data.id);
+    if (iterator == entryMap.end())
+        return;
+
+    /// Same convention as ViewerData::is_visible: one bit per core
+    iterator->second.visibleMask = is_visible ? ~0u : 0;
+}
+
+/// ========================================
+///                 Draw
+/// ========================================
+
+bool ModelMatrixPlugin::pre_draw() {
+    /// Hide the objects from the default draw loop
+    for (auto &data: viewer->data_list) {
+        if (entryMap.count(data.id) > 0)
+            data.is_visible = 0;
+    }
+    return false;
+}
+
+bool ModelMatrixPlugin::post_draw() {
+    for (auto &core: viewer->core_list) {
+        Eigen::Matrix4f view = ComputeViewMatrix(core);
+        core.proj = ComputeProjMatrix(core);
+
+        for (auto &data: viewer->data_list) {
+            auto iterator = entryMap.find(data.id);
+            if (iterator == entryMap.end() || !(iterator->second.visibleMask & core.id))
+                continue;
+
+            /// Only the uniforms change per object, the buffers are not touched
+            core.view = view * iterator->second.modelMat;
+            core.norm = core.view.inverse().transpose();
+            data.is_visible = iterator->second.visibleMask;
+            core.draw(data, false);
+            data.is_visible = 0;
+        }
+
+        /// Leave the camera matrices for picking and other callbacks
+        core.view = view;
+        core.norm = view.inverse().transpose();
+    }
+    return false;
+}
+
+Eigen::Matrix4f ModelMatrixPlugin::ComputeViewMatrix(const igl::opengl::ViewerCore &core) {
+    Eigen::Matrix4f view = Eigen::Matrix4f::Identity();
+    igl::look_at(core.camera_eye, core.camera_center, core.camera_up, view);
+    view = view * (core.trackball_angle * Eigen::Scaling(core.camera_zoom * core.camera_base_zoom) *
+                   Eigen::Translation3f(core.camera_translation + core.camera_base_translation)).matrix();
+    return view;
+}
+
+Eigen::Matrix4f ModelMatrixPlugin::ComputeProjMatrix(const igl::opengl::ViewerCore &core) {
+    Eigen::Matrix4f proj = Eigen::Matrix4f::Identity();
+    float width = core.viewport(2);
+    float height = core.viewport(3);
+    if (core.orthographic) {
+        float length = (core.camera_eye - core.camera_center).norm();
+        float h = tan(core.camera_view_angle / 360.0 * igl::PI) * length;
+        igl::ortho(-h * width / height, h * width / height, -h, h, core.camera_dnear, core.camera_dfar, proj);
+    } else {
+        float fH = tan(core.camera_view_angle / 360.0 * igl::PI) * core.camera_dnear;
+        float fW = fH * width / height;
+        igl::frustum(-fW, fW, -fH, fH, core.camera_dnear, core.camera_dfar, proj);
+    }
+    return proj;
+}
@@ -0,0 +1,51 @@
+/// ========================================
+///
+///     ModelMatrixPlugin.h
+///
+///     Draw objects with a per-object model
+///     matrix applied in the shader
+///
+/// ========================================
+
+#ifndef MODELMATRIXPLUGIN_H
+#define MODELMATRIXPLUGIN_H
+
+#include <unordered_map>
+#include <igl/opengl/glfw/Viewer.h>
+#include <igl/opengl/glfw/ViewerPlugin.h>
+
+/// Objects with a model matrix are taken out of the default draw loop of the viewer and drawn in
+/// post_draw with view * model, so moving them costs O(1) and never re-uploads the vertex buffers.
+/// Add this plugin before the ImGui plugin so that the menu is drawn on top.
+class ModelMatrixPlugin : public igl::opengl::glfw::ViewerPlugin {
+private:
+    struct ModelEntry {
+        Eigen::Matrix4f modelMat;
+        /// Visibility of the object (the mask of ViewerData::is_visible), kept here because
+        /// ViewerData::is_visible is cleared during the default draw loop
+        unsigned int visibleMask;
+    };
+
+    /// Keyed by ViewerData::id
+    std::unordered_map<int, ModelEntry> entryMap;
+
+public:
+    ModelMatrixPlugin();
+    ~ModelMatrixPlugin() override = default;
+
+    void SetModelMatrix(igl::opengl::ViewerData &data, const Eigen::Affine3d &modelMat);
+    void ClearModelMatrix(igl::opengl::ViewerData &data);
+    bool HasModelMatrix(const igl::opengl::ViewerData &data) const;
+
+    void SetVisible(const igl::opengl::ViewerData &data, bool is_visible);
+
+    bool pre_draw() override;
+    bool post_draw() override;
+
+    /// Same view/projection matrices as ViewerCore::draw computes from the camera
+    static Eigen::Matrix4f ComputeViewMatrix(const igl::opengl::ViewerCore &core);
+    static Eigen::Matrix4f ComputeProjMatrix(const igl::opengl::ViewerCore &core);
+};
+
+
+#endif //MODELMATRIXPLUGIN_H
@@ -12,6 +12,8 @@
 
 #include "RenderManager.h"
 
+#include "Mesh/MeshBoolean.h"
+
 void RenderManager::InitViewer(igl::opengl::glfw::Viewer &viewer) {
     /// Animation
     viewer.core().animation_max_fps = 60.0;
@@ -39,11 +41,21 @@ void RenderManager::InitViewer(igl::opengl::glfw::Viewer &viewer) {
     angle.z() = 0.0f;
     angle.w() = 1.0f;
     viewer.core().trackball_angle = angle;
+
+    /// Model matrices (drawn before the menu plugin, so that the menu stays on top)
+    viewer.plugins.insert(viewer.plugins.begin(), &ModelPlugin);
 }
 
 void
 RenderManager::RenderScene(igl::opengl::glfw::Viewer &viewer, const std::vector<igl::opengl::ViewerData> &datalist) {
     viewer.data_list.clear();
+    GroundGroup = LODGroup();
+    AxesGroup = LODGroup();
+    /// The levels of the models are uploaded again
+    for (ModelLOD &model: ModelLODList) {
+        model.group = LODGroup();
+        model.isBuilt = false;
+    }
 
     /// We have to render mechanism first (for animating it properly)
     RenderModel(viewer, datalist);
@@ -59,6 +71,10 @@ void
 RenderManager::RenderModel(igl::opengl::glfw::Viewer &viewer, const std::vector<igl::opengl::ViewerData> &datalist) {
     viewer.data_list = datalist;
     ModelNum = static_cast<int>(datalist.size());
+
+    /// Unique ids, the model matrices are keyed by them
+    for (auto &data: viewer.data_list)
+        data.id = static_cast<int>(viewer.next_data_id++);
 }
 
 void
@@ -67,41 +83,45 @@ RenderManager::RenderGround(igl::opengl::glfw::Viewer &viewer, const Eigen::Vect
     double halfSize = 0.5f * size;
     double cylinderRad = 0.002f * size;
 
-    /// 1. Create cylinders for the ground
-    std::vector<Mesh *> meshList;
-    meshList.reserve(2 * gridNum + 2);
-
-    Mesh *cylinder;
+    /// 1. Compute the end points of the grid lines
+    Eigen::MatrixXd startM(2 * gridNum + 2, 3);
+    Eigen::MatrixXd endM(2 * gridNum + 2, 3);
     for (int i = 0; i <= gridNum; i++) {
-        double z = -halfSize + (i / (double) gridNum) * size;
-        Eigen::Vector3d startPt = origin + Eigen::Vector3d(-halfSize, 0, z);
-        Eigen::Vector3d endPt = origin + Eigen::Vector3d(halfSize, 0, z);
-        cylinder = MeshCreator::CreateCylinder(startPt, endPt, cylinderRad, sampNum);
-        meshList.emplace_back(cylinder);
+        double t = -halfSize + (i / (double) gridNum) * size;
+        startM.row(i) = (origin + Eigen::Vector3d(-halfSize, 0, t)).transpose();
+        endM.row(i) = (origin + Eigen::Vector3d(halfSize, 0, t)).transpose();
+        startM.row(gridNum + 1 + i) = (origin + Eigen::Vector3d(t, 0, -halfSize)).transpose();
+        endM.row(gridNum + 1 + i) = (origin + Eigen::Vector3d(t, 0, halfSize)).transpose();
     }
+    GroundGroup.box.extend(Eigen::Vector3d(startM.colwise().minCoeff().transpose()));
+    GroundGroup.box.extend(Eigen::Vector3d(endM.colwise().maxCoeff().transpose()));
 
-    for (int i = 0; i <= gridNum; i++) {
-        double x = -halfSize + (i / (double) gridNum) * size;
-        Eigen::Vector3d startPt = origin + Eigen::Vector3d(x, 0, -halfSize);
-        Eigen::Vector3d endPt = origin + Eigen::Vector3d(x, 0, halfSize);
-        cylinder = MeshCreator::CreateCylinder(startPt, endPt, cylinderRad, sampNum);
-        meshList.emplace_back(cylinder);
+    /// 2. All grounds share one batch (one ViewerData, one draw call) per level of detail
+    if (UseGroundLines) {
+        GetBatchData(viewer, GroundGroup, 0, 0).add_edges(startM, endM, GetRGB("light gray"));
+        return;
     }
 
-    /// 2. Create viewerData for each mesh to render it
-    for (Mesh *mesh: meshList) {
-        igl::opengl::ViewerData data;
-        data.set_mesh(mesh->VerM, mesh->FaceM);
-        data.set_colors(GetRGB("light gray"));
-        data.show_lines = unsigned(0);
-        data.face_based = true;
-        viewer.data_list.emplace_back(data);
+    /// 3. Otherwise merge the cylinders of the grid into the batch of each level
+    std::vector<int> sampList = GetLODSampList(sampNum);
+    for (int level = 0; level < sampList.size(); level++) {
+        std::vector<Mesh *> meshList;
+        meshList.reserve(2 * gridNum + 2);
+        for (int i = 0; i < startM.rows(); i++) {
+            Eigen::Vector3d startPt = startM.row(i).transpose();
+            Eigen::Vector3d endPt = endM.row(i).transpose();
+            meshList.emplace_back(MeshCreator::CreateCylinder(startPt, endPt, cylinderRad, sampList[level]));
+        }
+        Mesh *batch = MeshBoolean::MeshConnect(meshList);
+
+        Eigen::MatrixXd colorM = GetRGB("light gray").replicate(batch->GetFaceM().rows(), 1);
+        double error = MeshCreator::GetChordError(cylinderRad, sampList[level]);
+        AppendBatchMesh(viewer, GroundGroup, level, error, batch, colorM);
+
+        for (Mesh *mesh: meshList)
+            delete mesh;
+        delete batch;
     }
-    GroundNum += static_cast<int>(meshList.size());
-
-    /// 3. Release memory for the meshList
-    for (Mesh *mesh: meshList)
-        delete mesh;
 }
 
 void
@@ -118,56 +138,352 @@ RenderManager::RenderAxes(igl::opengl::glfw::Viewer &viewer, const Eigen::Vector
     double coneRad = 0.04 * size;
     double sphereRad = 0.04 * size;
 
-    /// 2. Create 7 meshes for the axes (3 cylinders, 3 cones, and 1 sphere)
-    std::vector<Mesh *> meshList(7);
-    meshList[0] = MeshCreator::CreateCylinder(origin, xStartPt, cylinderRad, sampNum);
-    meshList[1] = MeshCreator::CreateCone(xStartPt, xEndPt, coneRad, sampNum);
+    AxesGroup.box.extend(Eigen::Vector3d(origin.array() - sphereRad));
+    AxesGroup.box.extend(Eigen::Vector3d(origin.array() + size));
+
+    std::vector<int> sampList = GetLODSampList(sampNum);
+    for (int level = 0; level < sampList.size(); level++) {
+        int samp = sampList[level];
+
+        /// 2. Create 7 meshes for the axes (3 cylinders, 3 cones, and 1 sphere)
+        std::vector<Mesh *> meshList(7);
+        meshList[0] = MeshCreator::CreateCylinder(origin, xStartPt, cylinderRad, samp);
+        meshList[1] = MeshCreator::CreateCone(xStartPt, xEndPt, coneRad, samp);
 
-    meshList[2] = MeshCreator::CreateCylinder(origin, yStartPt, cylinderRad, sampNum);
-    meshList[3] = MeshCreator::CreateCone(yStartPt, yEndPt, coneRad, sampNum);
+        meshList[2] = MeshCreator::CreateCylinder(origin, yStartPt, cylinderRad, samp);
+        meshList[3] = MeshCreator::CreateCone(yStartPt, yEndPt, coneRad, samp);
 
-    meshList[4] = MeshCreator::CreateCylinder(origin, zStartPt, cylinderRad, sampNum);
-    meshList[5] = MeshCreator::CreateCone(zStartPt, zEndPt, coneRad, sampNum);
+        meshList[4] = MeshCreator::CreateCylinder(origin, zStartPt, cylinderRad, samp);
+        meshList[5] = MeshCreator::CreateCone(zStartPt, zEndPt, coneRad, samp);
 
-    meshList[6] = MeshCreator::CreateSphere(origin, sphereRad, sampNum);
+        meshList[6] = MeshCreator::CreateSphere(origin, sphereRad, samp);
 
-    /// 3. Create viewerData for each mesh to render it
-    for (int i = 0; i < meshList.size(); i++) {
-        Mesh *mesh = meshList[i];
-        igl::opengl::ViewerData data;
-        data.set_mesh(mesh->VerM, mesh->FaceM);
+        /// 3. Merge them into one batch with per-face colors
+        Mesh *batch = MeshBoolean::MeshConnect(meshList);
 
-        if (i == 0 || i == 1) data.set_colors(GetRGB("red"));
-        else if (i == 2 || i == 3) data.set_colors(GetRGB("green"));
-        else if (i == 4 || i == 5) data.set_colors(GetRGB("blue"));
-        else data.set_colors(GetRGB("gray"));
+        Eigen::MatrixXd colorM(batch->GetFaceM().rows(), 3);
+        long faceStart = 0;
+        for (int i = 0; i < meshList.size(); i++) {
+            Eigen::RowVector3d color;
+            if (i == 0 || i == 1) color = GetRGB("red");
+            else if (i == 2 || i == 3) color = GetRGB("green");
+            else if (i == 4 || i == 5) color = GetRGB("blue");
+            else color = GetRGB("gray");
 
-        data.show_lines = unsigned(0);
-        data.face_based = true;
+            long faceNum = meshList[i]->GetFaceM().rows();
+            colorM.middleRows(faceStart, faceNum).rowwise() = color;
+            faceStart += faceNum;
+        }
 
-        viewer.data_list.emplace_back(data);
+        /// The largest radius has the largest chord error
+        double error = MeshCreator::GetChordError(std::max(coneRad, sphereRad), samp);
+        AppendBatchMesh(viewer, AxesGroup, level, error, batch, colorM);
+
+        /// 4. Release memory for the meshList
+        for (Mesh *mesh: meshList)
+            delete mesh;
+        delete batch;
     }
-    AxesNum += static_cast<int>(meshList.size());
+}
+
+/// ========================================
+///             Level of Detail
+/// ========================================
 
-    /// 4. Release memory for the meshList
-    for (Mesh *mesh: meshList)
-        delete mesh;
+/// Ring samples of the levels, coarse to fine (a single level of sampNum without adaptive LOD)
+std::vector<int> RenderManager::GetLODSampList(int sampNum) const {
+    if (!UseAdaptiveLOD)
+        return {sampNum};
+    return {4, 6, 8, 12, 16, 24, 32, 48, 64};
 }
 
-void RenderManager::ShowModel(igl::opengl::glfw::Viewer &viewer, bool is_visible) const {
-    for (int i = 0; i < ModelNum; i++) {
-        viewer.data_list[i].is_visible = is_visible;
+/// The batch of a level of a group, created on first use
+igl::opengl::ViewerData &RenderManager::GetBatchData(igl::opengl::glfw::Viewer &viewer, LODGroup &group, int level,
+                                                     double error) {
+    if (level >= group.dataIDList.size()) {
+        group.dataIDList.resize(level + 1, -1);
+        group.errorList.resize(level + 1, 0);
+    }
+    group.errorList[level] = std::max(group.errorList[level], error);
+
+    int &dataID = group.dataIDList[level];
+    if (dataID < 0) {
+        dataID = AppendData(viewer);
+        viewer.data_list[dataID].show_lines = unsigned(0);
+        viewer.data_list[dataID].face_based = true;
     }
+    return viewer.data_list[dataID];
 }
 
-void RenderManager::ShowGround(igl::opengl::glfw::Viewer &viewer, bool is_visible) const {
-    for (int i = ModelNum; i < (ModelNum + GroundNum); i++) {
-        viewer.data_list[i].is_visible = is_visible;
+/// Append a hidden ViewerData (with a unique id) and return its index, the selected data stays the same
+int RenderManager::AppendData(igl::opengl::glfw::Viewer &viewer) {
+    size_t selectedIndex = viewer.selected_data_index;
+    viewer.append_mesh(false);
+    viewer.selected_data_index = selectedIndex;
+    viewer.data_list.back().is_visible = 0;
+    return static_cast<int>(viewer.data_list.size()) - 1;
+}
+
+/// Merge a mesh (with per-face colors) into the batch of a level; the merged mesh is kept in the group,
+/// so the ViewerData is only written, never read back
+void RenderManager::AppendBatchMesh(igl::opengl::glfw::Viewer &viewer, LODGroup &group, int level, double error,
+                                    Mesh *part, const Eigen::MatrixXd &colorM) {
+    igl::opengl::ViewerData &data = GetBatchData(viewer, group, level, error);
+    if (level >= group.batchList.size()) {
+        group.batchList.resize(level + 1);
+        group.batchColorList.resize(level + 1);
     }
+
+    std::shared_ptr<Mesh> &batch = group.batchList[level];
+    Eigen::MatrixXd &batchColorM = group.batchColorList[level];
+    if (batch == nullptr) {
+        batch = std::make_shared<Mesh>(*part);
+        batchColorM = colorM;
+    } else {
+        batch.reset(MeshBoolean::MeshConnect(batch.get(), part));
+        long faceNum = batchColorM.rows();
+        batchColorM.conservativeResize(faceNum + colorM.rows(), 3);
+        batchColorM.bottomRows(colorM.rows()) = colorM;
+    }
+
+    /// clear() resets the display flags of the data, keep them
+    unsigned int show_lines = data.show_lines;
+    unsigned int is_visible = data.is_visible;
+    data.clear();
+    data.set_mesh(batch->GetVerM(), batch->GetFaceM());
+    data.set_colors(batchColorM);
+    data.show_lines = show_lines;
+    data.is_visible = is_visible;
+    data.face_based = true;
 }
 
-void RenderManager::ShowAxes(igl::opengl::glfw::Viewer &viewer, bool is_visible) const {
-    for (int i = ModelNum + GroundNum; i < (ModelNum + GroundNum + AxesNum); i++) {
-        viewer.data_list[i].is_visible = is_visible;
+/// Pixels covered by one unit of length at the point of the box nearest to the camera
+double RenderManager::ComputePixelsPerUnit(const igl::opengl::ViewerCore &core, const Eigen::AlignedBox3d &box) {
+    Eigen::Matrix4f view = ModelMatrixPlugin::ComputeViewMatrix(core);
+    Eigen::Matrix4f proj = ModelMatrixPlugin::ComputeProjMatrix(core);
+    double halfHeight = 0.5 * core.viewport(3);
+    /// The view matrix contains the (uniform) camera zoom
+    double scale = view.block<3, 3>(0, 0).col(0).norm();
+
+    if (core.orthographic)
+        return scale * proj(1, 1) * halfHeight;
+
+    Eigen::Vector3d eye = (view.inverse() * Eigen::Vector4f(0, 0, 0, 1)).head<3>().cast<double>();
+    double distance = box.isEmpty() ? 0 : box.exteriorDistance(eye);
+    if (distance <= 0)
+        return std::numeric_limits<double>::infinity();
+    return proj(1, 1) * halfHeight / distance;
+}
+
+/// Show the coarsest level whose error projects below LODPixelError (the finest if none does);
+/// modelMat is the model matrix of the levels
+void RenderManager::UpdateLOD(igl::opengl::glfw::Viewer &viewer, LODGroup &group, const Eigen::Affine3d &modelMat) {
+    int levelNum = static_cast<int>(group.dataIDList.size());
+    if (levelNum == 0)
+        return;
+
+    Eigen::AlignedBox3d box;
+    for (int i = 0; i < 8 && !group.box.isEmpty(); i++)
+        box.extend(modelMat * group.box.corner(static_cast<Eigen::AlignedBox3d::CornerType>(i)));
+    /// Errors scale with the model matrix as well
+    double errorScale = modelMat.linear().jacobiSvd().singularValues()(0);
+    double pixelsPerUnit = errorScale * ComputePixelsPerUnit(viewer.core(), box);
+
+    int activeLevel = levelNum - 1;
+    for (int level = 0; level < levelNum; level++) {
+        if (group.errorList[level] * pixelsPerUnit <= LODPixelError) {
+            activeLevel = level;
+            break;
+        }
     }
+    group.activeLevel = activeLevel;
+    ShowActiveLevel(viewer, group);
+}
+
+/// Only the active level of a visible group is shown (through the plugin for the levels it draws)
+void RenderManager::ShowActiveLevel(igl::opengl::glfw::Viewer &viewer, const LODGroup &group) {
+    for (int level = 0; level < static_cast<int>(group.dataIDList.size()); level++) {
+        if (group.dataIDList[level] < 0)
+            continue;
+        igl::opengl::ViewerData &data = viewer.data_list[group.dataIDList[level]];
+        bool is_visible = group.isVisible && level == group.activeLevel;
+        if (ModelPlugin.HasModelMatrix(data))
+            ModelPlugin.SetVisible(data, is_visible);
+        else
+            data.is_visible = is_visible;
+    }
+}
+
+void RenderManager::UpdateLOD(igl::opengl::glfw::Viewer &viewer) {
+    UpdateLOD(viewer, GroundGroup);
+    UpdateLOD(viewer, AxesGroup);
+
+    for (ModelLOD &model: ModelLODList) {
+        if (!model.isBuilt)
+            BuildModelLOD(viewer, model);
+        if (model.isBuilt)
+            UpdateLOD(viewer, model.group, model.modelMat);
+    }
+}
+
+/// ========================================
+///           Model Level of Detail
+/// ========================================
+
+void RenderManager::SetModelLOD(int modelID, Mesh *mesh) {
+    if (mesh != nullptr && !mesh->IsLODRequested())
+        mesh->BuildLODAsync();
+    for (ModelLOD &model: ModelLODList) {
+        if (model.modelID == modelID) {
+            model.mesh = mesh;
+            return;
+        }
+    }
+    ModelLOD model;
+    model.modelID = modelID;
+    model.mesh = mesh;
+    ModelLODList.push_back(model);
+}
+
+RenderManager::ModelLOD *RenderManager::GetModelLOD(int modelID) {
+    for (ModelLOD &model: ModelLODList) {
+        if (model.modelID == modelID)
+            return &model;
+    }
+    return nullptr;
+}
+
+/// Once the levels of the mesh are built, upload each of them to its own ViewerData (the model data itself
+/// is the finest level). Per-face colors are not carried over, the levels take the color of the first face.
+void RenderManager::BuildModelLOD(igl::opengl::glfw::Viewer &viewer, ModelLOD &model) {
+    if (model.mesh == nullptr || model.modelID < 0 || model.modelID >= ModelNum)
+        return;
+    MeshLODChain levelList;
+    if (!model.mesh->GetLODLevels(levelList))
+        return;
+    model.isBuilt = true;
+
+    /// Copy the settings first, appending data invalidates references into data_list
+    const igl::opengl::ViewerData &modelData = viewer.data_list[model.modelID];
+    unsigned int show_lines = modelData.show_lines;
+    bool face_based = modelData.face_based;
+    bool double_sided = modelData.double_sided;
+    Eigen::RowVector3d color = modelData.F_material_diffuse.rows() > 0
+                               ? Eigen::RowVector3d(modelData.F_material_diffuse.row(0).leftCols(3))
+                               : GetRGB("gold");
+
+    LODGroup &group = model.group;
+    group = LODGroup();
+    group.box = model.mesh->ComputeBoundingBox();
+    group.isVisible = modelData.is_visible != 0 || ModelPlugin.HasModelMatrix(modelData);
+
+    /// Coarse to fine
+    for (int i = static_cast<int>(levelList.size()) - 1; i >= 0; i--) {
+        int dataID = AppendData(viewer);
+        igl::opengl::ViewerData &data = viewer.data_list[dataID];
+        Eigen::MatrixXd verM;
+        Eigen::MatrixXi faceM;
+        levelList[i].storage.ToMatrices(verM, faceM);
+        data.set_mesh(verM, faceM);
+        data.set_colors(color);
+        data.show_lines = show_lines;
+        data.face_based = face_based;
+        data.double_sided = double_sided;
+        if (model.hasModelMat)
+            ModelPlugin.SetModelMatrix(data, model.modelMat);
+
+        group.dataIDList.push_back(dataID);
+        group.errorList.push_back(levelList[i].error);
+    }
+    group.dataIDList.push_back(model.modelID);
+    group.errorList.push_back(0);
+}
+
+/// ========================================
+///                Picking
+/// ========================================
+
+int RenderManager::PickModel(const igl::opengl::glfw::Viewer &viewer, double mouseX, double mouseY,
+                             MeshRayHit &hit) const {
+    const igl::opengl::ViewerCore &core = viewer.core_list[0];
+    Eigen::Matrix4d viewProj = (ModelMatrixPlugin::ComputeProjMatrix(core) *
+                                ModelMatrixPlugin::ComputeViewMatrix(core)).cast<double>();
+    Eigen::Matrix4d invViewProj = viewProj.inverse();
+
+    /// Mouse y is from the top of the window, the viewport from the bottom
+    double ndcX = 2 * (mouseX - core.viewport(0)) / core.viewport(2) - 1;
+    double ndcY = 2 * (core.viewport(3) - mouseY - core.viewport(1)) / core.viewport(3) - 1;
+    Eigen::Vector4d nearPt = invViewProj * Eigen::Vector4d(ndcX, ndcY, -1, 1);
+    Eigen::Vector4d farPt = invViewProj * Eigen::Vector4d(ndcX, ndcY, 1, 1);
+    Eigen::Vector3d origin = nearPt.head<3>() / nearPt(3);
+    Eigen::Vector3d dir = farPt.head<3>() / farPt(3) - origin;
+
+    int pickedID = -1;
+    hit = MeshRayHit();
+    for (const ModelLOD &model: ModelLODList) {
+        if (model.mesh == nullptr || !model.group.isVisible)
+            continue;
+
+        /// The ray into the frame of the mesh; t is unchanged by the affine map
+        Eigen::Affine3d invModelMat = model.modelMat.inverse();
+        MeshRayHit modelHit;
+        std::shared_ptr<const MeshBVH> bvh = model.mesh->GetBVH();
+        if (bvh->IntersectRay(model.mesh->GetVerM(), model.mesh->GetFaceM(), invModelMat * origin,
+                              invModelMat.linear() * dir, modelHit, hit.t)) {
+            hit = modelHit;
+            pickedID = model.modelID;
+        }
+    }
+    return pickedID;
+}
+
+/// ========================================
+///              Model Matrix
+/// ========================================
+
+/// The matrix is applied to every level of the model and kept for the levels built later (and for picking)
+void RenderManager::SetModelMatrix(igl::opengl::glfw::Viewer &viewer, int modelID, const Eigen::Affine3d &modelMat) {
+    if (modelID < 0 || modelID >= ModelNum)
+        return;
+    ModelPlugin.SetModelMatrix(viewer.data_list[modelID], modelMat);
+
+    ModelLOD *model = GetModelLOD(modelID);
+    if (model == nullptr)
+        return;
+    model->modelMat = modelMat;
+    model->hasModelMat = true;
+    for (int dataID: model->group.dataIDList)
+        ModelPlugin.SetModelMatrix(viewer.data_list[dataID], modelMat);
+}
+
+/// ========================================
+///              Visibility
+/// ========================================
+
+void RenderManager::ShowModel(igl::opengl::glfw::Viewer &viewer, bool is_visible) {
+    for (ModelLOD &model: ModelLODList) {
+        model.group.isVisible = is_visible;
+        if (model.isBuilt)
+            ShowActiveLevel(viewer, model.group);
+    }
+
+    /// Models without levels (or not built yet)
+    for (int i = 0; i < ModelNum; i++) {
+        ModelLOD *model = GetModelLOD(i);
+        if (model != nullptr && model->isBuilt)
+            continue;
+        if (ModelPlugin.HasModelMatrix(viewer.data_list[i]))
+            ModelPlugin.SetVisible(viewer.data_list[i], is_visible);
+        else
+            viewer.data_list[i].is_visible = is_visible;
+    }
+}
+
+/// The level shown is picked by the next UpdateLOD
+void RenderManager::ShowGround(igl::opengl::glfw::Viewer &viewer, bool is_visible) {
+    GroundGroup.isVisible = is_visible;
+}
+
+void RenderManager::ShowAxes(igl::opengl::glfw::Viewer &viewer, bool is_visible) {
+    AxesGroup.isVisible = is_visible;
 }
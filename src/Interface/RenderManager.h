@@ -16,19 +16,66 @@
 #include <igl/opengl/glfw/Viewer.h>
 
 #include "Mesh/MeshCreator.h"
+#include "Interface/ModelMatrixPlugin.h"
+
+/// An object rendered in several levels of detail, one ViewerData per level (coarse to fine);
+/// the level shown is picked from the projected size of its error
+struct LODGroup {
+    /// Index of each level in viewer.data_list
+    std::vector<int> dataIDList;
+    /// Object-space error of each level
+    std::vector<double> errorList;
+    Eigen::AlignedBox3d box;
+
+    /// Merged mesh and per-face colors of each level of a batch (ground/axes), which later parts are
+    /// appended to; unused by the models
+    std::vector<std::shared_ptr<Mesh>> batchList;
+    std::vector<Eigen::MatrixXd> batchColorList;
+
+    int activeLevel = -1;
+    bool isVisible = true;
+};
 
 class RenderManager {
+private:
+    /// A loaded model shown by the decimated levels of its mesh (see Mesh::BuildLODAsync)
+    struct ModelLOD {
+        int modelID = -1;
+        /// Owned by the caller, kept alive while the scene is shown
+        const Mesh *mesh = nullptr;
+        LODGroup group;
+        Eigen::Affine3d modelMat = Eigen::Affine3d::Identity();
+        bool hasModelMat = false;
+        /// The levels are uploaded (group is valid)
+        bool isBuilt = false;
+    };
+
+    std::vector<ModelLOD> ModelLODList;
+
 public:
     int ModelNum = 0;
-    int GroundNum = 0;
-    int AxesNum = 0;
+
+    /// Batched ground/axes
+    LODGroup GroundGroup;
+    LODGroup AxesGroup;
+
+    /// Draw the ground grid as GPU lines instead of thin cylinders
+    bool UseGroundLines = false;
+
+    /// Tessellate the ground/axes from the camera instead of a fixed sampNum
+    bool UseAdaptiveLOD = true;
+    /// Screen-space error target (pixels)
+    double LODPixelError = 0.5;
+
+    /// Draws the models that have a model matrix
+    ModelMatrixPlugin ModelPlugin;
 
 public:
     RenderManager() = default;
     ~RenderManager() = default;
 
     ///
-    static void InitViewer(igl::opengl::glfw::Viewer &viewer);
+    void InitViewer(igl::opengl::glfw::Viewer &viewer);
 
     /// Render Objects
     void RenderScene(igl::opengl::glfw::Viewer &viewer, const std::vector<igl::opengl::ViewerData> &datalist);
@@ -39,12 +86,44 @@ public:
     void RenderAxes(igl::opengl::glfw::Viewer &viewer, const Eigen::Vector3d &origin, double size, int sampNum);
 //    void DrawMeshForDebug(iglViewer &viewer);
 
+    /// Rigid transform of a model applied in the shader: the vertex buffers are not re-uploaded
+    void SetModelMatrix(igl::opengl::glfw::Viewer &viewer, int modelID, const Eigen::Affine3d &modelMat);
+
     /// Show/hide Objects
-    void ShowModel(igl::opengl::glfw::Viewer &viewer, bool is_visible) const;
-    void ShowGround(igl::opengl::glfw::Viewer &viewer, bool is_visible) const;
-    void ShowAxes(igl::opengl::glfw::Viewer &viewer, bool is_visible) const;
+    void ShowModel(igl::opengl::glfw::Viewer &viewer, bool is_visible);
+    void ShowGround(igl::opengl::glfw::Viewer &viewer, bool is_visible);
+    void ShowAxes(igl::opengl::glfw::Viewer &viewer, bool is_visible);
+
+    /// Show a model by the levels of detail of its mesh, as soon as they are built in the background
+    /// (the build is started here unless one was already requested)
+    void SetModelLOD(int modelID, Mesh *mesh);
+
+    /// Pick the level of detail of each group and model from the camera (call once per frame)
+    void UpdateLOD(igl::opengl::glfw::Viewer &viewer);
+
+    static double ComputePixelsPerUnit(const igl::opengl::ViewerCore &core, const Eigen::AlignedBox3d &box);
+
+    /// Nearest model (of those given a mesh by SetModelLOD) under the mouse, by the BVH of its mesh;
+    /// returns its modelID or -1, hit is in the frame of the mesh
+    int PickModel(const igl::opengl::glfw::Viewer &viewer, double mouseX, double mouseY, MeshRayHit &hit) const;
 
 //    void ShowInCurve(iglViewer &viewer, bool isVisible);
+
+private:
+    std::vector<int> GetLODSampList(int sampNum) const;
+    void UpdateLOD(igl::opengl::glfw::Viewer &viewer, LODGroup &group,
+                   const Eigen::Affine3d &modelMat = Eigen::Affine3d::Identity());
+    void ShowActiveLevel(igl::opengl::glfw::Viewer &viewer, const LODGroup &group);
+
+    ModelLOD *GetModelLOD(int modelID);
+    void BuildModelLOD(igl::opengl::glfw::Viewer &viewer, ModelLOD &model);
+
+    static int AppendData(igl::opengl::glfw::Viewer &viewer);
+
+    static igl::opengl::ViewerData &GetBatchData(igl::opengl::glfw::Viewer &viewer, LODGroup &group, int level,
+                                                 double error);
+    static void AppendBatchMesh(igl::opengl::glfw::Viewer &viewer, LODGroup &group, int level, double error,
+                                Mesh *part, const Eigen::MatrixXd &colorM);
 };
 
 
@@ -12,6 +12,9 @@
 
 #include "Interface/MenuManager.h"
 #include "Interface/RenderManager.h"
+#include "Mesh/MeshCollision.h"
+
+#include <GLFW/glfw3.h>
 
 bool key_down(igl::opengl::glfw::Viewer &viewer, unsigned char key, int modifier) {
     if (key == ' ') {
@@ -53,7 +56,7 @@ int main(int argc, char *argv[]) {
 
     std::vector<igl::opengl::ViewerData> DataList;
     igl::opengl::ViewerData data;
-    data.set_mesh(bunny->VerM, bunny->FaceM);
+    data.set_mesh(bunny->GetVerM(), bunny->GetFaceM());
     data.show_lines = false;
     data.face_based = true;
     data.double_sided = false;
@@ -65,27 +68,58 @@ int main(int argc, char *argv[]) {
 //    data.set_colors(Eigen::RowVector3d(0.86, 0.62, 0.86));
 //    DataList.emplace_back(data);
 
+    /// Collision between the bunny and the ground
+    Mesh *ground = MeshCreator::CreateCuboid(Eigen::Vector3d(-2, -0.01, -2), Eigen::Vector3d(2, 0, 2));
+    MeshCollision collision;
+    int bunnyObjectID = collision.AddObject(bunny);
+    collision.AddObject(ground);
+
     /// Render Scene
     renderMgr.RenderScene(viewer, DataList);
+    renderMgr.SetModelLOD(0, bunny);
 
     /// Animation
     viewer.callback_pre_draw = [&](igl::opengl::glfw::Viewer &) {
         renderMgr.ShowModel(viewer, menuMgr.is_model_visible);
         renderMgr.ShowGround(viewer, menuMgr.is_ground_visible);
         renderMgr.ShowAxes(viewer, menuMgr.is_axes_visible);
+        renderMgr.UpdateLOD(viewer);
 
         if (viewer.core().is_animating) {
             menuMgr.frame += menuMgr.AnimateSpeed;
-            Eigen::MatrixX3d new_verM;
-            bunny->Transform(GetTranslationMatrix(Eigen::Vector3d(0.001, 0.001, 0) * menuMgr.frame), new_verM);
-            viewer.data_list[0].set_vertices(new_verM);
+            Eigen::Affine3d modelMat = GetTranslationMatrix(Eigen::Vector3d(0.001, 0.001, 0) * menuMgr.frame);
+            renderMgr.SetModelMatrix(viewer, 0, modelMat);
+
+            collision.SetTransform(bunnyObjectID, modelMat);
+            std::vector<CollisionPair> pairList;
+            menuMgr.collision_num = collision.DetectCollisions(pairList);
+            menuMgr.collision_depth = 0;
+            for (const CollisionPair &pair: pairList) {
+                if (pair.isComplete)
+                    menuMgr.collision_depth = std::max(menuMgr.collision_depth, pair.penetrationDepth);
+            }
         }
 
         return false;
     };
 
+    /// Picking (shift + left click)
+    viewer.callback_mouse_down = [&](igl::opengl::glfw::Viewer &, int button, int modifier) {
+        if (button != static_cast<int>(igl::opengl::glfw::Viewer::MouseButton::Left) || !(modifier & GLFW_MOD_SHIFT))
+            return false;
+
+        MeshRayHit hit;
+        int modelID = renderMgr.PickModel(viewer, viewer.current_mouse_x, viewer.current_mouse_y, hit);
+        if (modelID >= 0)
+            std::cout << "Picked model " << modelID << ", face " << hit.faceID << std::endl;
+        return modelID >= 0;
+    };
+
     viewer.callback_key_down = &key_down;
     viewer.launch(false, "Libigl Example", menuMgr.WindowWidth, menuMgr.WindowHeight);
+
+    delete ground;
+    delete bunny;
     return 0;
 }
 
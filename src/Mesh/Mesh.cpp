@@ -11,6 +11,8 @@
 /// ========================================
 
 #include "Mesh.h"
+#include "MeshIO.h"
+#include "MeshConvexHull.h"
 
 
 Mesh::Mesh(const Eigen::MatrixXd &verM, const Eigen::MatrixXi &triM) {
@@ -23,11 +25,44 @@ Mesh::Mesh(const std::vector<Eigen::Vector3d> &verList, const std::vector<Eigen:
     FaceList2FaceMat(faceList);
 }
 
+Mesh::Mesh(const Mesh &other) : attrCache(other.attrCache) {
+    CopyFrom(other);
+}
+
+Mesh &Mesh::operator=(const Mesh &other) {
+    if (this != &other) {
+        attrCache = other.attrCache;
+        CopyFrom(other);
+    }
+    return *this;
+}
+
+/// Everything but the cache (whose own copy takes the same lock); the cached attributes already
+/// describe the transformed vertices
+void Mesh::CopyFrom(const Mesh &other) {
+    std::lock_guard<std::mutex> lock(other.attrCache.mutex);
+    other.ApplyPendingTransform();
+    FaceM = other.FaceM;
+    VerM = other.VerM;
+    pendingMat.setIdentity();
+    hasPendingTransform = false;
+    lodBuild = other.lodBuild;
+    lodMat = other.lodMat;
+    isLODReversed = other.isLODReversed;
+    bvh = other.bvh;
+    isBVHStale = other.isBVHStale;
+    topology = other.topology;
+}
+
 Mesh::Mesh(const std::string &fileName){
-    igl::readOBJ(fileName, VerM, FaceM);
+    if (MeshIO::ReadMesh(fileName, VerM, FaceM) && MeshLOD::BuildOnLoad)
+        BuildLODAsync();
 }
 
 void Mesh::VerList2VerMat(const std::vector<Eigen::Vector3d> &verList) {
+    MarkModified();
+    pendingMat.setIdentity();
+    hasPendingTransform = false;
     VerM.resize(static_cast<int>(verList.size()), 3);
     for (int i = 0; i < verList.size(); i++) {
         VerM(i, 0) = verList[i].x();
@@ -37,6 +72,7 @@ void Mesh::VerList2VerMat(const std::vector<Eigen::Vector3d> &verList) {
 }
 
 void Mesh::FaceList2FaceMat(const std::vector<Eigen::Vector3i> &faceList) {
+    MarkModified();
     FaceM.resize(static_cast<int>(faceList.size()), 3);
     for (int i = 0; i < faceList.size(); i++) {
         FaceM(i, 0) = faceList[i].x();
@@ -53,16 +89,20 @@ void Mesh::FaceMat2FaceList(std::vector<Eigen::Vector3i> &faceList) {
 }
 
 void Mesh::VerMat2VerList(std::vector<Eigen::Vector3d> &verList) {
-    verList.resize(VerM.rows());
-    for (int i = 0; i < VerM.rows(); i++) {
-        verList[i] << VerM(i, 0), VerM(i, 1), VerM(i, 2);
+    const Eigen::MatrixX3d &verM = GetVerM();
+    verList.resize(verM.rows());
+    for (int i = 0; i < verM.rows(); i++) {
+        verList[i] << verM(i, 0), verM(i, 1), verM(i, 2);
     }
 }
 
 void Mesh::GetConvexHull() {
+    MeshConvexHull hull;
+    hull.Build(GetVerM());
     Eigen::MatrixXd V;
-    igl::copyleft::cgal::convex_hull(VerM, V, FaceM);
+    hull.GetHull(V, FaceM);
     VerM = V;
+    MarkModified();
 }
 
 /// ========================================
@@ -77,6 +117,20 @@ void Mesh::ReverseNormal() {
         FaceM(i, 1) = z;
         FaceM(i, 2) = y;
     }
+
+    /// Flipping the orientation negates the normals and the signed volume integrals; the areas,
+    /// the box and the centroids are unchanged
+    std::lock_guard<std::mutex> lock(attrCache.mutex);
+    attrCache.CheckStamp(VerM, FaceM);
+    if (attrCache.IsValid(ATTR_FACE_NORMAL))
+        attrCache.FaceNormalM = -attrCache.FaceNormalM;
+    if (attrCache.IsValid(ATTR_VERTEX_NORMAL))
+        attrCache.VerNormalM = -attrCache.VerNormalM;
+    attrCache.MassProp.volume = -attrCache.MassProp.volume;
+    attrCache.MassProp.inertia = -attrCache.MassProp.inertia;
+    isLODReversed = !isLODReversed;
+    /// The half-edges run the other way
+    topology.reset();
 }
 
 /// ========================================
@@ -84,16 +138,66 @@ void Mesh::ReverseNormal() {
 /// ========================================
 
 void Mesh::Transform(const Eigen::Affine3d &affineMat) {
-    for (int i = 0; i < VerM.rows(); i++) {
-        VerM.row(i) = (MultiplyPoint(affineMat, VerM.row(i).transpose()).transpose()).eval();
+    {
+        std::lock_guard<std::mutex> lock(attrCache.mutex);
+        pendingMat = affineMat * pendingMat;
+        hasPendingTransform = true;
+        lodMat = affineMat * lodMat;
+        isBVHStale = true;
     }
+    UpdateAttributes(affineMat);
 }
 
-void Mesh::Transform(const Eigen::Affine3d &affineMat, Eigen::MatrixX3d &newVerM) {
-    newVerM = VerM;
-    for (int i = 0; i < VerM.rows(); i++) {
-        newVerM.row(i) = MultiplyPoint(affineMat, VerM.row(i).transpose()).transpose();
-    }
+/// Transformed vertices in newVerM, the mesh itself is unchanged (and the pending transform stays pending)
+void Mesh::Transform(const Eigen::Affine3d &affineMat, Eigen::MatrixX3d &newVerM) const {
+    std::lock_guard<std::mutex> lock(attrCache.mutex);
+    newVerM.resize(VerM.rows(), 3);
+    TransformVertexMatrix(hasPendingTransform ? Eigen::Affine3d(affineMat * pendingMat) : affineMat, VerM, newVerM);
+}
+
+/// ========================================
+///            Pending Transform
+/// ========================================
+
+const Eigen::MatrixX3d &Mesh::GetVerM() const {
+    std::lock_guard<std::mutex> lock(attrCache.mutex);
+    ApplyPendingTransform();
+    return VerM;
+}
+
+Eigen::MatrixX3d &Mesh::EditVerM() {
+    std::lock_guard<std::mutex> lock(attrCache.mutex);
+    ApplyPendingTransform();
+    attrCache.Invalidate();
+    lodBuild.reset();
+    isBVHStale = true;
+    return VerM;
+}
+
+Eigen::MatrixX3i &Mesh::EditFaceM() {
+    MarkModified();
+    return FaceM;
+}
+
+bool Mesh::HasPendingTransform() const {
+    std::lock_guard<std::mutex> lock(attrCache.mutex);
+    return hasPendingTransform;
+}
+
+/// Rewrite the vertices in place; the cached attributes already describe the transformed mesh
+/// (the caller holds attrCache.mutex)
+void Mesh::ApplyPendingTransform() const {
+    if (!hasPendingTransform)
+        return;
+    TransformVertexMatrix(pendingMat, VerM, VerM);
+    pendingMat.setIdentity();
+    hasPendingTransform = false;
+}
+
+/// Vertex i with the pending transform, without materializing (the caller holds attrCache.mutex)
+Eigen::Vector3d Mesh::GetPoint(long i) const {
+    Eigen::Vector3d p = VerM.row(i).transpose();
+    return hasPendingTransform ? Eigen::Vector3d(pendingMat * p) : p;
 }
 
 /// ========================================
@@ -101,7 +205,18 @@ void Mesh::Transform(const Eigen::Affine3d &affineMat, Eigen::MatrixX3d &newVerM
 /// ========================================
 
 void Mesh::SaveOBJ(const std::string &fileName) {
-    igl::writeOBJ("../data/" + fileName, VerM, FaceM);
+    ExportOBJ("../data/" + fileName);
+}
+
+/// Write to any path; writeBinary also writes the ".mbin" sidecar read back by Mesh(fileName)
+bool Mesh::ExportOBJ(const std::string &filePath, bool writeBinary) const {
+    return MeshIO::WriteOBJ(filePath, GetVerM(), FaceM, writeBinary);
+}
+
+/// Write a snapshot of the mesh on a background thread, so the caller (e.g. the viewer) is not blocked by
+/// the formatting and the disk; only the copy of the matrices is made here, before the mesh can change
+std::future<bool> Mesh::ExportOBJAsync(const std::string &filePath, bool writeBinary) const {
+    return MeshIO::WriteOBJAsync(filePath, GetVerM(), FaceM, writeBinary);
 }
 
 /// ========================================
@@ -109,30 +224,241 @@ void Mesh::SaveOBJ(const std::string &fileName) {
 /// ========================================
 
 double Mesh::ComputeVolume() {
-    Eigen::RowVector3d origin, v0, v1, v2;
-    origin = Eigen::RowVector3d::Zero();
-    double volume = 0;
-    for (int i = 0; i < FaceM.rows(); i++) {
-        v0 = VerM.row(FaceM(i, 0));
-        v1 = VerM.row(FaceM(i, 1));
-        v2 = VerM.row(FaceM(i, 2));
-        volume += (origin - v2).dot((v1 - v2).cross(v0 - v2));
-    }
-    volume /= 6.0f;
-    return volume;
+    return ComputeMassProperties().volume;
 }
 
 Eigen::Vector3d Mesh::ComputeGeometricCenter() const{
-    Eigen::MatrixXd baryCenter;
-    igl::barycenter(VerM, FaceM, baryCenter);
+    return ComputeMassProperties().surfaceCentroid;
+}
+
+/// Volume, area, centroids, inertia and bounding box in one parallel pass over the faces
+MeshMassProperties Mesh::ComputeMassProperties() const {
+    std::lock_guard<std::mutex> lock(attrCache.mutex);
+    attrCache.CheckStamp(VerM, FaceM);
+    if (!attrCache.IsValid(ATTR_MASS_PROPERTIES)) {
+        attrCache.MassProp = ::ComputeMassProperties(VerM, FaceM, hasPendingTransform ? &pendingMat : nullptr);
+        attrCache.Box = attrCache.MassProp.box;
+        attrCache.validFlags |= ATTR_MASS_PROPERTIES | ATTR_BOUNDING_BOX;
+    } else if (!attrCache.IsValid(ATTR_BOUNDING_BOX)) {
+        /// After a rotation the integrals are still valid (see UpdateAttributes), only the box is redone
+        ComputeBox();
+    }
+    return attrCache.MassProp;
+}
 
-    Eigen::VectorXd doubleArea;
-    igl::doublearea(VerM, FaceM, doubleArea);
+Eigen::AlignedBox3d Mesh::ComputeBoundingBox() const {
+    std::lock_guard<std::mutex> lock(attrCache.mutex);
+    attrCache.CheckStamp(VerM, FaceM);
+    if (!attrCache.IsValid(ATTR_BOUNDING_BOX))
+        ComputeBox();
+    return attrCache.Box;
+}
 
-    Eigen::RowVector3d weightedCentroid = (baryCenter.array().colwise() * doubleArea.array()).colwise().sum() / doubleArea.sum();
-    return weightedCentroid.transpose();
+/// One pass over the vertices (the caller holds attrCache.mutex)
+void Mesh::ComputeBox() const {
+    attrCache.Box.setEmpty();
+    if (hasPendingTransform) {
+        for (long i = 0; i < VerM.rows(); i++)
+            attrCache.Box.extend(GetPoint(i));
+    } else if (VerM.rows() > 0) {
+        attrCache.Box.min() = VerM.colwise().minCoeff().transpose();
+        attrCache.Box.max() = VerM.colwise().maxCoeff().transpose();
+    }
+    attrCache.MassProp.box = attrCache.Box;
+    attrCache.validFlags |= ATTR_BOUNDING_BOX;
 }
 
 void Mesh::CenterMoveToOrigin(){
     Transform(GetTranslationMatrix(-ComputeGeometricCenter()));
 }
+
+/// ========================================
+///          Cached Face Attributes
+/// ========================================
+
+const Eigen::MatrixX3d &Mesh::GetFaceNormals() const {
+    std::lock_guard<std::mutex> lock(attrCache.mutex);
+    attrCache.CheckStamp(VerM, FaceM);
+    if (!attrCache.IsValid(ATTR_FACE_NORMAL))
+        ComputeFaceAttributes();
+    return attrCache.FaceNormalM;
+}
+
+const Eigen::VectorXd &Mesh::GetFaceAreas() const {
+    std::lock_guard<std::mutex> lock(attrCache.mutex);
+    attrCache.CheckStamp(VerM, FaceM);
+    if (!attrCache.IsValid(ATTR_FACE_AREA))
+        ComputeFaceAttributes();
+    return attrCache.FaceAreaV;
+}
+
+/// Normals and areas come from the same cross product, so both are computed in one pass
+void Mesh::ComputeFaceAttributes() const {
+    long faceNum = FaceM.rows();
+    attrCache.FaceNormalM.resize(faceNum, 3);
+    attrCache.FaceAreaV.resize(faceNum);
+    igl::parallel_for(faceNum, [&](long i) {
+        Eigen::Vector3d v0 = GetPoint(FaceM(i, 0));
+        Eigen::Vector3d n = (GetPoint(FaceM(i, 1)) - v0).cross(GetPoint(FaceM(i, 2)) - v0);
+        double norm = n.norm();
+        attrCache.FaceAreaV(i) = 0.5 * norm;
+        attrCache.FaceNormalM.row(i) = norm > 0 ? Eigen::RowVector3d(n.transpose() / norm) : Eigen::RowVector3d::Zero();
+    }, 1000);
+    attrCache.validFlags |= ATTR_FACE_NORMAL | ATTR_FACE_AREA;
+}
+
+/// Sum of the unnormalized face normals (twice the area times the unit normal) over the faces of each vertex
+const Eigen::MatrixX3d &Mesh::GetVertexNormals() const {
+    std::lock_guard<std::mutex> lock(attrCache.mutex);
+    attrCache.CheckStamp(VerM, FaceM);
+    if (!attrCache.IsValid(ATTR_VERTEX_NORMAL)) {
+        if (!attrCache.IsValid(ATTR_FACE_NORMAL | ATTR_FACE_AREA))
+            ComputeFaceAttributes();
+        UpdateTopology();
+        attrCache.VerNormalM.resize(VerM.rows(), 3);
+        igl::parallel_for(VerM.rows(), [&](long i) {
+            Eigen::RowVector3d n = Eigen::RowVector3d::Zero();
+            for (int faceID: topology->GetVertexFaces(static_cast<int>(i)))
+                n += attrCache.FaceAreaV(faceID) * attrCache.FaceNormalM.row(faceID);
+            double norm = n.norm();
+            attrCache.VerNormalM.row(i) = norm > 0 ? Eigen::RowVector3d(n / norm) : Eigen::RowVector3d::Zero();
+        }, 1000);
+        attrCache.validFlags |= ATTR_VERTEX_NORMAL;
+    }
+    return attrCache.VerNormalM;
+}
+
+/// ========================================
+///               Connectivity
+/// ========================================
+
+std::shared_ptr<const MeshTopology> Mesh::GetTopology() const {
+    std::lock_guard<std::mutex> lock(attrCache.mutex);
+    UpdateTopology();
+    return topology;
+}
+
+/// Only the faces and the number of vertices matter, moved vertices keep it (the caller holds attrCache.mutex)
+void Mesh::UpdateTopology() const {
+    if (topology != nullptr && topology->GetFaceNum() == FaceM.rows() && topology->GetVerNum() == VerM.rows())
+        return;
+    auto newTopology = std::make_shared<MeshTopology>();
+    newTopology->Build(FaceM, static_cast<int>(VerM.rows()));
+    topology = newTopology;
+}
+
+void Mesh::MarkModified() {
+    std::lock_guard<std::mutex> lock(attrCache.mutex);
+    attrCache.Invalidate();
+    lodBuild.reset();
+    bvh.reset();
+    topology.reset();
+}
+
+/// ========================================
+///             Level of Detail
+/// ========================================
+
+void Mesh::BuildLODAsync(const std::vector<double> &ratioList) {
+    std::lock_guard<std::mutex> lock(attrCache.mutex);
+    ApplyPendingTransform();
+    lodBuild = MeshLOD::BuildLODChainAsync(VerM, FaceM, ratioList);
+    lodMat.setIdentity();
+    isLODReversed = false;
+}
+
+bool Mesh::IsLODRequested() const {
+    std::lock_guard<std::mutex> lock(attrCache.mutex);
+    return lodBuild != nullptr;
+}
+
+bool Mesh::GetLODLevels(MeshLODChain &levelList) const {
+    std::shared_ptr<const MeshLODBuild> build;
+    Eigen::Affine3d affineMat;
+    bool lodReversed;
+    {
+        std::lock_guard<std::mutex> lock(attrCache.mutex);
+        build = lodBuild;
+        affineMat = lodMat;
+        lodReversed = isLODReversed;
+    }
+    std::shared_ptr<const MeshLODChain> chainPtr = build ? build->GetChain() : nullptr;
+    if (chainPtr == nullptr)
+        return false;
+
+    /// Distances grow at most by the largest singular value of the transform
+    const MeshLODChain &chain = *chainPtr;
+    double errorScale = affineMat.linear().jacobiSvd().singularValues()(0);
+    levelList.resize(chain.size());
+    for (int i = 0; i < chain.size(); i++) {
+        levelList[i].storage = chain[i].storage;
+        levelList[i].storage.Transform(affineMat);
+        if (lodReversed)
+            levelList[i].storage.FaceM.col(1).swap(levelList[i].storage.FaceM.col(2));
+        levelList[i].error = chain[i].error * errorScale;
+    }
+    return true;
+}
+
+/// Keep the cache valid across a rigid transform: areas and volume are invariant, normals, centroids
+/// and inertia are rotated, and the box is shifted by a pure translation. A rotation only drops the box,
+/// recomputed alone on the next read; other transforms drop the cache.
+void Mesh::UpdateAttributes(const Eigen::Affine3d &affineMat) {
+    std::lock_guard<std::mutex> lock(attrCache.mutex);
+    attrCache.CheckStamp(VerM, FaceM);
+    if (!IsRigidTransform(affineMat)) {
+        attrCache.Invalidate();
+        return;
+    }
+
+    Eigen::Matrix3d R = affineMat.linear();
+    Eigen::Vector3d t = affineMat.translation();
+    bool isTranslation = R == Eigen::Matrix3d::Identity();
+
+    if (attrCache.IsValid(ATTR_FACE_NORMAL) && !isTranslation)
+        attrCache.FaceNormalM = attrCache.FaceNormalM * R.transpose();
+    if (attrCache.IsValid(ATTR_VERTEX_NORMAL) && !isTranslation)
+        attrCache.VerNormalM = attrCache.VerNormalM * R.transpose();
+
+    if (attrCache.IsValid(ATTR_MASS_PROPERTIES)) {
+        MeshMassProperties &massProp = attrCache.MassProp;
+        massProp.surfaceCentroid = R * massProp.surfaceCentroid + t;
+        massProp.volumeCentroid = R * massProp.volumeCentroid + t;
+        massProp.inertia = R * massProp.inertia * R.transpose();
+    }
+
+    if (isTranslation && attrCache.IsValid(ATTR_BOUNDING_BOX)) {
+        attrCache.Box.translate(t);
+        attrCache.MassProp.box = attrCache.Box;
+    } else {
+        attrCache.Invalidate(ATTR_BOUNDING_BOX);
+    }
+}
+
+/// ========================================
+///           Spatial Queries
+/// ========================================
+
+std::shared_ptr<const MeshBVH> Mesh::GetBVH() const {
+    std::lock_guard<std::mutex> lock(attrCache.mutex);
+    ApplyPendingTransform();
+    if (bvh == nullptr || bvh->GetFaceNum() != FaceM.rows()) {
+        bvh = std::make_shared<MeshBVH>();
+        bvh->Build(VerM, FaceM);
+    } else if (isBVHStale) {
+        /// Copy on write: copies of the mesh (and returned pointers) keep the old boxes
+        if (bvh.use_count() > 1)
+            bvh = std::make_shared<MeshBVH>(*bvh);
+        bvh->Refit(VerM, FaceM);
+    }
+    isBVHStale = false;
+    return bvh;
+}
+
+bool Mesh::IntersectRay(const Eigen::Vector3d &origin, const Eigen::Vector3d &dir, MeshRayHit &hit) const {
+    return GetBVH()->IntersectRay(VerM, FaceM, origin, dir, hit);
+}
+
+bool Mesh::ComputeClosestPoint(const Eigen::Vector3d &point, MeshClosestPoint &result) const {
+    return GetBVH()->ComputeClosestPoint(VerM, FaceM, point, result);
+}
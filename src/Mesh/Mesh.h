@@ -13,6 +13,7 @@
 #ifndef MESH_H
 #define MESH_H
 
+#include <future>
 #include <fstream>
 #include <iostream>
 #include <Eigen/Geometry>
@@ -22,22 +23,26 @@
 #include <igl/barycenter.h>
 #include <igl/doublearea.h>
 #include <igl/copyleft/cgal/convex_hull.h>
+#include <igl/parallel_for.h>
 
 #include "Utility/HelpFunc.h"
+#include "Mesh/MeshMassProperties.h"
+#include "Mesh/MeshAttributeCache.h"
+#include "Mesh/MeshLOD.h"
+#include "Mesh/MeshBVH.h"
+#include "Mesh/MeshTopology.h"
 //#include "Utility/HelpStruct.h"
 
 class Mesh {
-public:
-    /// Store vertices in a matrix (n,3)
-    Eigen::MatrixX3d VerM;
-
-    /// Store triangles in a matrix (m,3)
-    Eigen::MatrixX3i FaceM;
-
 public:
     Mesh() = default;
     ~Mesh() = default;
 
+    /// The source may be read by other threads meanwhile (e.g. a leaf shared by the workers of MeshCSG),
+    /// so its pending transform is applied and its state copied under its lock
+    Mesh(const Mesh &other);
+    Mesh &operator=(const Mesh &other);
+
     Mesh(const Eigen::MatrixXd &verM, const Eigen::MatrixXi &faceM);
     Mesh(const std::vector<Eigen::Vector3d> &verList, const std::vector<Eigen::Vector3i> &faceList);
     explicit Mesh(const std::string &fileName);
@@ -47,18 +52,105 @@ public:
     void VerMat2VerList(std::vector<Eigen::Vector3d> &verList);
     void FaceMat2FaceList(std::vector<Eigen::Vector3i> &faceList);
 
+    /// Vertices (n,3) with the pending transform applied (materialized on the first read). The reference
+    /// stays valid and unchanged until the next non-const call on the mesh (Transform, EditVerM, ...),
+    /// which must not run concurrently with readers, as for any other non-const member.
+    const Eigen::MatrixX3d &GetVerM() const;
+    /// Materialized vertices for direct editing; the cached attributes are dropped
+    Eigen::MatrixX3d &EditVerM();
+    bool HasPendingTransform() const;
+
+    /// Triangles (m,3)
+    const Eigen::MatrixX3i &GetFaceM() const { return FaceM; }
+    /// Triangles for direct editing; the cached attributes, the topology, the hierarchy and the levels
+    /// of detail are dropped
+    Eigen::MatrixX3i &EditFaceM();
+
     void ReverseNormal();
 
+    /// Composed with the pending transform in O(1); the vertices are only rewritten when read
     void Transform(const Eigen::Affine3d &affineMat);
-    void Transform(const Eigen::Affine3d &affineMat, Eigen::MatrixX3d &newVerM);
+    void Transform(const Eigen::Affine3d &affineMat, Eigen::MatrixX3d &newVerM) const;
 
     void GetConvexHull();
 
     void SaveOBJ(const std::string &fileName);
+    bool ExportOBJ(const std::string &filePath, bool writeBinary = false) const;
+    /// Copies the matrices on the calling thread (the mesh may change right after), then writes them
+    /// on a background thread; keep the future, its destructor waits for the write
+    [[nodiscard]] std::future<bool> ExportOBJAsync(const std::string &filePath, bool writeBinary = false) const;
 
     double ComputeVolume();
     Eigen::Vector3d ComputeGeometricCenter() const;
+    Eigen::AlignedBox3d ComputeBoundingBox() const;
+    MeshMassProperties ComputeMassProperties() const;
     void CenterMoveToOrigin();
+
+    /// Unit normals and areas of the faces (cached)
+    const Eigen::MatrixX3d &GetFaceNormals() const;
+    const Eigen::VectorXd &GetFaceAreas() const;
+    /// Area-weighted average of the normals of the faces around each vertex (cached)
+    const Eigen::MatrixX3d &GetVertexNormals() const;
+
+    /// Connectivity of the faces, built on first use and shared by copies until the faces change
+    /// (MarkModified, ReverseNormal or a new number of faces or vertices)
+    std::shared_ptr<const MeshTopology> GetTopology() const;
+
+    /// Required after editing the faces or the vertices through a reference kept from an earlier EditFaceM()
+    /// or EditVerM(): the cache only notices matrices that were reallocated or resized, not rewritten values
+    void MarkModified();
+
+    /// Build decimated levels of detail on the workers of MeshLOD (started by Mesh(fileName) with
+    /// MeshLOD::BuildOnLoad). Transforms of the mesh are carried over to the levels, edits drop them
+    /// without waiting for a running build.
+    void BuildLODAsync(const std::vector<double> &ratioList = MeshLOD::DefaultRatioList);
+    /// A build was started and not dropped since
+    bool IsLODRequested() const;
+    /// Levels (fine to coarse) in the current frame of the mesh; false while they are being built or if
+    /// none were requested. An empty list means the mesh could not be decimated.
+    bool GetLODLevels(MeshLODChain &levelList) const;
+
+    /// Hierarchy over the faces, built on first use and refit (not rebuilt) after Transform or EditVerM;
+    /// the batched queries take GetVerM() and GetFaceM()
+    std::shared_ptr<const MeshBVH> GetBVH() const;
+    bool IntersectRay(const Eigen::Vector3d &origin, const Eigen::Vector3d &dir, MeshRayHit &hit) const;
+    bool ComputeClosestPoint(const Eigen::Vector3d &point, MeshClosestPoint &result) const;
+
+private:
+    /// Store vertices in a matrix (n,3); a pending transform may not be applied to them yet,
+    /// so they are only reached through GetVerM() and EditVerM()
+    mutable Eigen::MatrixX3d VerM;
+
+    /// Store triangles in a matrix (m,3); they are only changed through EditFaceM(), which drops
+    /// everything derived from them
+    Eigen::MatrixX3i FaceM;
+
+    /// Derived attributes, computed on first access and kept until the mesh changes
+    /// (its mutex also guards the pending transform)
+    mutable MeshAttributeCache attrCache;
+
+    /// Transform composed by Transform() but not applied to VerM yet
+    mutable Eigen::Affine3d pendingMat = Eigen::Affine3d::Identity();
+    mutable bool hasPendingTransform = false;
+
+    /// Levels of detail, in the frame of the mesh when their build started, and the transform since then
+    std::shared_ptr<const MeshLODBuild> lodBuild;
+    Eigen::Affine3d lodMat = Eigen::Affine3d::Identity();
+    bool isLODReversed = false;
+
+    /// Shared by copies of the mesh until one of them refits it
+    mutable std::shared_ptr<MeshBVH> bvh;
+    mutable bool isBVHStale = false;
+
+    mutable std::shared_ptr<const MeshTopology> topology;
+
+    void CopyFrom(const Mesh &other);
+    void ApplyPendingTransform() const;
+    Eigen::Vector3d GetPoint(long i) const;
+    void ComputeFaceAttributes() const;
+    void ComputeBox() const;
+    void UpdateTopology() const;
+    void UpdateAttributes(const Eigen::Affine3d &affineMat);
 };
 
 
@@ -0,0 +1,110 @@
+/// ========================================
+///
+///     MeshAttributeCache.h
+///
+///     Lazily computed derived attributes
+///     of a mesh with dirty tracking
+///
+/// ========================================
+
+#ifndef MESHATTRIBUTECACHE_H
+#define MESHATTRIBUTECACHE_H
+
+#include <mutex>
+#include <Eigen/Geometry>
+
+#include "Mesh/MeshMassProperties.h"
+
+/// Attributes held by the cache (bit flags)
+enum MeshAttribute {
+    ATTR_FACE_NORMAL = 1,
+    ATTR_FACE_AREA = 2,
+    ATTR_BOUNDING_BOX = 4,
+    ATTR_MASS_PROPERTIES = 8,
+    ATTR_VERTEX_NORMAL = 16,
+    ATTR_ALL = 31
+};
+
+/// Cached attributes of a mesh, filled on first access by Mesh and dropped (or updated) when the mesh changes.
+/// Copies keep the cached values but get their own mutex, so meshes stay copyable.
+class MeshAttributeCache {
+public:
+    Eigen::MatrixX3d FaceNormalM;
+    Eigen::VectorXd FaceAreaV;
+    Eigen::MatrixX3d VerNormalM;
+    Eigen::AlignedBox3d Box;
+    MeshMassProperties MassProp;
+
+    /// Attributes currently valid
+    int validFlags = 0;
+
+    /// Matrices the attributes were computed from; a mismatch (e.g. VerM reassigned with a new size)
+    /// drops the cache even when the edit was not reported (see CheckStamp)
+    const double *verData = nullptr;
+    const int *faceData = nullptr;
+    long verNum = 0;
+    long faceNum = 0;
+
+    mutable std::mutex mutex;
+
+public:
+    MeshAttributeCache() = default;
+    ~MeshAttributeCache() = default;
+
+    MeshAttributeCache(const MeshAttributeCache &other) {
+        std::lock_guard<std::mutex> lock(other.mutex);
+        CopyFrom(other);
+    }
+
+    MeshAttributeCache &operator=(const MeshAttributeCache &other) {
+        if (this != &other) {
+            std::scoped_lock lock(mutex, other.mutex);
+            CopyFrom(other);
+        }
+        return *this;
+    }
+
+    bool IsValid(int flags) const {
+        return (validFlags & flags) == flags;
+    }
+
+    void Invalidate(int flags = ATTR_ALL) {
+        validFlags &= ~flags;
+    }
+
+    /// Drop everything if the matrices are not the ones the attributes were computed from. This is only a
+    /// safety net for reassigned matrices: an in-place edit keeps the same buffers and sizes and is not
+    /// detected, so it must be reported by Mesh::MarkModified
+    void CheckStamp(const Eigen::MatrixX3d &verM, const Eigen::MatrixX3i &faceM) {
+        bool isCopied = verData == nullptr && faceData == nullptr;
+        if (isCopied && verNum == verM.rows() && faceNum == faceM.rows()) {
+            verData = verM.data();
+            faceData = faceM.data();
+        } else if (verData != verM.data() || faceData != faceM.data() ||
+                   verNum != verM.rows() || faceNum != faceM.rows()) {
+            validFlags = 0;
+            verData = verM.data();
+            faceData = faceM.data();
+            verNum = verM.rows();
+            faceNum = faceM.rows();
+        }
+    }
+
+private:
+    void CopyFrom(const MeshAttributeCache &other) {
+        FaceNormalM = other.FaceNormalM;
+        FaceAreaV = other.FaceAreaV;
+        VerNormalM = other.VerNormalM;
+        Box = other.Box;
+        MassProp = other.MassProp;
+        validFlags = other.validFlags;
+        /// A copy holds the same values in matrices of its own, adopted on the first check
+        verData = nullptr;
+        faceData = nullptr;
+        verNum = other.verNum;
+        faceNum = other.faceNum;
+    }
+};
+
+
+#endif //MESHATTRIBUTECACHE_H
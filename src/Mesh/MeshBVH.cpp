@@ -0,0 +1,507 @@
+/// ========================================
+///
+///     MeshBVH.cpp
+///
+///     Bounding volume hierarchy over the
+///     faces of a mesh
+///
+/// ========================================
+
+#include "MeshBVH.h"
+
+#include <atomic>
+#include <future>
+#include <thread>
+#include <numeric>
+#include <algorithm>
+
+#include <igl/parallel_for.h>
+
+int MeshBVH::MaxLeafSize = 4;
+
+namespace {
+    const int BinNum = 16;
+    /// Ranges with more faces build a child on another thread (near the root), and the root range is
+    /// binned in parallel chunks
+    const int ParallelFaceNum = 1 << 15;
+    /// Deeper nodes are split at the median, which bounds the depth (and the traversal stacks)
+    const int MaxSAHDepth = 48;
+    const int StackSize = 128;
+
+    struct Bin {
+        Eigen::AlignedBox3d box;
+        int count = 0;
+    };
+
+    struct BinSet {
+        Bin binList[3][BinNum];
+        Eigen::AlignedBox3d box;
+        Eigen::AlignedBox3d centroidBox;
+    };
+
+    double HalfArea(const Eigen::AlignedBox3d &box) {
+        if (box.isEmpty())
+            return 0;
+        Eigen::Vector3d d = box.sizes();
+        return d.x() * d.y() + d.y() * d.z() + d.z() * d.x();
+    }
+
+    /// Entry distance of the ray into the box, false if it misses it before tMax
+    bool IntersectBox(const Eigen::AlignedBox3d &box, const Eigen::Vector3d &origin, const Eigen::Vector3d &invDir,
+                      double tMax, double &tNear) {
+        double t0 = 0;
+        double t1 = tMax;
+        for (int i = 0; i < 3; i++) {
+            double tA = (box.min()(i) - origin(i)) * invDir(i);
+            double tB = (box.max()(i) - origin(i)) * invDir(i);
+            if (tA > tB)
+                std::swap(tA, tB);
+            /// Written so that NaN (origin on a slab of a parallel ray) keeps the interval
+            t0 = tA > t0 ? tA : t0;
+            t1 = tB < t1 ? tB : t1;
+            if (t0 > t1)
+                return false;
+        }
+        tNear = t0;
+        return true;
+    }
+
+    /// Moller-Trumbore
+    bool IntersectTriangle(const Eigen::Vector3d &v0, const Eigen::Vector3d &v1, const Eigen::Vector3d &v2,
+                           const Eigen::Vector3d &origin, const Eigen::Vector3d &dir, double &t, double &u,
+                           double &v) {
+        Eigen::Vector3d e1 = v1 - v0;
+        Eigen::Vector3d e2 = v2 - v0;
+        Eigen::Vector3d p = dir.cross(e2);
+        double det = e1.dot(p);
+        if (det == 0)
+            return false;
+        double invDet = 1.0 / det;
+        Eigen::Vector3d s = origin - v0;
+        u = s.dot(p) * invDet;
+        if (u < 0 || u > 1)
+            return false;
+        Eigen::Vector3d q = s.cross(e1);
+        v = dir.dot(q) * invDet;
+        if (v < 0 || u + v > 1)
+            return false;
+        t = e2.dot(q) * invDet;
+        return true;
+    }
+
+    /// Closest point of a triangle (Ericson, Real-Time Collision Detection 5.1.5)
+    Eigen::Vector3d ClosestPointOnTriangle(const Eigen::Vector3d &p, const Eigen::Vector3d &a, const Eigen::Vector3d &b,
+                                           const Eigen::Vector3d &c) {
+        Eigen::Vector3d ab = b - a;
+        Eigen::Vector3d ac = c - a;
+        Eigen::Vector3d ap = p - a;
+        double d1 = ab.dot(ap);
+        double d2 = ac.dot(ap);
+        if (d1 <= 0 && d2 <= 0)
+            return a;
+
+        Eigen::Vector3d bp = p - b;
+        double d3 = ab.dot(bp);
+        double d4 = ac.dot(bp);
+        if (d3 >= 0 && d4 <= d3)
+            return b;
+
+        double vc = d1 * d4 - d3 * d2;
+        if (vc <= 0 && d1 >= 0 && d3 <= 0)
+            return a + d1 / (d1 - d3) * ab;
+
+        Eigen::Vector3d cp = p - c;
+        double d5 = ab.dot(cp);
+        double d6 = ac.dot(cp);
+        if (d6 >= 0 && d5 <= d6)
+            return c;
+
+        double vb = d5 * d2 - d1 * d6;
+        if (vb <= 0 && d2 >= 0 && d6 <= 0)
+            return a + d2 / (d2 - d6) * ac;
+
+        double va = d3 * d6 - d5 * d4;
+        if (va <= 0 && (d4 - d3) >= 0 && (d5 - d6) >= 0)
+            return b + (d4 - d3) / ((d4 - d3) + (d5 - d6)) * (c - b);
+
+        double denom = 1.0 / (va + vb + vc);
+        return a + ab * (vb * denom) + ac * (vc * denom);
+    }
+
+    Eigen::Vector3d GetVertex(const Eigen::MatrixX3d &verM, int verID) {
+        return verM.row(verID).transpose();
+    }
+}
+
+/// ========================================
+///                 Build
+/// ========================================
+
+struct MeshBVH::BuildContext {
+    std::vector<Eigen::AlignedBox3d> faceBoxList;
+    std::vector<Eigen::Vector3d> centroidList;
+    std::atomic<int> nodeNum{1};
+    /// Nodes above this depth fork, so that about one subtree runs per hardware thread
+    int forkDepth = 0;
+};
+
+void MeshBVH::Build(const Eigen::MatrixX3d &verM, const Eigen::MatrixX3i &faceM) {
+    int faceNum = static_cast<int>(faceM.rows());
+    nodeList.clear();
+    faceIndexList.resize(faceNum);
+    std::iota(faceIndexList.begin(), faceIndexList.end(), 0);
+    if (faceNum == 0)
+        return;
+
+    BuildContext context;
+    context.faceBoxList.resize(faceNum);
+    context.centroidList.resize(faceNum);
+    igl::parallel_for(faceNum, [&](int i) {
+        context.faceBoxList[i] = ComputeFaceBox(verM, faceM, i);
+        context.centroidList[i] = context.faceBoxList[i].center();
+    }, 1000);
+
+    /// A binary tree with leaves of at least one face has at most 2n - 1 nodes
+    nodeList.resize(2 * faceNum - 1);
+    int threadNum = std::max(1, static_cast<int>(std::thread::hardware_concurrency()));
+    while ((1 << context.forkDepth) < threadNum)
+        context.forkDepth++;
+    BuildNode(context, 0, 0, faceNum, 0);
+    nodeList.resize(context.nodeNum);
+    nodeList.shrink_to_fit();
+}
+
+void MeshBVH::BuildNode(BuildContext &context, int nodeID, int begin, int end, int depth) {
+    int faceNum = end - begin;
+
+    /// 1. Bin the faces by centroid along each axis (in parallel chunks for a large root, the other threads
+    /// are busy with the subtrees below it)
+    auto binRange = [&](int rangeBegin, int rangeEnd, BinSet &binSet, const Eigen::AlignedBox3d &centroidBox) {
+        Eigen::Array3d scale = Eigen::Array3d::Zero();
+        Eigen::Array3d extent = centroidBox.sizes().array();
+        for (int axis = 0; axis < 3; axis++)
+            scale(axis) = extent(axis) > 0 ? BinNum / extent(axis) : 0;
+        for (int i = rangeBegin; i < rangeEnd; i++) {
+            int faceID = faceIndexList[i];
+            const Eigen::Vector3d &centroid = context.centroidList[faceID];
+            for (int axis = 0; axis < 3; axis++) {
+                int binID = static_cast<int>((centroid(axis) - centroidBox.min()(axis)) * scale(axis));
+                binID = std::min(std::max(binID, 0), BinNum - 1);
+                binSet.binList[axis][binID].box.extend(context.faceBoxList[faceID]);
+                binSet.binList[axis][binID].count++;
+            }
+        }
+    };
+    auto boundRange = [&](int rangeBegin, int rangeEnd, BinSet &binSet) {
+        for (int i = rangeBegin; i < rangeEnd; i++) {
+            int faceID = faceIndexList[i];
+            binSet.box.extend(context.faceBoxList[faceID]);
+            binSet.centroidBox.extend(context.centroidList[faceID]);
+        }
+    };
+
+    BinSet binSet;
+    if (depth == 0 && faceNum > ParallelFaceNum) {
+        int chunkNum = (faceNum + ParallelFaceNum - 1) / ParallelFaceNum;
+        std::vector<BinSet> chunkList(chunkNum);
+        auto chunkRange = [&](int chunkID, int &rangeBegin, int &rangeEnd) {
+            rangeBegin = begin + chunkID * ParallelFaceNum;
+            rangeEnd = std::min(end, rangeBegin + ParallelFaceNum);
+        };
+        igl::parallel_for(chunkNum, [&](int chunkID) {
+            int rangeBegin, rangeEnd;
+            chunkRange(chunkID, rangeBegin, rangeEnd);
+            boundRange(rangeBegin, rangeEnd, chunkList[chunkID]);
+        }, 1);
+        for (const BinSet &chunk: chunkList) {
+            binSet.box.extend(chunk.box);
+            binSet.centroidBox.extend(chunk.centroidBox);
+        }
+        for (BinSet &chunk: chunkList)
+            chunk = BinSet();
+        igl::parallel_for(chunkNum, [&](int chunkID) {
+            int rangeBegin, rangeEnd;
+            chunkRange(chunkID, rangeBegin, rangeEnd);
+            binRange(rangeBegin, rangeEnd, chunkList[chunkID], binSet.centroidBox);
+        }, 1);
+        for (const BinSet &chunk: chunkList) {
+            for (int axis = 0; axis < 3; axis++) {
+                for (int binID = 0; binID < BinNum; binID++) {
+                    binSet.binList[axis][binID].box.extend(chunk.binList[axis][binID].box);
+                    binSet.binList[axis][binID].count += chunk.binList[axis][binID].count;
+                }
+            }
+        }
+    } else {
+        boundRange(begin, end, binSet);
+        if (faceNum > MaxLeafSize)
+            binRange(begin, end, binSet, binSet.centroidBox);
+    }
+
+    MeshBVHNode &node = nodeList[nodeID];
+    node.box = binSet.box;
+    if (faceNum <= MaxLeafSize) {
+        node.offset = begin;
+        node.faceNum = faceNum;
+        return;
+    }
+
+    /// 2. Find the split of the lowest surface area cost
+    int bestAxis = -1;
+    int bestBin = -1;
+    double bestCost = std::numeric_limits<double>::infinity();
+    Eigen::Vector3d centroidExtent = binSet.centroidBox.sizes();
+    for (int axis = 0; axis < 3 && depth < MaxSAHDepth; axis++) {
+        if (centroidExtent(axis) <= 0)
+            continue;
+        const Bin *binList = binSet.binList[axis];
+        double rightArea[BinNum];
+        int rightCount[BinNum];
+        Eigen::AlignedBox3d rightBox;
+        int count = 0;
+        for (int binID = BinNum - 1; binID > 0; binID--) {
+            rightBox.extend(binList[binID].box);
+            count += binList[binID].count;
+            rightArea[binID] = HalfArea(rightBox);
+            rightCount[binID] = count;
+        }
+        Eigen::AlignedBox3d leftBox;
+        count = 0;
+        for (int binID = 0; binID < BinNum - 1; binID++) {
+            leftBox.extend(binList[binID].box);
+            count += binList[binID].count;
+            if (count == 0 || rightCount[binID + 1] == 0)
+                continue;
+            double cost = HalfArea(leftBox) * count + rightArea[binID + 1] * rightCount[binID + 1];
+            if (cost < bestCost) {
+                bestCost = cost;
+                bestAxis = axis;
+                bestBin = binID;
+            }
+        }
+    }
+
+    /// Stop if splitting does not pay off (traversal cost of one face test), unless the leaf would be too large
+    double nodeArea = HalfArea(binSet.box);
+    if (bestAxis >= 0 && nodeArea > 0 && faceNum <= 4 * MaxLeafSize && faceNum * nodeArea <= nodeArea + bestCost) {
+        node.offset = begin;
+        node.faceNum = faceNum;
+        return;
+    }
+
+    /// 3. Partition the faces, or split at the median of the longest axis if binning cannot separate them
+    int mid = begin;
+    if (bestAxis >= 0) {
+        double scale = BinNum / centroidExtent(bestAxis);
+        double minValue = binSet.centroidBox.min()(bestAxis);
+        auto midIterator = std::partition(faceIndexList.begin() + begin, faceIndexList.begin() + end, [&](int faceID) {
+            int binID = static_cast<int>((context.centroidList[faceID](bestAxis) - minValue) * scale);
+            return std::min(std::max(binID, 0), BinNum - 1) <= bestBin;
+        });
+        mid = static_cast<int>(midIterator - faceIndexList.begin());
+    }
+    if (mid == begin || mid == end) {
+        int axis;
+        centroidExtent.maxCoeff(&axis);
+        mid = begin + faceNum / 2;
+        std::nth_element(faceIndexList.begin() + begin, faceIndexList.begin() + mid, faceIndexList.begin() + end,
+                         [&](int faceA, int faceB) {
+                             return context.centroidList[faceA](axis) < context.centroidList[faceB](axis);
+                         });
+    }
+
+    /// 4. Children are allocated as a pair after their parent
+    int childID = context.nodeNum.fetch_add(2);
+    node.offset = childID;
+    node.faceNum = 0;
+
+    if (depth < context.forkDepth && faceNum > ParallelFaceNum) {
+        auto leftTask = std::async(std::launch::async, [&]() {
+            BuildNode(context, childID, begin, mid, depth + 1);
+        });
+        BuildNode(context, childID + 1, mid, end, depth + 1);
+        leftTask.get();
+    } else {
+        BuildNode(context, childID, begin, mid, depth + 1);
+        BuildNode(context, childID + 1, mid, end, depth + 1);
+    }
+}
+
+void MeshBVH::Refit(const Eigen::MatrixX3d &verM, const Eigen::MatrixX3i &faceM) {
+    int nodeNum = static_cast<int>(nodeList.size());
+
+    /// Leaves in parallel, then internal nodes from the back (children always come after their parent)
+    igl::parallel_for(nodeNum, [&](int nodeID) {
+        MeshBVHNode &node = nodeList[nodeID];
+        if (!node.IsLeaf())
+            return;
+        node.box.setEmpty();
+        for (int i = node.offset; i < node.offset + node.faceNum; i++)
+            node.box.extend(ComputeFaceBox(verM, faceM, faceIndexList[i]));
+    }, 1000);
+
+    for (int nodeID = nodeNum - 1; nodeID >= 0; nodeID--) {
+        MeshBVHNode &node = nodeList[nodeID];
+        if (node.IsLeaf())
+            continue;
+        node.box = nodeList[node.offset].box;
+        node.box.extend(nodeList[node.offset + 1].box);
+    }
+}
+
+Eigen::AlignedBox3d MeshBVH::ComputeFaceBox(const Eigen::MatrixX3d &verM, const Eigen::MatrixX3i &faceM, int faceID) {
+    Eigen::AlignedBox3d box(GetVertex(verM, faceM(faceID, 0)));
+    box.extend(GetVertex(verM, faceM(faceID, 1)));
+    box.extend(GetVertex(verM, faceM(faceID, 2)));
+    return box;
+}
+
+/// ========================================
+///                Queries
+/// ========================================
+
+bool MeshBVH::IntersectRay(const Eigen::MatrixX3d &verM, const Eigen::MatrixX3i &faceM, const Eigen::Vector3d &origin,
+                           const Eigen::Vector3d &dir, MeshRayHit &hit, double tMax) const {
+    hit = MeshRayHit();
+    hit.t = tMax;
+    if (nodeList.empty())
+        return false;
+
+    Eigen::Vector3d invDir = dir.cwiseInverse();
+    double tNear;
+    if (!IntersectBox(nodeList[0].box, origin, invDir, hit.t, tNear))
+        return false;
+
+    int stack[StackSize];
+    int stackSize = 0;
+    stack[stackSize++] = 0;
+    while (stackSize > 0) {
+        const MeshBVHNode &node = nodeList[stack[--stackSize]];
+        if (node.IsLeaf()) {
+            for (int i = node.offset; i < node.offset + node.faceNum; i++) {
+                int faceID = faceIndexList[i];
+                double t, u, v;
+                if (IntersectTriangle(GetVertex(verM, faceM(faceID, 0)), GetVertex(verM, faceM(faceID, 1)),
+                                      GetVertex(verM, faceM(faceID, 2)), origin, dir, t, u, v) &&
+                    t >= 0 && t < hit.t) {
+                    hit.faceID = faceID;
+                    hit.t = t;
+                    hit.u = u;
+                    hit.v = v;
+                }
+            }
+            continue;
+        }
+
+        /// Visit the nearer child first (pushed last)
+        double tLeft, tRight;
+        bool isLeftHit = IntersectBox(nodeList[node.offset].box, origin, invDir, hit.t, tLeft);
+        bool isRightHit = IntersectBox(nodeList[node.offset + 1].box, origin, invDir, hit.t, tRight);
+        if (isLeftHit && isRightHit) {
+            bool isLeftFirst = tLeft <= tRight;
+            stack[stackSize++] = isLeftFirst ? node.offset + 1 : node.offset;
+            stack[stackSize++] = isLeftFirst ? node.offset : node.offset + 1;
+        } else if (isLeftHit) {
+            stack[stackSize++] = node.offset;
+        } else if (isRightHit) {
+            stack[stackSize++] = node.offset + 1;
+        }
+    }
+    return hit.IsHit();
+}
+
+bool MeshBVH::ComputeClosestPoint(const Eigen::MatrixX3d &verM, const Eigen::MatrixX3i &faceM,
+                                  const Eigen::Vector3d &point, MeshClosestPoint &result, double maxDistance) const {
+    result = MeshClosestPoint();
+    result.sqrDistance = maxDistance * maxDistance;
+    if (nodeList.empty() || nodeList[0].box.squaredExteriorDistance(point) > result.sqrDistance)
+        return false;
+
+    int stack[StackSize];
+    int stackSize = 0;
+    stack[stackSize++] = 0;
+    while (stackSize > 0) {
+        const MeshBVHNode &node = nodeList[stack[--stackSize]];
+        if (node.box.squaredExteriorDistance(point) > result.sqrDistance)
+            continue;
+
+        if (node.IsLeaf()) {
+            for (int i = node.offset; i < node.offset + node.faceNum; i++) {
+                int faceID = faceIndexList[i];
+                Eigen::Vector3d closestPt = ClosestPointOnTriangle(point, GetVertex(verM, faceM(faceID, 0)),
+                                                                   GetVertex(verM, faceM(faceID, 1)),
+                                                                   GetVertex(verM, faceM(faceID, 2)));
+                double sqrDistance = (closestPt - point).squaredNorm();
+                if (sqrDistance < result.sqrDistance || (result.faceID < 0 && sqrDistance <= result.sqrDistance)) {
+                    result.faceID = faceID;
+                    result.point = closestPt;
+                    result.sqrDistance = sqrDistance;
+                }
+            }
+            continue;
+        }
+
+        /// Visit the nearer child first (pushed last)
+        double dLeft = nodeList[node.offset].box.squaredExteriorDistance(point);
+        double dRight = nodeList[node.offset + 1].box.squaredExteriorDistance(point);
+        bool isLeftFirst = dLeft <= dRight;
+        stack[stackSize++] = isLeftFirst ? node.offset + 1 : node.offset;
+        stack[stackSize++] = isLeftFirst ? node.offset : node.offset + 1;
+    }
+    return result.faceID >= 0;
+}
+
+void MeshBVH::QueryBox(const Eigen::MatrixX3d &verM, const Eigen::MatrixX3i &faceM, const Eigen::AlignedBox3d &box,
+                       std::vector<int> &faceList) const {
+    faceList.clear();
+    if (nodeList.empty() || !nodeList[0].box.intersects(box))
+        return;
+
+    int stack[StackSize];
+    int stackSize = 0;
+    stack[stackSize++] = 0;
+    while (stackSize > 0) {
+        const MeshBVHNode &node = nodeList[stack[--stackSize]];
+        if (node.IsLeaf()) {
+            for (int i = node.offset; i < node.offset + node.faceNum; i++) {
+                if (ComputeFaceBox(verM, faceM, faceIndexList[i]).intersects(box))
+                    faceList.push_back(faceIndexList[i]);
+            }
+            continue;
+        }
+        if (nodeList[node.offset].box.intersects(box))
+            stack[stackSize++] = node.offset;
+        if (nodeList[node.offset + 1].box.intersects(box))
+            stack[stackSize++] = node.offset + 1;
+    }
+}
+
+/// ========================================
+///             Batched Queries
+/// ========================================
+
+void MeshBVH::IntersectRays(const Eigen::MatrixX3d &verM, const Eigen::MatrixX3i &faceM,
+                            const Eigen::MatrixX3d &originM, const Eigen::MatrixX3d &dirM,
+                            std::vector<MeshRayHit> &hitList) const {
+    hitList.resize(originM.rows());
+    igl::parallel_for(originM.rows(), [&](long i) {
+        IntersectRay(verM, faceM, originM.row(i).transpose(), dirM.row(i).transpose(), hitList[i]);
+    }, 64);
+}
+
+void MeshBVH::ComputeClosestPoints(const Eigen::MatrixX3d &verM, const Eigen::MatrixX3i &faceM,
+                                   const Eigen::MatrixX3d &pointM, std::vector<MeshClosestPoint> &resultList) const {
+    resultList.resize(pointM.rows());
+    igl::parallel_for(pointM.rows(), [&](long i) {
+        ComputeClosestPoint(verM, faceM, pointM.row(i).transpose(), resultList[i]);
+    }, 64);
+}
+
+void MeshBVH::QueryBoxes(const Eigen::MatrixX3d &verM, const Eigen::MatrixX3i &faceM,
+                         const std::vector<Eigen::AlignedBox3d> &boxList,
+                         std::vector<std::vector<int>> &faceLists) const {
+    faceLists.resize(boxList.size());
+    igl::parallel_for(static_cast<long>(boxList.size()), [&](long i) {
+        QueryBox(verM, faceM, boxList[i], faceLists[i]);
+    }, 64);
+}
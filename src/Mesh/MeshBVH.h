@@ -0,0 +1,102 @@
+/// ========================================
+///
+///     MeshBVH.h
+///
+///     Bounding volume hierarchy over the
+///     faces of a mesh
+///
+/// ========================================
+
+#ifndef MESHBVH_H
+#define MESHBVH_H
+
+#include <limits>
+#include <vector>
+#include <Eigen/Geometry>
+
+/// Nodes are stored in one flat array; the two children of a node are adjacent and always come after it
+struct MeshBVHNode {
+    Eigen::AlignedBox3d box;
+
+    /// Leaf: first entry of its faces in the face index list; internal node: index of the first child
+    int offset = 0;
+    /// Number of faces of a leaf, 0 for internal nodes
+    int faceNum = 0;
+
+    bool IsLeaf() const { return faceNum > 0; }
+};
+
+struct MeshRayHit {
+    int faceID = -1;
+    /// Ray parameter of the hit (origin + t * dir) and its barycentric coordinates in the face
+    double t = std::numeric_limits<double>::infinity();
+    double u = 0;
+    double v = 0;
+
+    bool IsHit() const { return faceID >= 0; }
+};
+
+struct MeshClosestPoint {
+    int faceID = -1;
+    Eigen::Vector3d point = Eigen::Vector3d::Zero();
+    double sqrDistance = std::numeric_limits<double>::infinity();
+};
+
+class MeshBVH {
+public:
+    /// Faces at most in a leaf (SAH may stop splitting earlier, up to 4x this size)
+    static int MaxLeafSize;
+
+private:
+    std::vector<MeshBVHNode> nodeList;
+    /// Faces ordered by leaf
+    std::vector<int> faceIndexList;
+
+public:
+    MeshBVH() = default;
+    ~MeshBVH() = default;
+
+    /// Top-down build with binned SAH; large subtrees are built in parallel
+    void Build(const Eigen::MatrixX3d &verM, const Eigen::MatrixX3i &faceM);
+    /// Recompute the boxes for moved vertices in O(n), the tree itself is kept (same faces required)
+    void Refit(const Eigen::MatrixX3d &verM, const Eigen::MatrixX3i &faceM);
+
+    bool IsEmpty() const { return nodeList.empty(); }
+    long GetFaceNum() const { return static_cast<long>(faceIndexList.size()); }
+    Eigen::AlignedBox3d GetBox() const { return nodeList.empty() ? Eigen::AlignedBox3d() : nodeList[0].box; }
+
+    const std::vector<MeshBVHNode> &GetNodeList() const { return nodeList; }
+    const std::vector<int> &GetFaceIndexList() const { return faceIndexList; }
+
+    /// Nearest hit with t in [0, tMax); verM and faceM are those the tree was built (or refit) for
+    bool IntersectRay(const Eigen::MatrixX3d &verM, const Eigen::MatrixX3i &faceM, const Eigen::Vector3d &origin,
+                      const Eigen::Vector3d &dir, MeshRayHit &hit,
+                      double tMax = std::numeric_limits<double>::infinity()) const;
+
+    /// Closest point on the faces, the search is limited to maxDistance
+    bool ComputeClosestPoint(const Eigen::MatrixX3d &verM, const Eigen::MatrixX3i &faceM, const Eigen::Vector3d &point,
+                             MeshClosestPoint &result,
+                             double maxDistance = std::numeric_limits<double>::infinity()) const;
+
+    /// Faces whose bounding box overlaps the box
+    void QueryBox(const Eigen::MatrixX3d &verM, const Eigen::MatrixX3i &faceM, const Eigen::AlignedBox3d &box,
+                  std::vector<int> &faceList) const;
+
+    /// Batched queries, one row (or box) per query, processed in parallel
+    void IntersectRays(const Eigen::MatrixX3d &verM, const Eigen::MatrixX3i &faceM, const Eigen::MatrixX3d &originM,
+                       const Eigen::MatrixX3d &dirM, std::vector<MeshRayHit> &hitList) const;
+    void ComputeClosestPoints(const Eigen::MatrixX3d &verM, const Eigen::MatrixX3i &faceM,
+                              const Eigen::MatrixX3d &pointM, std::vector<MeshClosestPoint> &resultList) const;
+    void QueryBoxes(const Eigen::MatrixX3d &verM, const Eigen::MatrixX3i &faceM,
+                    const std::vector<Eigen::AlignedBox3d> &boxList, std::vector<std::vector<int>> &faceLists) const;
+
+    /// Bounding box of a face
+    static Eigen::AlignedBox3d ComputeFaceBox(const Eigen::MatrixX3d &verM, const Eigen::MatrixX3i &faceM, int faceID);
+
+private:
+    struct BuildContext;
+    void BuildNode(BuildContext &context, int nodeID, int begin, int end, int depth);
+};
+
+
+#endif //MESHBVH_H
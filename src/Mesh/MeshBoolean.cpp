@@ -12,82 +12,640 @@
 
 #include "MeshBoolean.h"
 
+#include <atomic>
+#include <unordered_map>
+
+bool MeshBoolean::UseAABBCheck = true;
+bool MeshBoolean::UseHullCheck = false;
+bool MeshBoolean::UseLocalized = false;
+double MeshBoolean::LocalizedMaxRatio = 0.5;
+MeshCache *MeshBoolean::ResultCache = nullptr;
+int MeshBoolean::MaxToolsPerPass = 256;
+
+namespace {
+    std::atomic<long> numCall{0};
+    std::atomic<long> numExact{0};
+    std::atomic<long> numAABBSkip{0};
+    std::atomic<long> numHullSkip{0};
+    std::atomic<long> numLocalized{0};
+    std::atomic<long> numLocalizedFail{0};
+    std::atomic<long> numBatchPass{0};
+}
+
+/// ========================================
+///            Boolean Operation
+/// ========================================
+
 Mesh *MeshBoolean::MeshUnion(Mesh *meshA, Mesh *meshB) {
-    Eigen::MatrixXd V;
-    Eigen::MatrixXi F;
-    igl::copyleft::cgal::mesh_boolean(meshA->VerM, meshA->FaceM, meshB->VerM, meshB->FaceM,
-                                      igl::MESH_BOOLEAN_TYPE_UNION, V, F);
-    Mesh *mesh = new Mesh(V, F);
-    return mesh;
+    return MeshBooleanOp(meshA, meshB, igl::MESH_BOOLEAN_TYPE_UNION);
 }
 
 Mesh *MeshBoolean::MeshIntersect(Mesh *meshA, Mesh *meshB) {
-    Eigen::MatrixXd V;
-    Eigen::MatrixXi F;
-    igl::copyleft::cgal::mesh_boolean(meshA->VerM, meshA->FaceM, meshB->VerM, meshB->FaceM,
-                                      igl::MESH_BOOLEAN_TYPE_INTERSECT, V, F);
-    Mesh *mesh = new Mesh(V, F);
-    return mesh;
+    return MeshBooleanOp(meshA, meshB, igl::MESH_BOOLEAN_TYPE_INTERSECT);
 }
 
 Mesh *MeshBoolean::MeshMinus(Mesh *meshA, Mesh *meshB) {
-    Eigen::MatrixXd V;
-    Eigen::MatrixXi F;
-    igl::copyleft::cgal::mesh_boolean(meshA->VerM, meshA->FaceM, meshB->VerM, meshB->FaceM,
-                                      igl::MESH_BOOLEAN_TYPE_MINUS, V, F);
-    Mesh *mesh = new Mesh(V, F);
-    return mesh;
+    return MeshBooleanOp(meshA, meshB, igl::MESH_BOOLEAN_TYPE_MINUS);
 }
 
 Mesh *MeshBoolean::MeshXOR(Mesh *meshA, Mesh *meshB) {
-    Eigen::MatrixXd V;
-    Eigen::MatrixXi F;
-    igl::copyleft::cgal::mesh_boolean(meshA->VerM, meshA->FaceM, meshB->VerM, meshB->FaceM,
-                                      igl::MESH_BOOLEAN_TYPE_XOR, V, F);
-    Mesh *mesh = new Mesh(V, F);
-    return mesh;
+    return MeshBooleanOp(meshA, meshB, igl::MESH_BOOLEAN_TYPE_XOR);
 }
 
 Mesh *MeshBoolean::MeshResolve(Mesh *meshA, Mesh *meshB) {
+    return MeshBooleanOp(meshA, meshB, igl::MESH_BOOLEAN_TYPE_RESOLVE);
+}
+
+Mesh *MeshBoolean::MeshBooleanOp(Mesh *meshA, Mesh *meshB, igl::MeshBooleanType type) {
+    numCall++;
+
+    /// 1. Skip CGAL if the two meshes cannot touch
+    if (UseAABBCheck && !meshA->ComputeBoundingBox().intersects(meshB->ComputeBoundingBox())) {
+        numAABBSkip++;
+        return DisjointBooleanOp(meshA, meshB, type);
+    }
+    if (UseHullCheck && IsHullSeparated(meshA, meshB)) {
+        numHullSkip++;
+        return DisjointBooleanOp(meshA, meshB, type);
+    }
+
+    /// 2. Reuse the result of identical inputs
+    MeshCacheKey key;
+    if (ResultCache != nullptr) {
+        key = MeshCache::HashKey(*meshA, *meshB, type);
+        Mesh *mesh = ResultCache->Find(key);
+        if (mesh != nullptr)
+            return mesh;
+    }
+
+    /// 3. Run the exact boolean only on the overlap region, or else on the whole meshes
+    Mesh *mesh = nullptr;
+    if (UseLocalized && type != igl::MESH_BOOLEAN_TYPE_XOR && type != igl::MESH_BOOLEAN_TYPE_RESOLVE) {
+        mesh = LocalizedBooleanOp(meshA, meshB, type);
+        if (mesh != nullptr)
+            numLocalized++;
+    }
+    if (mesh == nullptr) {
+        numExact++;
+        Eigen::MatrixXd V;
+        Eigen::MatrixXi F;
+        igl::copyleft::cgal::mesh_boolean(meshA->GetVerM(), meshA->GetFaceM(), meshB->GetVerM(), meshB->GetFaceM(), type, V, F);
+        mesh = new Mesh(V, F);
+    }
+
+    if (ResultCache != nullptr)
+        ResultCache->Insert(key, *mesh);
+    return mesh;
+}
+
+Mesh *MeshBoolean::DisjointBooleanOp(Mesh *meshA, Mesh *meshB, igl::MeshBooleanType type) {
+    switch (type) {
+        case igl::MESH_BOOLEAN_TYPE_INTERSECT:
+            return new Mesh();
+        case igl::MESH_BOOLEAN_TYPE_MINUS:
+            return new Mesh(*meshA);
+        default:
+            /// Union, XOR and resolve of two disjoint meshes keep both of them untouched
+            return MeshConnect(meshA, meshB);
+    }
+}
+
+/// ========================================
+///          Many-Mesh Boolean
+/// ========================================
+
+Mesh *MeshBoolean::MeshMinusMany(Mesh *meshA, const std::vector<Mesh *> &toolList) {
+    /// 1. Drop the tools that cannot touch A
+    Eigen::AlignedBox3d boxA = meshA->ComputeBoundingBox();
+    std::vector<Mesh *> hitList;
+    for (Mesh *tool: toolList) {
+        numCall++;
+        if (UseAABBCheck && !boxA.intersects(tool->ComputeBoundingBox())) {
+            numAABBSkip++;
+            continue;
+        }
+        hitList.push_back(tool);
+    }
+    if (hitList.empty())
+        return new Mesh(*meshA);
+
+    /// 2. Order the tools cluster by cluster, so that the tools of one pass tend to be close together
+    std::vector<Mesh *> orderList;
+    for (const std::vector<int> &cluster: ClusterMeshes(hitList)) {
+        for (int i: cluster)
+            orderList.push_back(hitList[i]);
+    }
+
+    /// 3. Each pass resolves the current result with up to MaxToolsPerPass tools in one exact arrangement,
+    ///    keeping what is inside the first mesh and outside all the others; its result feeds the next pass
+    auto minusOp = [](const Eigen::Matrix<int, 1, Eigen::Dynamic> &w) -> int {
+        if (w(0) <= 0)
+            return 0;
+        for (int i = 1; i < w.size(); i++) {
+            if (w(i) > 0) return 0;
+        }
+        return 1;
+    };
+
+    size_t passSize = std::max(MaxToolsPerPass, 1);
+    Mesh *mesh = meshA;
+    for (size_t begin = 0; begin < orderList.size(); begin += passSize) {
+        size_t end = std::min(orderList.size(), begin + passSize);
+        std::vector<Mesh *> pass = {mesh};
+        pass.insert(pass.end(), orderList.begin() + begin, orderList.begin() + end);
+        Mesh *result = MultiMeshBooleanOp(pass, minusOp);
+        if (mesh != meshA)
+            delete mesh;
+        mesh = result;
+    }
+    return mesh;
+}
+
+Mesh *MeshBoolean::MeshUnionMany(const std::vector<Mesh *> &meshlist) {
+    if (meshlist.empty()) {
+        std::cout << " meshlist is Empty in 'MeshUnionMany' !" << std::endl;
+        return new Mesh();
+    }
+
+    /// Counted as the pairwise unions it replaces; joining two clusters is one of them, skipped by their boxes
+    std::vector<std::vector<int>> clusterList = ClusterMeshes(meshlist);
+    numCall += static_cast<long>(meshlist.size()) - 1;
+    numAABBSkip += static_cast<long>(clusterList.size()) - 1;
+    return UnionClusters(meshlist, clusterList);
+}
+
+Mesh *MeshBoolean::UnionClusters(const std::vector<Mesh *> &meshlist, const std::vector<std::vector<int>> &clusterList) {
+    /// 1. Meshes of different clusters cannot touch, so only the clusters need exact passes
+    std::vector<Mesh *> partList;
+    std::vector<Mesh *> resultList;
+    for (const std::vector<int> &cluster: clusterList) {
+        if (cluster.size() == 1) {
+            partList.push_back(meshlist[cluster[0]]);
+            continue;
+        }
+        std::vector<Mesh *> clusterMeshList;
+        for (int i: cluster)
+            clusterMeshList.push_back(meshlist[i]);
+        Mesh *result = MultiMeshUnion(clusterMeshList);
+        partList.push_back(result);
+        resultList.push_back(result);
+    }
+
+    /// 2. Connect the disjoint parts
+    Mesh *mesh = MeshConnect(partList);
+    for (Mesh *m: resultList)
+        delete m;
+    return mesh;
+}
+
+Mesh *MeshBoolean::MultiMeshUnion(const std::vector<Mesh *> &meshlist) {
+    /// Inside any of the meshes
+    auto unionOp = [](const Eigen::Matrix<int, 1, Eigen::Dynamic> &w) -> int {
+        for (int i = 0; i < w.size(); i++) {
+            if (w(i) > 0) return 1;
+        }
+        return 0;
+    };
+
+    /// Unite the meshes level by level, each pass taking at most MaxToolsPerPass of them,
+    /// so no arrangement grows past the limit however large the cluster is
+    size_t passSize = std::max(MaxToolsPerPass, 2);
+    std::vector<Mesh *> levelList = meshlist;
+    std::vector<char> isOwnedList(levelList.size(), 0);
+    while (levelList.size() > 1) {
+        std::vector<Mesh *> nextList;
+        std::vector<char> nextOwnedList;
+        for (size_t begin = 0; begin < levelList.size(); begin += passSize) {
+            size_t end = std::min(levelList.size(), begin + passSize);
+            if (end - begin == 1) {
+                /// A single leftover mesh moves up to the next level as it is
+                nextList.push_back(levelList[begin]);
+                nextOwnedList.push_back(isOwnedList[begin]);
+                continue;
+            }
+            std::vector<Mesh *> pass(levelList.begin() + begin, levelList.begin() + end);
+            nextList.push_back(MultiMeshBooleanOp(pass, unionOp));
+            nextOwnedList.push_back(1);
+            for (size_t i = begin; i < end; i++) {
+                if (isOwnedList[i])
+                    delete levelList[i];
+            }
+        }
+        levelList.swap(nextList);
+        isOwnedList.swap(nextOwnedList);
+    }
+    return isOwnedList[0] ? levelList[0] : new Mesh(*levelList[0]);
+}
+
+std::vector<std::vector<int>> MeshBoolean::ClusterMeshes(const std::vector<Mesh *> &meshlist) {
+    int meshNum = static_cast<int>(meshlist.size());
+    std::vector<Eigen::AlignedBox3d> boxList(meshNum);
+    igl::parallel_for(meshNum, [&](int i) {
+        boxList[i] = meshlist[i]->ComputeBoundingBox();
+    }, 16);
+
+    /// Union-find over pairs of overlapping boxes, found by sweeping along x
+    std::vector<int> parent(meshNum);
+    for (int i = 0; i < meshNum; i++)
+        parent[i] = i;
+    auto findRoot = [&](int i) {
+        while (parent[i] != i) {
+            parent[i] = parent[parent[i]];
+            i = parent[i];
+        }
+        return i;
+    };
+
+    std::vector<int> order(meshNum);
+    for (int i = 0; i < meshNum; i++)
+        order[i] = i;
+    std::sort(order.begin(), order.end(), [&](int a, int b) { return boxList[a].min().x() < boxList[b].min().x(); });
+
+    for (int a = 0; a < meshNum; a++) {
+        const Eigen::AlignedBox3d &boxA = boxList[order[a]];
+        for (int b = a + 1; b < meshNum && boxList[order[b]].min().x() <= boxA.max().x(); b++) {
+            if (boxA.intersects(boxList[order[b]]))
+                parent[findRoot(order[a])] = findRoot(order[b]);
+        }
+    }
+
+    std::vector<std::vector<int>> clusterList;
+    std::vector<int> clusterID(meshNum, -1);
+    for (int i = 0; i < meshNum; i++) {
+        int root = findRoot(i);
+        if (clusterID[root] < 0) {
+            clusterID[root] = static_cast<int>(clusterList.size());
+            clusterList.emplace_back();
+        }
+        clusterList[clusterID[root]].push_back(i);
+    }
+    return clusterList;
+}
+
+Mesh *MeshBoolean::MultiMeshBooleanOp(const std::vector<Mesh *> &meshlist,
+                                      const std::function<int(const Eigen::Matrix<int, 1, Eigen::Dynamic>)> &windingOp) {
+    numBatchPass++;
+    numExact++;
+
+    /// All the meshes are converted to exact numbers and resolved in a single arrangement
+    Mesh *allMesh = MeshConnect(meshlist);
+    Eigen::Matrix<size_t, Eigen::Dynamic, 1> sizes(meshlist.size());
+    for (int i = 0; i < meshlist.size(); i++)
+        sizes(i) = meshlist[i]->GetFaceM().rows();
+
+    /// Keep a facet if it separates an inside (1) region from an outside (0) one, facing outwards
+    std::function<int(const int, const int)> keep = [](const int outWinding, const int inWinding) -> int {
+        if (inWinding > 0 && outWinding <= 0) return 1;
+        if (inWinding <= 0 && outWinding > 0) return -1;
+        return 0;
+    };
+
     Eigen::MatrixXd V;
     Eigen::MatrixXi F;
-    igl::copyleft::cgal::mesh_boolean(meshA->VerM, meshA->FaceM, meshB->VerM, meshB->FaceM,
-                                      igl::MESH_BOOLEAN_TYPE_RESOLVE, V, F);
+    Eigen::VectorXi J;
+    igl::copyleft::cgal::mesh_boolean(allMesh->GetVerM(), allMesh->GetFaceM(), sizes, windingOp, keep, V, F, J);
+    delete allMesh;
+
     Mesh *mesh = new Mesh(V, F);
     return mesh;
 }
 
-Mesh *MeshBoolean::MeshConnect(Mesh *meshA, Mesh *meshB) {
-    Eigen::MatrixXd V;
-    Eigen::MatrixXi F;
+/// ========================================
+///            Localized Boolean
+/// ========================================
 
-    long numVerA, numVerB, numFaceA, numFaceB;
-    numVerA = meshA->VerM.rows();
-    numVerB = meshB->VerM.rows();
-    numFaceA = meshA->FaceM.rows();
-    numFaceB = meshB->FaceM.rows();
+Mesh *MeshBoolean::LocalizedBooleanOp(Mesh *meshA, Mesh *meshB, igl::MeshBooleanType type) {
+    /// Localize on the larger mesh; minus is not commutative so A always stays the large one
+    if (type != igl::MESH_BOOLEAN_TYPE_MINUS && meshB->GetFaceM().rows() > meshA->GetFaceM().rows())
+        std::swap(meshA, meshB);
+    const Eigen::MatrixX3d &VA = meshA->GetVerM();
+    const Eigen::MatrixX3i &FA = meshA->GetFaceM();
+    const Eigen::MatrixX3d &VB = meshB->GetVerM();
+    const Eigen::MatrixX3i &FB = meshB->GetFaceM();
 
-    V.resize(numVerA + numVerB, 3);
-    F.resize(numFaceA + numFaceB, 3);
+    /// 1. Split A into the faces overlapping the bounding box of B (the patch) and the untouched remainder;
+    ///    the BVH and the connectivity of A are cached on it, so the queries below cost O(patch) per call
+    Eigen::AlignedBox3d boxB = meshB->ComputeBoundingBox();
+    double tolerance = 1e-9 * boxB.diagonal().norm();
+    boxB.min().array() -= tolerance;
+    boxB.max().array() += tolerance;
 
-    V.block(0, 0, numVerA, 3) = meshA->VerM;
-    F.block(0, 0, numFaceA, 3) = meshA->FaceM;
+    std::shared_ptr<const MeshBVH> bvhA = meshA->GetBVH();
+    std::vector<int> patchFaces;
+    bvhA->QueryBox(VA, FA, boxB, patchFaces);
+    std::sort(patchFaces.begin(), patchFaces.end());
+    if (patchFaces.empty() || patchFaces.size() > LocalizedMaxRatio * FA.rows())
+        return nullptr;
+    auto isPatchFace = [&](int f) { return std::binary_search(patchFaces.begin(), patchFaces.end(), f); };
 
-    V.block(numVerA, 0, numVerB, 3) = meshB->VerM;
-    F.block(numFaceA, 0, numFaceB, 3) = meshB->FaceM.array() + numVerA;
+    /// The inside/outside tests need closed inputs: B, and A around the patch
+    std::shared_ptr<const MeshTopology> topologyA = meshA->GetTopology();
+    if (!meshB->GetTopology()->IsWatertight())
+        return nullptr;
+    for (int f: patchFaces) {
+        for (int h = 3 * f; h < 3 * f + 3; h++) {
+            if (topologyA->GetEdgeHalfEdges(topologyA->GetEdge(h)).size() != 2)
+                return nullptr;
+        }
+    }
 
-    Mesh *mesh = new Mesh(V, F);
+    /// 2. Gather the patch with compact vertex indices, followed by B
+    std::vector<int> globalVerID;
+    std::unordered_map<int, int> localVerID;
+    for (int f: patchFaces) {
+        for (int k = 0; k < 3; k++) {
+            if (localVerID.emplace(FA(f, k), static_cast<int>(globalVerID.size())).second)
+                globalVerID.push_back(FA(f, k));
+        }
+    }
+    int patchVerNum = static_cast<int>(globalVerID.size());
+    int patchFaceNum = static_cast<int>(patchFaces.size());
+
+    Eigen::MatrixXd V(patchVerNum + VB.rows(), 3);
+    Eigen::MatrixXi F(patchFaceNum + FB.rows(), 3);
+    for (int i = 0; i < patchVerNum; i++)
+        V.row(i) = VA.row(globalVerID[i]);
+    V.bottomRows(VB.rows()) = VB;
+    for (int i = 0; i < patchFaceNum; i++)
+        for (int k = 0; k < 3; k++)
+            F(i, k) = localVerID[FA(patchFaces[i], k)];
+    F.bottomRows(FB.rows()) = FB.array() + patchVerNum;
+
+    /// 3. Resolve the intersections between the patch and B with exact arithmetic
+    Eigen::MatrixXd VV;
+    Eigen::MatrixXi FF, IF;
+    Eigen::VectorXi J, IM;
+    igl::copyleft::cgal::RemeshSelfIntersectionsParam param;
+    param.stitch_all = true;
+    igl::copyleft::cgal::remesh_self_intersections(V, F, param, VV, FF, IF, J, IM);
+    if (VV.rows() < V.rows() || VV.topRows(V.rows()) != V) {
+        numLocalizedFail++;
+        return nullptr;
+    }
+    std::for_each(FF.data(), FF.data() + FF.size(), [&IM](int &a) { a = IM(a); });
+
+    /// 4. Classify the resolved faces by rays from their centroids against the BVH of the other mesh
+    std::vector<int> facesFromA, facesFromB;
+    for (int i = 0; i < FF.rows(); i++) {
+        if (J(i) < patchFaceNum) facesFromA.push_back(i);
+        else facesFromB.push_back(i);
+    }
+    auto classifyFaces = [&](const std::vector<int> &faces, const Mesh *other, std::vector<int> &sideList) {
+        other->GetBVH();
+        other->GetFaceNormals();
+        sideList.resize(faces.size());
+        igl::parallel_for(faces.size(), [&](size_t i) {
+            int f = faces[i];
+            Eigen::Vector3d centroid = (VV.row(FF(f, 0)) + VV.row(FF(f, 1)) + VV.row(FF(f, 2))).transpose() / 3.0;
+            sideList[i] = ClassifyPoint(other, centroid, tolerance);
+        }, 1000);
+    };
+    std::vector<int> sideInB, sideInA;
+    classifyFaces(facesFromA, meshB, sideInB);
+    classifyFaces(facesFromB, meshA, sideInA);
+
+    /// Centroids on the surface of the other mesh come from coplanar overlaps; leave them to the full boolean
+    if (std::count(sideInB.begin(), sideInB.end(), -1) > 0 || std::count(sideInA.begin(), sideInA.end(), -1) > 0) {
+        numLocalizedFail++;
+        return nullptr;
+    }
+
+    bool keepInsideA = (type == igl::MESH_BOOLEAN_TYPE_INTERSECT);
+    bool keepInsideB = (type == igl::MESH_BOOLEAN_TYPE_INTERSECT || type == igl::MESH_BOOLEAN_TYPE_MINUS);
+    bool flipB = (type == igl::MESH_BOOLEAN_TYPE_MINUS);
+
+    /// 5. Stitch the kept faces back into the remainder of A
+    ///    Vertex k of VV is patch vertex globalVerID[k], B vertex or new vertex appended after VA
+    auto toGlobalVerID = [&](int k) {
+        return k < patchVerNum ? globalVerID[k] : static_cast<int>(VA.rows()) + k - patchVerNum;
+    };
+
+    std::vector<Eigen::Vector3i> faceList;
+    faceList.reserve(FA.rows() - patchFaceNum + FF.rows());
+    /// Faces of A outside the bounding box of B are outside B, so only union and minus keep them
+    if (!keepInsideA) {
+        for (int f = 0, p = 0; f < FA.rows(); f++) {
+            if (p < patchFaceNum && patchFaces[p] == f) p++;
+            else faceList.emplace_back(FA(f, 0), FA(f, 1), FA(f, 2));
+        }
+    }
+    size_t resolvedStart = faceList.size();
+    for (int i = 0; i < facesFromA.size(); i++) {
+        if ((sideInB[i] == 1) != keepInsideA)
+            continue;
+        int f = facesFromA[i];
+        faceList.emplace_back(toGlobalVerID(FF(f, 0)), toGlobalVerID(FF(f, 1)), toGlobalVerID(FF(f, 2)));
+    }
+    for (int i = 0; i < facesFromB.size(); i++) {
+        if ((sideInA[i] == 1) != keepInsideB)
+            continue;
+        int f = facesFromB[i];
+        if (flipB) faceList.emplace_back(toGlobalVerID(FF(f, 0)), toGlobalVerID(FF(f, 2)), toGlobalVerID(FF(f, 1)));
+        else faceList.emplace_back(toGlobalVerID(FF(f, 0)), toGlobalVerID(FF(f, 1)), toGlobalVerID(FF(f, 2)));
+    }
+
+    /// 6. Accept the stitched result only if it is closed around the resolved faces: each of their edges has
+    ///    two faces among them and the kept faces of A next to the patch (the rest of A is left as it was)
+    std::vector<Eigen::Vector3i> localFaceList(faceList.begin() + resolvedStart, faceList.end());
+    if (!keepInsideA) {
+        std::vector<int> ringFaces;
+        for (int f: patchFaces) {
+            for (int g: topologyA->GetFaceFaces(f)) {
+                if (!isPatchFace(g))
+                    ringFaces.push_back(g);
+            }
+        }
+        std::sort(ringFaces.begin(), ringFaces.end());
+        ringFaces.erase(std::unique(ringFaces.begin(), ringFaces.end()), ringFaces.end());
+        for (int f: ringFaces)
+            localFaceList.emplace_back(FA(f, 0), FA(f, 1), FA(f, 2));
+    }
+    if (!IsClosedAround(localFaceList, static_cast<int>(faceList.size() - resolvedStart))) {
+        numLocalizedFail++;
+        return nullptr;
+    }
+
+    Eigen::MatrixXd VC(VA.rows() + VV.rows() - patchVerNum, 3);
+    VC.topRows(VA.rows()) = VA;
+    VC.bottomRows(VV.rows() - patchVerNum) = VV.bottomRows(VV.rows() - patchVerNum);
+    Eigen::MatrixXi FC(faceList.size(), 3);
+    for (int i = 0; i < faceList.size(); i++)
+        FC.row(i) = faceList[i].transpose();
+
+    Eigen::MatrixXd NV;
+    Eigen::MatrixXi NF;
+    Eigen::VectorXi I;
+    igl::remove_unreferenced(VC, FC, NV, NF, I);
+
+    Mesh *mesh = new Mesh(NV, NF);
     return mesh;
 }
 
+/// 1 inside the closed mesh, 0 outside, -1 if the point is on its surface or no ray gives a clear answer.
+/// The nearest hit along a ray is a face seen from inside if the ray leaves through it (outward normals).
+int MeshBoolean::ClassifyPoint(const Mesh *mesh, const Eigen::Vector3d &point, double tolerance) {
+    /// Fixed directions away from the axes, so that axis-aligned models do not hit edges
+    static const Eigen::Vector3d dirList[3] = {Eigen::Vector3d(0.5773, 0.5774, 0.5775).normalized(),
+                                              Eigen::Vector3d(-0.7071, 0.0213, 0.7068).normalized(),
+                                              Eigen::Vector3d(0.1409, -0.9812, 0.1317).normalized()};
+    const Eigen::MatrixX3d &faceNormalM = mesh->GetFaceNormals();
+    for (const Eigen::Vector3d &dir: dirList) {
+        MeshRayHit hit;
+        if (!mesh->IntersectRay(point, dir, hit))
+            return 0;
+        if (hit.t < tolerance)
+            return -1;
+        /// Grazing hits and hits near an edge may pick the wrong one of two faces, try another direction
+        double cosine = faceNormalM.row(hit.faceID).dot(dir);
+        const double margin = 1e-6;
+        if (std::abs(cosine) < margin || hit.u < margin || hit.v < margin || 1 - hit.u - hit.v < margin)
+            continue;
+        return cosine > 0 ? 1 : 0;
+    }
+    return -1;
+}
+
+/// Whether each edge of the first checkNum faces has exactly two faces in faceList
+bool MeshBoolean::IsClosedAround(const std::vector<Eigen::Vector3i> &faceList, int checkNum) {
+    std::unordered_map<int, int> localVerID;
+    Eigen::MatrixX3i localFaceM(faceList.size(), 3);
+    for (int i = 0; i < faceList.size(); i++) {
+        for (int k = 0; k < 3; k++)
+            localFaceM(i, k) = localVerID.emplace(faceList[i](k), static_cast<int>(localVerID.size())).first->second;
+    }
+    MeshTopology topology;
+    topology.Build(localFaceM, static_cast<int>(localVerID.size()));
+    for (int h = 0; h < 3 * checkNum; h++) {
+        if (topology.GetEdgeHalfEdges(topology.GetEdge(h)).size() != 2)
+            return false;
+    }
+    return true;
+}
+
+/// ========================================
+///            Disjoint Pre-check
+/// ========================================
+
+bool MeshBoolean::IsDisjoint(Mesh *meshA, Mesh *meshB) {
+    if (!meshA->ComputeBoundingBox().intersects(meshB->ComputeBoundingBox()))
+        return true;
+    return IsHullSeparated(meshA, meshB);
+}
+
+bool MeshBoolean::IsHullSeparated(Mesh *meshA, Mesh *meshB) {
+    /// 1. Compute the convex hulls of the two meshes
+    Eigen::MatrixXd VA, VB;
+    Eigen::MatrixXi FA, FB;
+    igl::copyleft::cgal::convex_hull(meshA->GetVerM(), VA, FA);
+    igl::copyleft::cgal::convex_hull(meshB->GetVerM(), VB, FB);
+    if (FA.rows() == 0 || FB.rows() == 0)
+        return false;
+
+    /// Gaps below the tolerance are treated as touching to stay conservative
+    Eigen::AlignedBox3d box = meshA->ComputeBoundingBox().merged(meshB->ComputeBoundingBox());
+    double tolerance = 1e-9 * box.diagonal().norm();
+
+    auto isSeparatingAxis = [&](const Eigen::Vector3d &axis) {
+        double norm = axis.norm();
+        if (norm < FLT_MIN)
+            return false;
+        Eigen::VectorXd projA = VA * (axis / norm);
+        Eigen::VectorXd projB = VB * (axis / norm);
+        return projB.minCoeff() - projA.maxCoeff() > tolerance || projA.minCoeff() - projB.maxCoeff() > tolerance;
+    };
+
+    /// 2. Test the face normals of both hulls
+    auto hasSeparatingFace = [&](const Eigen::MatrixXd &V, const Eigen::MatrixXi &F) {
+        for (int i = 0; i < F.rows(); i++) {
+            Eigen::Vector3d v0 = V.row(F(i, 0));
+            Eigen::Vector3d v1 = V.row(F(i, 1));
+            Eigen::Vector3d v2 = V.row(F(i, 2));
+            if (isSeparatingAxis((v1 - v0).cross(v2 - v0)))
+                return true;
+        }
+        return false;
+    };
+    if (hasSeparatingFace(VA, FA) || hasSeparatingFace(VB, FB))
+        return true;
+
+    /// 3. Test the cross products of hull edges (only for small hulls, since it is quadratic)
+    const long maxEdgePairNum = 100000;
+    if (9 * FA.rows() * FB.rows() > maxEdgePairNum)
+        return false;
+    for (int i = 0; i < FA.rows(); i++) {
+        for (int a = 0; a < 3; a++) {
+            Eigen::Vector3d edgeA = VA.row(FA(i, (a + 1) % 3)) - VA.row(FA(i, a));
+            for (int j = 0; j < FB.rows(); j++) {
+                for (int b = 0; b < 3; b++) {
+                    Eigen::Vector3d edgeB = VB.row(FB(j, (b + 1) % 3)) - VB.row(FB(j, b));
+                    if (isSeparatingAxis(edgeA.cross(edgeB)))
+                        return true;
+                }
+            }
+        }
+    }
+    return false;
+}
+
+/// ========================================
+///               Statistics
+/// ========================================
+
+MeshBooleanStats MeshBoolean::GetStats() {
+    MeshBooleanStats stats;
+    stats.numCall = numCall;
+    stats.numExact = numExact;
+    stats.numAABBSkip = numAABBSkip;
+    stats.numHullSkip = numHullSkip;
+    stats.numLocalized = numLocalized;
+    stats.numLocalizedFail = numLocalizedFail;
+    stats.numBatchPass = numBatchPass;
+    return stats;
+}
+
+void MeshBoolean::ResetStats() {
+    numCall = 0;
+    numExact = 0;
+    numAABBSkip = 0;
+    numHullSkip = 0;
+    numLocalized = 0;
+    numLocalizedFail = 0;
+    numBatchPass = 0;
+}
+
+/// ========================================
+///              Mesh Connect
+/// ========================================
+
+Mesh *MeshBoolean::MeshConnect(Mesh *meshA, Mesh *meshB) {
+    return MeshConnect(std::vector<Mesh *>{meshA, meshB});
+}
+
 Mesh *MeshBoolean::MeshConnect(const std::vector<Mesh *> &meshlist) {
     if (meshlist.empty()) {
         std::cout << " meshlist is Empty in 'MeshConnect' !" << std::endl;
+        return new Mesh();
     }
-    Mesh *mesh;
-    mesh = meshlist[0];
-    for (Mesh *m: meshlist) {
-        mesh = MeshConnect(mesh, m);
+
+    /// 1. Prefix-sum the vertex and face numbers to get the offset of each block
+    int meshNum = static_cast<int>(meshlist.size());
+    std::vector<long> verOffset(meshNum + 1, 0);
+    std::vector<long> faceOffset(meshNum + 1, 0);
+    for (int i = 0; i < meshNum; i++) {
+        verOffset[i + 1] = verOffset[i] + meshlist[i]->GetVerM().rows();
+        faceOffset[i + 1] = faceOffset[i] + meshlist[i]->GetFaceM().rows();
     }
+
+    /// 2. Allocate the connected mesh once and copy the blocks in parallel
+    Mesh *mesh = new Mesh();
+    Eigen::MatrixX3d &verM = mesh->EditVerM();
+    Eigen::MatrixX3i &faceM = mesh->EditFaceM();
+    verM.resize(verOffset[meshNum], 3);
+    faceM.resize(faceOffset[meshNum], 3);
+    igl::parallel_for(meshNum, [&](int i) {
+        const Mesh *m = meshlist[i];
+        verM.middleRows(verOffset[i], m->GetVerM().rows()) = m->GetVerM();
+        faceM.middleRows(faceOffset[i], m->GetFaceM().rows()) = m->GetFaceM().array() + static_cast<int>(verOffset[i]);
+    }, 4);
     return mesh;
-}
\ No newline at end of file
+}
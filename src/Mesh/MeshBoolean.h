@@ -13,11 +13,42 @@
 #ifndef MESHBOOLEAN_H
 #define MESHBOOLEAN_H
 
+#include <functional>
+
 #include <igl/copyleft/cgal/mesh_boolean.h>
+#include <igl/copyleft/cgal/remesh_self_intersections.h>
+#include <igl/remove_unreferenced.h>
+#include <igl/parallel_for.h>
 
 #include "Mesh/Mesh.h"
+#include "Mesh/MeshCache.h"
+
+/// Counters of the boolean calls and of the shortcuts that skipped CGAL
+struct MeshBooleanStats {
+    long numCall = 0;           // all boolean calls
+    long numExact = 0;          // calls that ran the exact CGAL pipeline
+    long numAABBSkip = 0;       // calls skipped since the bounding boxes are disjoint
+    long numHullSkip = 0;       // calls skipped since a separating axis between the convex hulls is found
+    long numLocalized = 0;      // calls that only sent the overlap region to CGAL
+    long numLocalizedFail = 0;  // localized calls that failed the check and reran the full boolean
+    long numBatchPass = 0;      // exact passes run by the many-mesh operations
+};
 
 class MeshBoolean {
+public:
+    /// Skip CGAL when the bounding boxes of the two meshes are disjoint
+    static bool UseAABBCheck;
+    /// Skip CGAL when the convex hulls of the two meshes are separated (costs two hulls per call)
+    static bool UseHullCheck;
+    /// Only send the faces of the larger mesh that overlap the smaller one to CGAL (union, intersect and minus)
+    static bool UseLocalized;
+    /// Localize only if the overlap region holds less than this ratio of the faces of the larger mesh
+    static double LocalizedMaxRatio;
+    /// Reuse the results of identical inputs (nullptr to disable; not owned)
+    static MeshCache *ResultCache;
+    /// Maximum number of meshes resolved together in one exact pass of the many-mesh operations
+    static int MaxToolsPerPass;
+
 public:
     MeshBoolean() = default;
     ~MeshBoolean() = default;
@@ -28,8 +59,36 @@ public:
     static Mesh *MeshXOR(Mesh *meshA, Mesh *meshB);
     static Mesh *MeshResolve(Mesh *meshA, Mesh *meshB);
 
+    /// Subtract/unite many meshes in as few exact passes as possible; MeshMinusMany subtracts up to
+    /// MaxToolsPerPass tools from meshA in each pass, the result of a pass being the input of the next
+    static Mesh *MeshMinusMany(Mesh *meshA, const std::vector<Mesh *> &toolList);
+    static Mesh *MeshUnionMany(const std::vector<Mesh *> &meshlist);
+
     static Mesh *MeshConnect(Mesh *meshA, Mesh *meshB);
     static Mesh *MeshConnect(const std::vector<Mesh *> &meshlist);
+
+    /// Conservative test: true only if meshA and meshB cannot touch
+    static bool IsDisjoint(Mesh *meshA, Mesh *meshB);
+
+    /// Statistics
+    static MeshBooleanStats GetStats();
+    static void ResetStats();
+
+private:
+    static Mesh *MeshBooleanOp(Mesh *meshA, Mesh *meshB, igl::MeshBooleanType type);
+    static Mesh *DisjointBooleanOp(Mesh *meshA, Mesh *meshB, igl::MeshBooleanType type);
+
+    static bool IsHullSeparated(Mesh *meshA, Mesh *meshB);
+
+    static Mesh *LocalizedBooleanOp(Mesh *meshA, Mesh *meshB, igl::MeshBooleanType type);
+    static int ClassifyPoint(const Mesh *mesh, const Eigen::Vector3d &point, double tolerance);
+    static bool IsClosedAround(const std::vector<Eigen::Vector3i> &faceList, int checkNum);
+
+    static std::vector<std::vector<int>> ClusterMeshes(const std::vector<Mesh *> &meshlist);
+    static Mesh *UnionClusters(const std::vector<Mesh *> &meshlist, const std::vector<std::vector<int>> &clusterList);
+    static Mesh *MultiMeshUnion(const std::vector<Mesh *> &meshlist);
+    static Mesh *MultiMeshBooleanOp(const std::vector<Mesh *> &meshlist,
+                                    const std::function<int(const Eigen::Matrix<int, 1, Eigen::Dynamic>)> &windingOp);
 };
 
 
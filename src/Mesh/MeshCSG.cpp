@@ -0,0 +1,332 @@
+/// ========================================
+///
+///     MeshCSG.cpp
+///
+///     CSG expression DAG over mesh booleans
+///
+/// ========================================
+
+#include "MeshCSG.h"
+
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <exception>
+#include <functional>
+#include <condition_variable>
+
+namespace {
+    /// Workers shared by all evaluations, started on first use. As for the pool of MeshLOD, it is never
+    /// destroyed, so the detached workers can outlive static destruction at exit.
+    class TaskPool {
+    private:
+        std::mutex mutex;
+        std::condition_variable condition;
+        std::deque<std::function<void()>> taskQueue;
+        int workerNum;
+
+    public:
+        TaskPool() {
+            workerNum = std::max(1, static_cast<int>(std::thread::hardware_concurrency()));
+            for (int i = 0; i < workerNum; i++)
+                std::thread([this] { Run(); }).detach();
+        }
+
+        int GetWorkerNum() const { return workerNum; }
+
+        void Push(std::function<void()> task) {
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                taskQueue.emplace_back(std::move(task));
+            }
+            condition.notify_one();
+        }
+
+    private:
+        void Run() {
+            while (true) {
+                std::function<void()> task;
+                {
+                    std::unique_lock<std::mutex> lock(mutex);
+                    condition.wait(lock, [this] { return !taskQueue.empty(); });
+                    task = std::move(taskQueue.front());
+                    taskQueue.pop_front();
+                }
+                task();
+            }
+        }
+    };
+
+    TaskPool &GetTaskPool() {
+        static TaskPool *pool = new TaskPool();
+        return *pool;
+    }
+}
+
+/// Scheduling state of one evaluation, shared with its tasks on the pool
+struct MeshCSG::EvaluateState {
+    std::mutex mutex;
+    std::condition_variable condition;
+
+    int root = -1;
+    std::vector<Mesh *> resultList;
+    /// Operands not evaluated yet, and operations still to read each result
+    std::vector<int> pendingNum;
+    std::vector<int> consumerNum;
+    std::vector<std::vector<int>> parentList;
+    std::vector<int> readyList;
+
+    int runningNum = 0;
+    int maxRunningNum = 1;
+    bool isFinished = false;
+    std::exception_ptr exception = nullptr;
+
+    int resultNum = 0;
+    MeshCSGStats stats;
+};
+
+/// ========================================
+///           Build the Expression
+/// ========================================
+
+int MeshCSG::AddMesh(Mesh *mesh) {
+    auto iterator = leafMap.find(mesh);
+    if (iterator != leafMap.end())
+        return iterator->second;
+
+    CSGNode node;
+    node.op = CSG_LEAF;
+    node.mesh = mesh;
+    nodeList.emplace_back(node);
+
+    int id = static_cast<int>(nodeList.size()) - 1;
+    leafMap[mesh] = id;
+    return id;
+}
+
+int MeshCSG::Union(int nodeA, int nodeB) {
+    return AddNode(CSG_UNION, nodeA, nodeB);
+}
+
+int MeshCSG::Intersect(int nodeA, int nodeB) {
+    return AddNode(CSG_INTERSECT, nodeA, nodeB);
+}
+
+int MeshCSG::Minus(int nodeA, int nodeB) {
+    return AddNode(CSG_MINUS, nodeA, nodeB);
+}
+
+int MeshCSG::XOR(int nodeA, int nodeB) {
+    return AddNode(CSG_XOR, nodeA, nodeB);
+}
+
+int MeshCSG::Connect(int nodeA, int nodeB) {
+    return AddNode(CSG_CONNECT, nodeA, nodeB);
+}
+
+int MeshCSG::Union(const std::vector<int> &nodes) {
+    return AddNodes(CSG_UNION, nodes, 0, static_cast<int>(nodes.size()));
+}
+
+int MeshCSG::Connect(const std::vector<int> &nodes) {
+    return AddNodes(CSG_CONNECT, nodes, 0, static_cast<int>(nodes.size()));
+}
+
+int MeshCSG::AddNode(CSGOperation op, int nodeA, int nodeB) {
+    if (nodeA < 0 || nodeA >= nodeList.size() || nodeB < 0 || nodeB >= nodeList.size()) {
+        std::cout << "Invalid node id in 'MeshCSG::AddNode' !" << std::endl;
+        return -1;
+    }
+
+    /// Commutative operations share one key for both operand orders
+    if (op == CSG_UNION || op == CSG_INTERSECT || op == CSG_XOR) {
+        if (nodeA > nodeB) std::swap(nodeA, nodeB);
+    }
+
+    std::tuple<int, int, int> key(op, nodeA, nodeB);
+    auto iterator = nodeMap.find(key);
+    if (iterator != nodeMap.end())
+        return iterator->second;
+
+    CSGNode node;
+    node.op = op;
+    node.childA = nodeA;
+    node.childB = nodeB;
+    nodeList.emplace_back(node);
+
+    int id = static_cast<int>(nodeList.size()) - 1;
+    nodeMap[key] = id;
+    return id;
+}
+
+int MeshCSG::AddNodes(CSGOperation op, const std::vector<int> &nodes, int begin, int end) {
+    /// Build a balanced tree so that the two halves can be evaluated concurrently
+    if (end - begin <= 0) {
+        std::cout << " nodes is Empty in 'MeshCSG::AddNodes' !" << std::endl;
+        return -1;
+    }
+    if (end - begin == 1)
+        return nodes[begin];
+
+    int mid = (begin + end) / 2;
+    return AddNode(op, AddNodes(op, nodes, begin, mid), AddNodes(op, nodes, mid, end));
+}
+
+/// ========================================
+///         Evaluate the Expression
+/// ========================================
+
+Mesh *MeshCSG::Evaluate(int root, int threadNum, MeshCSGStats *stats) const {
+    if (root < 0 || root >= nodeList.size()) {
+        std::cout << "Invalid root id in 'MeshCSG::Evaluate' !" << std::endl;
+        return nullptr;
+    }
+    if (stats != nullptr)
+        *stats = MeshCSGStats();
+    if (nodeList[root].op == CSG_LEAF)
+        return new Mesh(*nodeList[root].mesh);
+
+    /// 1. Collect the nodes reachable from the root and count their consumers
+    int nodeNum = static_cast<int>(nodeList.size());
+    auto state = std::make_shared<EvaluateState>();
+    state->root = root;
+    state->resultList.assign(nodeNum, nullptr);
+    state->pendingNum.assign(nodeNum, 0);
+    state->consumerNum.assign(nodeNum, 0);
+    state->parentList.resize(nodeNum);
+
+    std::vector<char> isReachable(nodeNum, 0);
+    std::vector<int> stack = {root};
+    isReachable[root] = 1;
+    while (!stack.empty()) {
+        int id = stack.back();
+        stack.pop_back();
+        const CSGNode &node = nodeList[id];
+        if (node.op == CSG_LEAF)
+            continue;
+        for (int child: {node.childA, node.childB}) {
+            state->consumerNum[child]++;
+            std::vector<int> &parents = state->parentList[child];
+            if (parents.empty() || parents.back() != id)
+                parents.push_back(id);
+            if (!isReachable[child]) {
+                isReachable[child] = 1;
+                stack.push_back(child);
+            }
+        }
+    }
+
+    /// 2. Leaves are ready at once; an operation is ready when both of its operands are
+    for (int id = 0; id < nodeNum; id++) {
+        if (!isReachable[id])
+            continue;
+        const CSGNode &node = nodeList[id];
+        if (node.op == CSG_LEAF) {
+            state->resultList[id] = node.mesh;
+        } else {
+            /// A node using the same operand twice only waits for it once
+            state->pendingNum[id] = (nodeList[node.childA].op == CSG_LEAF ? 0 : 1) +
+                                    (nodeList[node.childB].op == CSG_LEAF || node.childB == node.childA ? 0 : 1);
+            if (state->pendingNum[id] == 0)
+                state->readyList.push_back(id);
+        }
+    }
+
+    /// 3. Hand the ready operations to the pool; each finished one releases its parents. The leaves may be
+    /// read by several workers at once, which the const members of Mesh (and its copy) allow.
+    std::unique_lock<std::mutex> lock(state->mutex);
+    state->maxRunningNum = threadNum > 0 ? threadNum : GetTaskPool().GetWorkerNum();
+    DispatchNodes(state);
+    state->condition.wait(lock, [&]() { return state->isFinished && state->runningNum == 0; });
+
+    if (stats != nullptr)
+        *stats = state->stats;
+    if (state->exception) {
+        for (int id = 0; id < nodeNum; id++) {
+            if (nodeList[id].op != CSG_LEAF)
+                delete state->resultList[id];
+        }
+        /// Taken out of the state, which the last task may still be releasing
+        std::exception_ptr exception = std::move(state->exception);
+        std::rethrow_exception(exception);
+    }
+    return state->resultList[root];
+}
+
+/// Start ready operations while fewer than maxRunningNum are running (the caller holds state->mutex)
+void MeshCSG::DispatchNodes(const std::shared_ptr<EvaluateState> &state) const {
+    while (!state->isFinished && state->runningNum < state->maxRunningNum && !state->readyList.empty()) {
+        int id = state->readyList.back();
+        state->readyList.pop_back();
+        state->runningNum++;
+        GetTaskPool().Push([this, state, id]() { RunNode(state, id); });
+    }
+}
+
+/// Task of one operation; its operands were stored before it was dispatched, so they are read unlocked
+void MeshCSG::RunNode(const std::shared_ptr<EvaluateState> &state, int id) const {
+    const CSGNode &node = nodeList[id];
+    Mesh *mesh = nullptr;
+    std::exception_ptr exception = nullptr;
+    try {
+        mesh = EvaluateNode(node, state->resultList[node.childA], state->resultList[node.childB]);
+    } catch (...) {
+        exception = std::current_exception();
+    }
+
+    std::lock_guard<std::mutex> lock(state->mutex);
+    state->runningNum--;
+    state->stats.numEvaluate++;
+    if (exception) {
+        if (!state->exception)
+            state->exception = exception;
+        /// Dropped under the lock: Evaluate may rethrow and destroy the exception as soon as it is released
+        exception = nullptr;
+        state->isFinished = true;
+    } else if (state->isFinished) {
+        /// Another operation failed meanwhile
+        delete mesh;
+    } else {
+        state->resultList[id] = mesh;
+        state->resultNum++;
+        state->stats.numPeakResult = std::max(state->stats.numPeakResult, state->resultNum);
+
+        /// Release the intermediate operands as soon as their last consumer is done
+        for (int child: {node.childA, node.childB}) {
+            if (--state->consumerNum[child] == 0 && nodeList[child].op != CSG_LEAF) {
+                delete state->resultList[child];
+                state->resultList[child] = nullptr;
+                state->resultNum--;
+            }
+        }
+
+        if (id == state->root) {
+            state->isFinished = true;
+        } else {
+            for (int parent: state->parentList[id]) {
+                if (--state->pendingNum[parent] == 0)
+                    state->readyList.push_back(parent);
+            }
+            DispatchNodes(state);
+        }
+    }
+    /// Evaluate may return as soon as the lock is released, this task touches nothing of it after that
+    state->condition.notify_all();
+}
+
+Mesh *MeshCSG::EvaluateNode(const CSGNode &node, Mesh *meshA, Mesh *meshB) const {
+    switch (node.op) {
+        case CSG_UNION:
+            return MeshBoolean::MeshUnion(meshA, meshB);
+        case CSG_INTERSECT:
+            return MeshBoolean::MeshIntersect(meshA, meshB);
+        case CSG_MINUS:
+            return MeshBoolean::MeshMinus(meshA, meshB);
+        case CSG_XOR:
+            return MeshBoolean::MeshXOR(meshA, meshB);
+        case CSG_CONNECT:
+            return MeshBoolean::MeshConnect(meshA, meshB);
+        default:
+            return new Mesh(*node.mesh);
+    }
+}
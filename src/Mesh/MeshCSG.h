@@ -0,0 +1,86 @@
+/// ========================================
+///
+///     MeshCSG.h
+///
+///     CSG expression DAG over mesh booleans
+///
+/// ========================================
+
+#ifndef MESHCSG_H
+#define MESHCSG_H
+
+#include <map>
+#include <tuple>
+#include <memory>
+
+#include "Mesh/MeshBoolean.h"
+
+enum CSGOperation {
+    CSG_LEAF,
+    CSG_UNION,
+    CSG_INTERSECT,
+    CSG_MINUS,
+    CSG_XOR,
+    CSG_CONNECT
+};
+
+/// Counters of one evaluation
+struct MeshCSGStats {
+    int numEvaluate = 0;        // operations run (each shared sub-expression once)
+    int numPeakResult = 0;      // intermediate meshes held at the same time, at most
+};
+
+class MeshCSG {
+protected:
+    struct CSGNode {
+        CSGOperation op = CSG_LEAF;
+        int childA = -1;
+        int childB = -1;
+        Mesh *mesh = nullptr;   // input mesh of a leaf (not owned)
+    };
+
+private:
+    std::vector<CSGNode> nodeList;
+
+    /// Identical sub-expressions are mapped to the same node
+    std::map<Mesh *, int> leafMap;
+    std::map<std::tuple<int, int, int>, int> nodeMap;
+
+public:
+    MeshCSG() = default;
+    virtual ~MeshCSG() = default;
+
+    /// Build the expression (each call returns a node id; the input meshes are not owned)
+    int AddMesh(Mesh *mesh);
+    int Union(int nodeA, int nodeB);
+    int Intersect(int nodeA, int nodeB);
+    int Minus(int nodeA, int nodeB);
+    int XOR(int nodeA, int nodeB);
+    int Connect(int nodeA, int nodeB);
+
+    int Union(const std::vector<int> &nodes);
+    int Connect(const std::vector<int> &nodes);
+
+    int GetNodeNum() const { return static_cast<int>(nodeList.size()); }
+
+    /// Evaluate the expression rooted at a node; the caller owns the returned mesh.
+    /// Independent subtrees run concurrently on a shared pool of workers, at most threadNum of them at a
+    /// time (0 for all cores); an exception thrown by an operation is rethrown here once the others are done.
+    Mesh *Evaluate(int root, int threadNum = 0, MeshCSGStats *stats = nullptr) const;
+
+protected:
+    /// One operation on the results of the operands (overridden by the tests to inject failures)
+    virtual Mesh *EvaluateNode(const CSGNode &node, Mesh *meshA, Mesh *meshB) const;
+
+private:
+    struct EvaluateState;
+
+    int AddNode(CSGOperation op, int nodeA, int nodeB);
+    int AddNodes(CSGOperation op, const std::vector<int> &nodes, int begin, int end);
+
+    void RunNode(const std::shared_ptr<EvaluateState> &state, int id) const;
+    void DispatchNodes(const std::shared_ptr<EvaluateState> &state) const;
+};
+
+
+#endif //MESHCSG_H
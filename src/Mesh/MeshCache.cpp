@@ -0,0 +1,241 @@
+/// ========================================
+///
+///     MeshCache.cpp
+///
+///     Content-hashed cache of boolean results
+///
+/// ========================================
+
+#include "MeshCache.h"
+
+#include <cstring>
+#include <algorithm>
+
+namespace {
+    /// Bumped whenever the key or the layout changes, so that older entries are ignored
+    const char CacheMagic[4] = {'M', 'B', 'C', '3'};
+    /// Seed of the second hash of the key
+    const uint64_t CheckSeed = 0x2545F4914F6CDD1DULL;
+}
+
+MeshCache::MeshCache(size_t memoryBudget, const std::string &diskDir) : memoryBudget(memoryBudget) {
+    SetDiskDir(diskDir);
+}
+
+/// ========================================
+///                 Hash
+/// ========================================
+
+uint64_t MeshCache::HashMesh(const Mesh &mesh, uint64_t seed) {
+    const Eigen::MatrixX3d &verM = mesh.GetVerM();
+    const Eigen::MatrixX3i &faceM = mesh.GetFaceM();
+    uint64_t h = HashBytes(verM.data(), verM.size() * sizeof(double), seed ^ verM.rows());
+    return HashBytes(faceM.data(), faceM.size() * sizeof(int), h ^ faceM.rows());
+}
+
+MeshCacheKey MeshCache::HashKey(const Mesh &meshA, const Mesh &meshB, int operation) {
+    MeshCacheKey key;
+    key.hash = HashCombine(HashCombine(HashMesh(meshA), HashMesh(meshB)), static_cast<uint64_t>(operation));
+    key.checkHash = HashCombine(HashCombine(HashMesh(meshA, CheckSeed), HashMesh(meshB, CheckSeed)),
+                                static_cast<uint64_t>(operation));
+    key.sizeList[0] = meshA.GetVerM().rows();
+    key.sizeList[1] = meshA.GetFaceM().rows();
+    key.sizeList[2] = meshB.GetVerM().rows();
+    key.sizeList[3] = meshB.GetFaceM().rows();
+    key.sizeList[4] = operation;
+    return key;
+}
+
+/// ========================================
+///             Find and Insert
+/// ========================================
+
+Mesh *MeshCache::Find(const MeshCacheKey &key) {
+    std::string dir;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+
+        /// 1. Memory tier
+        auto iterator = entryMap.find(key.hash);
+        if (iterator != entryMap.end() && iterator->second->key == key) {
+            entryList.splice(entryList.begin(), entryList, iterator->second);
+            stats.numHit++;
+            return new Mesh(iterator->second->VerM, iterator->second->FaceM);
+        }
+        dir = diskDir;
+    }
+
+    /// 2. Disk tier (promoted to memory on a hit)
+    Eigen::MatrixX3d verM;
+    Eigen::MatrixX3i faceM;
+    bool isDiskHit = !dir.empty() && ReadDisk(dir, key, verM, faceM);
+
+    std::lock_guard<std::mutex> lock(mutex);
+    if (!isDiskHit) {
+        stats.numMiss++;
+        return nullptr;
+    }
+    stats.numDiskHit++;
+    InsertMemory(key, verM, faceM);
+    return new Mesh(verM, faceM);
+}
+
+void MeshCache::Insert(const MeshCacheKey &key, const Mesh &mesh) {
+    std::string dir;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        InsertMemory(key, mesh.GetVerM(), mesh.GetFaceM());
+        dir = diskDir;
+    }
+    if (!dir.empty())
+        WriteDisk(dir, key, mesh.GetVerM(), mesh.GetFaceM());
+}
+
+/// An entry with the same hash is replaced (it is either the same result or a collision)
+void MeshCache::InsertMemory(const MeshCacheKey &key, const Eigen::MatrixX3d &verM, const Eigen::MatrixX3i &faceM) {
+    auto iterator = entryMap.find(key.hash);
+    if (iterator != entryMap.end()) {
+        stats.memoryBytes -= iterator->second->bytes;
+        entryList.erase(iterator->second);
+        entryMap.erase(iterator);
+    }
+
+    size_t bytes = verM.size() * sizeof(double) + faceM.size() * sizeof(int);
+    if (bytes > memoryBudget)
+        return;
+
+    entryList.push_front({key, verM, faceM, bytes});
+    entryMap[key.hash] = entryList.begin();
+    stats.memoryBytes += bytes;
+    EvictToBudget();
+}
+
+void MeshCache::EvictToBudget() {
+    while (stats.memoryBytes > memoryBudget && !entryList.empty()) {
+        const CacheEntry &entry = entryList.back();
+        stats.memoryBytes -= entry.bytes;
+        entryMap.erase(entry.key.hash);
+        entryList.pop_back();
+        stats.numEviction++;
+    }
+}
+
+void MeshCache::Clear() {
+    std::lock_guard<std::mutex> lock(mutex);
+    entryList.clear();
+    entryMap.clear();
+    stats.memoryBytes = 0;
+}
+
+/// ========================================
+///               Settings
+/// ========================================
+
+void MeshCache::SetMemoryBudget(size_t budget) {
+    std::lock_guard<std::mutex> lock(mutex);
+    memoryBudget = budget;
+    EvictToBudget();
+}
+
+void MeshCache::SetDiskDir(const std::string &dir) {
+    std::lock_guard<std::mutex> lock(mutex);
+    diskDir = dir;
+    if (diskDir.empty())
+        return;
+
+    std::error_code error;
+    std::filesystem::create_directories(diskDir, error);
+    if (error) {
+        std::cout << "Cannot create the cache directory: " << diskDir << std::endl;
+        diskDir.clear();
+    }
+}
+
+MeshCacheStats MeshCache::GetStats() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return stats;
+}
+
+/// ========================================
+///               Disk Tier
+/// ========================================
+
+std::filesystem::path MeshCache::GetDiskPath(const std::string &dir, const MeshCacheKey &key) {
+    char name[32];
+    snprintf(name, sizeof(name), "%016llx.mbc", static_cast<unsigned long long>(key.hash));
+    return std::filesystem::path(dir) / name;
+}
+
+/// Layout: magic, key, vertex and face numbers, vertices, faces. The numbers must match the file size and
+/// the faces must index the vertices, so that a damaged file is ignored instead of trusted.
+bool MeshCache::ReadDisk(const std::string &dir, const MeshCacheKey &key, Eigen::MatrixX3d &verM,
+                         Eigen::MatrixX3i &faceM) {
+    std::filesystem::path path = GetDiskPath(dir, key);
+    std::error_code error;
+    uintmax_t fileSize = std::filesystem::file_size(path, error);
+    if (error)
+        return false;
+    std::ifstream file(path, std::ios::binary);
+    if (!file.is_open())
+        return false;
+
+    char magic[4];
+    MeshCacheKey fileKey;
+    int64_t verNum, faceNum;
+    file.read(magic, 4);
+    file.read(reinterpret_cast<char *>(&fileKey.hash), sizeof(fileKey.hash));
+    file.read(reinterpret_cast<char *>(&fileKey.checkHash), sizeof(fileKey.checkHash));
+    file.read(reinterpret_cast<char *>(fileKey.sizeList), sizeof(fileKey.sizeList));
+    file.read(reinterpret_cast<char *>(&verNum), sizeof(verNum));
+    file.read(reinterpret_cast<char *>(&faceNum), sizeof(faceNum));
+    if (!file || std::memcmp(magic, CacheMagic, 4) != 0 || !(fileKey == key))
+        return false;
+
+    uintmax_t headerSize = 4 + 2 * sizeof(uint64_t) + sizeof(fileKey.sizeList) + 2 * sizeof(int64_t);
+    uintmax_t dataSize = fileSize - headerSize;
+    if (verNum < 0 || faceNum < 0 || static_cast<uintmax_t>(verNum) > dataSize / (3 * sizeof(double)) ||
+        static_cast<uintmax_t>(faceNum) > dataSize / (3 * sizeof(int)) ||
+        verNum * 3 * sizeof(double) + faceNum * 3 * sizeof(int) != dataSize)
+        return false;
+
+    verM.resize(verNum, 3);
+    faceM.resize(faceNum, 3);
+    file.read(reinterpret_cast<char *>(verM.data()), static_cast<std::streamsize>(verM.size() * sizeof(double)));
+    file.read(reinterpret_cast<char *>(faceM.data()), static_cast<std::streamsize>(faceM.size() * sizeof(int)));
+    if (!file)
+        return false;
+    return faceM.size() == 0 || (faceM.minCoeff() >= 0 && faceM.maxCoeff() < verNum);
+}
+
+void MeshCache::WriteDisk(const std::string &dir, const MeshCacheKey &key, const Eigen::MatrixX3d &verM,
+                          const Eigen::MatrixX3i &faceM) {
+    /// Write to a temporary file of this writer first, so that a concurrent reader (or writer, in this or
+    /// another process) never sees a partial entry
+    std::filesystem::path path = GetDiskPath(dir, key);
+    std::filesystem::path tmpPath = GetUniqueTempPath(path.string());
+    bool isWritten;
+    {
+        std::ofstream file(tmpPath, std::ios::binary);
+        if (!file.is_open())
+            return;
+
+        int64_t verNum = verM.rows();
+        int64_t faceNum = faceM.rows();
+        file.write(CacheMagic, 4);
+        file.write(reinterpret_cast<const char *>(&key.hash), sizeof(key.hash));
+        file.write(reinterpret_cast<const char *>(&key.checkHash), sizeof(key.checkHash));
+        file.write(reinterpret_cast<const char *>(key.sizeList), sizeof(key.sizeList));
+        file.write(reinterpret_cast<const char *>(&verNum), sizeof(verNum));
+        file.write(reinterpret_cast<const char *>(&faceNum), sizeof(faceNum));
+        file.write(reinterpret_cast<const char *>(verM.data()), static_cast<std::streamsize>(verM.size() * sizeof(double)));
+        file.write(reinterpret_cast<const char *>(faceM.data()), static_cast<std::streamsize>(faceM.size() * sizeof(int)));
+        file.close();
+        isWritten = static_cast<bool>(file);
+    }
+
+    std::error_code error;
+    if (isWritten)
+        std::filesystem::rename(tmpPath, path, error);
+    if (!isWritten || error)
+        std::filesystem::remove(tmpPath, error);
+}
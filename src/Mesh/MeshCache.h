@@ -0,0 +1,93 @@
+/// ========================================
+///
+///     MeshCache.h
+///
+///     Content-hashed cache of boolean results
+///
+/// ========================================
+
+#ifndef MESHCACHE_H
+#define MESHCACHE_H
+
+#include <list>
+#include <mutex>
+#include <cstdint>
+#include <filesystem>
+#include <unordered_map>
+
+#include "Mesh/Mesh.h"
+
+/// Counters of the cache
+struct MeshCacheStats {
+    long numHit = 0;            // lookups served from memory
+    long numDiskHit = 0;        // lookups served from the disk directory
+    long numMiss = 0;           // lookups that found nothing
+    long numEviction = 0;       // entries dropped from memory to stay within the budget
+    size_t memoryBytes = 0;     // bytes currently held in memory
+};
+
+/// Key of a boolean result: hash is used for the lookup; a second, independent hash and the sizes of the
+/// inputs are compared on every hit, so that a collision of the first hash does not return a wrong result
+struct MeshCacheKey {
+    uint64_t hash = 0;
+    uint64_t checkHash = 0;
+    /// Vertices and faces of A and B, and the operation
+    int64_t sizeList[5] = {0, 0, 0, 0, 0};
+
+    bool operator==(const MeshCacheKey &other) const {
+        return hash == other.hash && checkHash == other.checkHash &&
+               std::equal(sizeList, sizeList + 5, other.sizeList);
+    }
+};
+
+class MeshCache {
+private:
+    struct CacheEntry {
+        MeshCacheKey key;
+        Eigen::MatrixX3d VerM;
+        Eigen::MatrixX3i FaceM;
+        size_t bytes;
+    };
+
+    /// Most recently used entries first
+    std::list<CacheEntry> entryList;
+    std::unordered_map<uint64_t, std::list<CacheEntry>::iterator> entryMap;
+
+    size_t memoryBudget;
+    std::string diskDir;
+
+    MeshCacheStats stats;
+    mutable std::mutex mutex;
+
+public:
+    /// memoryBudget: maximum bytes of results kept in memory
+    /// diskDir: directory of the on-disk tier (empty to disable it)
+    explicit MeshCache(size_t memoryBudget = 256 << 20, const std::string &diskDir = "");
+    ~MeshCache() = default;
+
+    static uint64_t HashMesh(const Mesh &mesh, uint64_t seed = 0);
+    static MeshCacheKey HashKey(const Mesh &meshA, const Mesh &meshB, int operation);
+
+    /// Return a new mesh if the key is cached, otherwise nullptr; the disk is read and written outside the lock
+    Mesh *Find(const MeshCacheKey &key);
+    void Insert(const MeshCacheKey &key, const Mesh &mesh);
+    void Clear();
+
+    void SetMemoryBudget(size_t budget);
+    void SetDiskDir(const std::string &dir);
+
+    MeshCacheStats GetStats() const;
+
+private:
+    void InsertMemory(const MeshCacheKey &key, const Eigen::MatrixX3d &verM, const Eigen::MatrixX3i &faceM);
+    void EvictToBudget();
+
+    static std::filesystem::path GetDiskPath(const std::string &dir, const MeshCacheKey &key);
+    static bool ReadDisk(const std::string &dir, const MeshCacheKey &key, Eigen::MatrixX3d &verM,
+                         Eigen::MatrixX3i &faceM);
+    static void WriteDisk(const std::string &dir, const MeshCacheKey &key, const Eigen::MatrixX3d &verM,
+                          const Eigen::MatrixX3i &faceM);
+};
+
+
+#endif //MESHCACHE_H
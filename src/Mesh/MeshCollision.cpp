@@ -0,0 +1,465 @@
+/// ========================================
+///
+///     MeshCollision.cpp
+///
+///     Collision detection between rigidly
+///     moving meshes
+///
+/// ========================================
+
+#include "MeshCollision.h"
+
+#include <atomic>
+#include <thread>
+#include <algorithm>
+
+namespace {
+    /// Signed distances below this (relative to the size of the faces) count as on the plane
+    const double PlaneEpsilon = 1e-12;
+    /// Clock reads during a traversal, once per this many node pairs
+    const int ClockInterval = 64;
+
+    /// Box of a transformed box (Arvo), for rigid transforms; padded for rounding, so that faces transformed
+    /// one by one never fall outside
+    Eigen::AlignedBox3d TransformBox(const Eigen::Affine3d &transform, const Eigen::Matrix3d &absLinear,
+                                     const Eigen::AlignedBox3d &box) {
+        if (box.isEmpty())
+            return box;
+        Eigen::Vector3d center = transform * box.center();
+        Eigen::Vector3d extent = absLinear * (0.5 * box.sizes());
+        extent.array() += 1e-12 * (center.cwiseAbs() + extent).array();
+        return Eigen::AlignedBox3d(center - extent, center + extent);
+    }
+
+    Eigen::Vector3d GetVertex(const Eigen::MatrixX3d &verM, int verID) {
+        return verM.row(verID).transpose();
+    }
+
+    /// Points where the edges of a triangle cross a plane (distances of its vertices given), as an interval
+    /// along the direction; false if the triangle does not reach the plane
+    bool ComputePlaneInterval(const Eigen::Vector3d *verList, const double *distList, const Eigen::Vector3d &dir,
+                              double &tMin, double &tMax, Eigen::Vector3d &ptMin, Eigen::Vector3d &ptMax) {
+        tMin = std::numeric_limits<double>::infinity();
+        tMax = -std::numeric_limits<double>::infinity();
+        auto addPoint = [&](const Eigen::Vector3d &pt) {
+            double t = dir.dot(pt);
+            if (t < tMin) {
+                tMin = t;
+                ptMin = pt;
+            }
+            if (t > tMax) {
+                tMax = t;
+                ptMax = pt;
+            }
+        };
+        for (int i = 0; i < 3; i++) {
+            int j = (i + 1) % 3;
+            if (distList[i] == 0)
+                addPoint(verList[i]);
+            if ((distList[i] < 0 && distList[j] > 0) || (distList[i] > 0 && distList[j] < 0)) {
+                double s = distList[i] / (distList[i] - distList[j]);
+                addPoint(verList[i] + s * (verList[j] - verList[i]));
+            }
+        }
+        return tMin <= tMax;
+    }
+
+    /// Signed distances of three points to the plane of a triangle, snapped to zero near the plane
+    bool ComputePlaneDistances(const Eigen::Vector3d &normal, const Eigen::Vector3d &origin,
+                               const Eigen::Vector3d *verList, double scale, double *distList) {
+        bool isPositive = true;
+        bool isNegative = true;
+        for (int i = 0; i < 3; i++) {
+            distList[i] = normal.dot(verList[i] - origin);
+            if (std::abs(distList[i]) <= PlaneEpsilon * scale)
+                distList[i] = 0;
+            isPositive = isPositive && distList[i] > 0;
+            isNegative = isNegative && distList[i] < 0;
+        }
+        return !isPositive && !isNegative;
+    }
+
+    /// 2D segment intersection (proper or touching)
+    bool IntersectSegments2D(const Eigen::Vector2d &p0, const Eigen::Vector2d &p1, const Eigen::Vector2d &q0,
+                             const Eigen::Vector2d &q1, Eigen::Vector2d &point) {
+        Eigen::Vector2d r = p1 - p0;
+        Eigen::Vector2d s = q1 - q0;
+        double denom = r.x() * s.y() - r.y() * s.x();
+        if (denom == 0)
+            return false;
+        Eigen::Vector2d d = q0 - p0;
+        double t = (d.x() * s.y() - d.y() * s.x()) / denom;
+        double u = (d.x() * r.y() - d.y() * r.x()) / denom;
+        if (t < 0 || t > 1 || u < 0 || u > 1)
+            return false;
+        point = p0 + t * r;
+        return true;
+    }
+
+    bool IsInsideTriangle2D(const Eigen::Vector2d &p, const Eigen::Vector2d *triList) {
+        double signList[3];
+        for (int i = 0; i < 3; i++) {
+            Eigen::Vector2d e = triList[(i + 1) % 3] - triList[i];
+            Eigen::Vector2d d = p - triList[i];
+            signList[i] = e.x() * d.y() - e.y() * d.x();
+        }
+        return (signList[0] >= 0 && signList[1] >= 0 && signList[2] >= 0) ||
+               (signList[0] <= 0 && signList[1] <= 0 && signList[2] <= 0);
+    }
+
+    /// Overlap of coplanar triangles, projected to the plane of the largest normal component; the segment
+    /// is the box of the overlap points
+    bool IntersectCoplanarTriangles(const Eigen::Vector3d *triA, const Eigen::Vector3d *triB,
+                                    const Eigen::Vector3d &normal, Eigen::Vector3d &segStart,
+                                    Eigen::Vector3d &segEnd) {
+        int dropAxis;
+        normal.cwiseAbs().maxCoeff(&dropAxis);
+        int axisU = (dropAxis + 1) % 3;
+        int axisV = (dropAxis + 2) % 3;
+        Eigen::Vector2d triA2[3], triB2[3];
+        for (int i = 0; i < 3; i++) {
+            triA2[i] = Eigen::Vector2d(triA[i](axisU), triA[i](axisV));
+            triB2[i] = Eigen::Vector2d(triB[i](axisU), triB[i](axisV));
+        }
+
+        /// Overlap points in 3D: vertices inside the other triangle and edge crossings (lifted back with the
+        /// barycentric weights of A)
+        Eigen::AlignedBox3d overlapBox;
+        auto lift = [&](const Eigen::Vector2d &p) {
+            Eigen::Vector2d e1 = triA2[1] - triA2[0];
+            Eigen::Vector2d e2 = triA2[2] - triA2[0];
+            Eigen::Vector2d d = p - triA2[0];
+            double det = e1.x() * e2.y() - e1.y() * e2.x();
+            double u = (d.x() * e2.y() - d.y() * e2.x()) / det;
+            double v = (e1.x() * d.y() - e1.y() * d.x()) / det;
+            overlapBox.extend(Eigen::Vector3d(triA[0] + u * (triA[1] - triA[0]) + v * (triA[2] - triA[0])));
+        };
+        for (int i = 0; i < 3; i++) {
+            if (IsInsideTriangle2D(triA2[i], triB2))
+                overlapBox.extend(triA[i]);
+            if (IsInsideTriangle2D(triB2[i], triA2))
+                overlapBox.extend(triB[i]);
+            for (int j = 0; j < 3; j++) {
+                Eigen::Vector2d point;
+                if (IntersectSegments2D(triA2[i], triA2[(i + 1) % 3], triB2[j], triB2[(j + 1) % 3], point))
+                    lift(point);
+            }
+        }
+        if (overlapBox.isEmpty())
+            return false;
+        segStart = overlapBox.min();
+        segEnd = overlapBox.max();
+        return true;
+    }
+
+    /// Largest distance of the points behind the plane (0 if none is behind)
+    double ComputeDepthBehind(const Eigen::Vector3d &normal, const Eigen::Vector3d &origin,
+                              const Eigen::Vector3d *verList) {
+        double depth = 0;
+        for (int i = 0; i < 3; i++)
+            depth = std::max(depth, -normal.dot(verList[i] - origin));
+        return depth;
+    }
+}
+
+/// ========================================
+///                Objects
+/// ========================================
+
+int MeshCollision::AddObject(const Mesh *mesh, const Eigen::Affine3d &transform) {
+    CollisionObject object;
+    object.mesh = mesh;
+    object.transform = transform;
+    UpdateBox(object);
+    objectList.push_back(object);
+
+    int objectID = static_cast<int>(objectList.size()) - 1;
+    endPointList.push_back({object.box.min().x(), objectID, true});
+    endPointList.push_back({object.box.max().x(), objectID, false});
+    return objectID;
+}
+
+void MeshCollision::SetTransform(int objectID, const Eigen::Affine3d &transform) {
+    if (objectID < 0 || objectID >= objectList.size())
+        return;
+    objectList[objectID].transform = transform;
+    UpdateBox(objectList[objectID]);
+}
+
+void MeshCollision::SetEnabled(int objectID, bool isEnabled) {
+    if (objectID < 0 || objectID >= objectList.size())
+        return;
+    objectList[objectID].isEnabled = isEnabled;
+}
+
+void MeshCollision::Clear() {
+    objectList.clear();
+    endPointList.clear();
+    pendingPairList.clear();
+}
+
+void MeshCollision::UpdateBox(CollisionObject &object) {
+    Eigen::Matrix3d absLinear = object.transform.linear().cwiseAbs();
+    object.box = TransformBox(object.transform, absLinear, object.mesh->ComputeBoundingBox());
+}
+
+/// ========================================
+///              Broad Phase
+/// ========================================
+
+void MeshCollision::ComputeOverlapPairs(std::vector<std::pair<int, int>> &overlapPairList) {
+    overlapPairList.clear();
+
+    /// 1. Sort the end points along x; insertion sort is close to linear when the order barely changes
+    for (EndPoint &endPoint: endPointList) {
+        const Eigen::AlignedBox3d &box = objectList[endPoint.objectID].box;
+        endPoint.value = endPoint.isMin ? box.min().x() : box.max().x();
+    }
+    for (int i = 1; i < endPointList.size(); i++) {
+        EndPoint endPoint = endPointList[i];
+        int j = i - 1;
+        for (; j >= 0 && endPointList[j].value > endPoint.value; j--)
+            endPointList[j + 1] = endPointList[j];
+        endPointList[j + 1] = endPoint;
+    }
+
+    /// 2. Sweep: a box starting while another is open overlaps it along x, check y and z
+    std::vector<int> activeList;
+    for (const EndPoint &endPoint: endPointList) {
+        const CollisionObject &object = objectList[endPoint.objectID];
+        if (!object.isEnabled || object.box.isEmpty())
+            continue;
+
+        if (!endPoint.isMin) {
+            auto iterator = std::find(activeList.begin(), activeList.end(), endPoint.objectID);
+            if (iterator != activeList.end()) {
+                *iterator = activeList.back();
+                activeList.pop_back();
+            }
+            continue;
+        }
+
+        for (int activeID: activeList) {
+            const Eigen::AlignedBox3d &activeBox = objectList[activeID].box;
+            if (activeBox.min().y() <= object.box.max().y() && object.box.min().y() <= activeBox.max().y() &&
+                activeBox.min().z() <= object.box.max().z() && object.box.min().z() <= activeBox.max().z())
+                overlapPairList.emplace_back(std::min(activeID, endPoint.objectID),
+                                             std::max(activeID, endPoint.objectID));
+        }
+        activeList.push_back(endPoint.objectID);
+    }
+}
+
+/// ========================================
+///              Narrow Phase
+/// ========================================
+
+int MeshCollision::DetectCollisions(std::vector<CollisionPair> &pairList) {
+    auto deadline = std::chrono::steady_clock::now() +
+                    std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+                            std::chrono::duration<double, std::milli>(TimeBudget));
+
+    /// 1. Candidate pairs, those skipped in the last frame first
+    std::vector<std::pair<int, int>> overlapPairList;
+    ComputeOverlapPairs(overlapPairList);
+    std::stable_partition(overlapPairList.begin(), overlapPairList.end(), [&](const std::pair<int, int> &pair) {
+        return std::find(pendingPairList.begin(), pendingPairList.end(), pair) != pendingPairList.end();
+    });
+
+    /// 2. Pairs are taken in order by the workers, so the time budget cuts off the tail of the list
+    std::vector<CollisionPair> candidateList(overlapPairList.size());
+    for (int i = 0; i < overlapPairList.size(); i++) {
+        candidateList[i].objectA = overlapPairList[i].first;
+        candidateList[i].objectB = overlapPairList[i].second;
+        candidateList[i].isComplete = false;
+    }
+
+    std::atomic<int> nextPair(0);
+    int workerNum = std::max(1, std::min(static_cast<int>(candidateList.size()),
+                                         static_cast<int>(std::thread::hardware_concurrency())));
+    igl::parallel_for(workerNum, [&](int) {
+        for (int i = nextPair++; i < candidateList.size(); i = nextPair++) {
+            if (std::chrono::steady_clock::now() > deadline)
+                break;
+            candidateList[i].isComplete = CollidePair(candidateList[i], deadline);
+        }
+    }, 1);
+
+    /// 3. Colliding pairs, then the unresolved ones
+    pairList.clear();
+    pendingPairList.clear();
+    int collisionNum = 0;
+    for (CollisionPair &pair: candidateList) {
+        if (pair.isComplete && pair.contactList.empty())
+            continue;
+        if (pair.isComplete) {
+            collisionNum++;
+        } else {
+            pendingPairList.emplace_back(pair.objectA, pair.objectB);
+            pair.contactList.clear();
+            pair.penetrationDepth = 0;
+        }
+        pairList.push_back(std::move(pair));
+    }
+    return collisionNum;
+}
+
+bool MeshCollision::CollidePair(CollisionPair &pair, const std::chrono::steady_clock::time_point &deadline) const {
+    const CollisionObject &objectA = objectList[pair.objectA];
+    const CollisionObject &objectB = objectList[pair.objectB];
+    std::shared_ptr<const MeshBVH> bvhA = objectA.mesh->GetBVH();
+    std::shared_ptr<const MeshBVH> bvhB = objectB.mesh->GetBVH();
+    const Eigen::MatrixX3d &verA = objectA.mesh->GetVerM();
+    const Eigen::MatrixX3d &verB = objectB.mesh->GetVerM();
+    const Eigen::MatrixX3i &faceA = objectA.mesh->GetFaceM();
+    const Eigen::MatrixX3i &faceB = objectB.mesh->GetFaceM();
+    if (bvhA->IsEmpty() || bvhB->IsEmpty())
+        return true;
+
+    /// The traversal runs in the frame of A, boxes of B are carried over by the relative transform
+    Eigen::Affine3d relativeMat = objectA.transform.inverse() * objectB.transform;
+    Eigen::Matrix3d absLinear = relativeMat.linear().cwiseAbs();
+    const std::vector<MeshBVHNode> &nodeListA = bvhA->GetNodeList();
+    const std::vector<MeshBVHNode> &nodeListB = bvhB->GetNodeList();
+    const std::vector<int> &faceIndexListA = bvhA->GetFaceIndexList();
+    const std::vector<int> &faceIndexListB = bvhB->GetFaceIndexList();
+
+    std::vector<std::pair<int, int>> stack;
+    stack.reserve(256);
+    stack.emplace_back(0, 0);
+    int visitNum = 0;
+    while (!stack.empty()) {
+        if (++visitNum % ClockInterval == 0 && std::chrono::steady_clock::now() > deadline)
+            return false;
+
+        int nodeIDA = stack.back().first;
+        int nodeIDB = stack.back().second;
+        stack.pop_back();
+        const MeshBVHNode &nodeA = nodeListA[nodeIDA];
+        const MeshBVHNode &nodeB = nodeListB[nodeIDB];
+        Eigen::AlignedBox3d boxB = TransformBox(relativeMat, absLinear, nodeB.box);
+        if (!nodeA.box.intersects(boxB))
+            continue;
+
+        /// Descend the larger node (or the only internal one)
+        if (!nodeA.IsLeaf() || !nodeB.IsLeaf()) {
+            bool isSplitA = nodeB.IsLeaf() ||
+                            (!nodeA.IsLeaf() && nodeA.box.sizes().squaredNorm() >= boxB.sizes().squaredNorm());
+            if (isSplitA) {
+                stack.emplace_back(nodeA.offset, nodeIDB);
+                stack.emplace_back(nodeA.offset + 1, nodeIDB);
+            } else {
+                stack.emplace_back(nodeIDA, nodeB.offset);
+                stack.emplace_back(nodeIDA, nodeB.offset + 1);
+            }
+            continue;
+        }
+
+        /// Leaf against leaf: the faces of B are transformed once, then tested against each face of A
+        Eigen::Vector3d triListB[4 * 4][3];
+        Eigen::AlignedBox3d triBoxListB[4 * 4];
+        int triNumB = std::min(nodeB.faceNum, 16);
+        for (int j = 0; j < triNumB; j++) {
+            int faceIDB = faceIndexListB[nodeB.offset + j];
+            triBoxListB[j].setEmpty();
+            for (int k = 0; k < 3; k++) {
+                triListB[j][k] = relativeMat * GetVertex(verB, faceB(faceIDB, k));
+                triBoxListB[j].extend(triListB[j][k]);
+            }
+        }
+
+        for (int i = nodeA.offset; i < nodeA.offset + nodeA.faceNum; i++) {
+            int faceIDA = faceIndexListA[i];
+            Eigen::Vector3d triA[3] = {GetVertex(verA, faceA(faceIDA, 0)), GetVertex(verA, faceA(faceIDA, 1)),
+                                       GetVertex(verA, faceA(faceIDA, 2))};
+            Eigen::AlignedBox3d triBoxA(triA[0]);
+            triBoxA.extend(triA[1]);
+            triBoxA.extend(triA[2]);
+
+            for (int j = 0; j < nodeB.faceNum; j++) {
+                int faceIDB = faceIndexListB[nodeB.offset + j];
+                Eigen::Vector3d triB[3];
+                Eigen::AlignedBox3d triBoxB;
+                if (j < triNumB) {
+                    std::copy(triListB[j], triListB[j] + 3, triB);
+                    triBoxB = triBoxListB[j];
+                } else {
+                    for (int k = 0; k < 3; k++) {
+                        triB[k] = relativeMat * GetVertex(verB, faceB(faceIDB, k));
+                        triBoxB.extend(triB[k]);
+                    }
+                }
+                if (!triBoxA.intersects(triBoxB))
+                    continue;
+
+                Eigen::Vector3d segStart, segEnd;
+                if (!IntersectTriangles(triA[0], triA[1], triA[2], triB[0], triB[1], triB[2], segStart, segEnd))
+                    continue;
+
+                /// Depth: how far B sinks behind the face of A, or A behind the face of B (the smaller one)
+                Eigen::Vector3d normalA = (triA[1] - triA[0]).cross(triA[2] - triA[0]).normalized();
+                Eigen::Vector3d normalB = (triB[1] - triB[0]).cross(triB[2] - triB[0]).normalized();
+                double depthB = ComputeDepthBehind(normalA, triA[0], triB);
+                double depthA = ComputeDepthBehind(normalB, triB[0], triA);
+
+                MeshContact contact;
+                contact.faceA = faceIDA;
+                contact.faceB = faceIDB;
+                contact.point = objectA.transform * (0.5 * (segStart + segEnd));
+                contact.depth = std::min(depthA, depthB);
+                contact.normal = objectA.transform.linear() * (depthB <= depthA ? normalA : Eigen::Vector3d(-normalB));
+                pair.penetrationDepth = std::max(pair.penetrationDepth, contact.depth);
+                pair.contactList.push_back(contact);
+                if (pair.contactList.size() >= MaxContactNum)
+                    return true;
+            }
+        }
+    }
+    return true;
+}
+
+/// ========================================
+///          Triangle Intersection
+/// ========================================
+
+/// Interval overlap along the line of the two planes (Moller 1997), with the crossing segment kept
+bool MeshCollision::IntersectTriangles(const Eigen::Vector3d &a0, const Eigen::Vector3d &a1, const Eigen::Vector3d &a2,
+                                       const Eigen::Vector3d &b0, const Eigen::Vector3d &b1, const Eigen::Vector3d &b2,
+                                       Eigen::Vector3d &segStart, Eigen::Vector3d &segEnd) {
+    Eigen::Vector3d triA[3] = {a0, a1, a2};
+    Eigen::Vector3d triB[3] = {b0, b1, b2};
+    Eigen::Vector3d normalA = (a1 - a0).cross(a2 - a0);
+    Eigen::Vector3d normalB = (b1 - b0).cross(b2 - b0);
+    double normA = normalA.norm();
+    double normB = normalB.norm();
+    if (normA == 0 || normB == 0)
+        return false;
+    normalA /= normA;
+    normalB /= normB;
+
+    /// 1. Each triangle has to reach the plane of the other
+    double scale = std::max({(a1 - a0).cwiseAbs().maxCoeff(), (a2 - a0).cwiseAbs().maxCoeff(),
+                             (b1 - b0).cwiseAbs().maxCoeff(), (b2 - b0).cwiseAbs().maxCoeff()});
+    double distListB[3], distListA[3];
+    if (!ComputePlaneDistances(normalA, a0, triB, scale, distListB))
+        return false;
+    if (!ComputePlaneDistances(normalB, b0, triA, scale, distListA))
+        return false;
+
+    if (distListB[0] == 0 && distListB[1] == 0 && distListB[2] == 0)
+        return IntersectCoplanarTriangles(triA, triB, normalA, segStart, segEnd);
+
+    /// 2. Both cut the line of the planes in an interval, the triangles cross where the intervals overlap
+    Eigen::Vector3d dir = normalA.cross(normalB);
+    double tMinA, tMaxA, tMinB, tMaxB;
+    Eigen::Vector3d ptMinA, ptMaxA, ptMinB, ptMaxB;
+    if (!ComputePlaneInterval(triA, distListA, dir, tMinA, tMaxA, ptMinA, ptMaxA) ||
+        !ComputePlaneInterval(triB, distListB, dir, tMinB, tMaxB, ptMinB, ptMaxB))
+        return false;
+    if (tMaxA < tMinB || tMaxB < tMinA)
+        return false;
+
+    segStart = tMinA >= tMinB ? ptMinA : ptMinB;
+    segEnd = tMaxA <= tMaxB ? ptMaxA : ptMaxB;
+    return true;
+}
@@ -0,0 +1,102 @@
+/// ========================================
+///
+///     MeshCollision.h
+///
+///     Collision detection between rigidly
+///     moving meshes
+///
+/// ========================================
+
+#ifndef MESHCOLLISION_H
+#define MESHCOLLISION_H
+
+#include <chrono>
+#include <vector>
+#include <Eigen/Geometry>
+
+#include "Mesh/Mesh.h"
+
+/// A pair of intersecting faces
+struct MeshContact {
+    int faceA = -1;
+    int faceB = -1;
+    /// Midpoint of the segment where the faces cross (world frame)
+    Eigen::Vector3d point = Eigen::Vector3d::Zero();
+    /// Shortest move of B along the normal of one of the faces that separates the two faces, and its
+    /// direction (world frame)
+    double depth = 0;
+    Eigen::Vector3d normal = Eigen::Vector3d::Zero();
+};
+
+struct CollisionPair {
+    int objectA = -1;
+    int objectB = -1;
+    /// At most MeshCollision::MaxContactNum contacts
+    std::vector<MeshContact> contactList;
+    /// Largest depth of the contacts
+    double penetrationDepth = 0;
+    /// False if the time budget ran out before this pair was tested: the bounding boxes overlap, but
+    /// the pair is not known to collide (it is tested first in the next frame)
+    bool isComplete = true;
+};
+
+class MeshCollision {
+public:
+    /// Time for DetectCollisions in milliseconds (the broad phase always completes)
+    double TimeBudget = 4.0;
+    /// Contacts kept per pair; the traversal of a pair stops once it has them
+    int MaxContactNum = 64;
+
+private:
+    struct CollisionObject {
+        /// Owned by the caller
+        const Mesh *mesh = nullptr;
+        /// Mesh frame to world, rigid
+        Eigen::Affine3d transform = Eigen::Affine3d::Identity();
+        Eigen::AlignedBox3d box;
+        bool isEnabled = true;
+    };
+
+    /// Box end point on the sweep axis
+    struct EndPoint {
+        double value;
+        int objectID;
+        bool isMin;
+    };
+
+    std::vector<CollisionObject> objectList;
+    /// Kept sorted across frames, so the insertion sort of the sweep is nearly linear for coherent motion
+    std::vector<EndPoint> endPointList;
+    /// Pairs skipped for the time budget, tested first in the next frame
+    std::vector<std::pair<int, int>> pendingPairList;
+
+public:
+    MeshCollision() = default;
+    ~MeshCollision() = default;
+
+    /// Returns the objectID
+    int AddObject(const Mesh *mesh, const Eigen::Affine3d &transform = Eigen::Affine3d::Identity());
+    void SetTransform(int objectID, const Eigen::Affine3d &transform);
+    void SetEnabled(int objectID, bool isEnabled);
+    void Clear();
+
+    /// Sweep and prune over the object boxes, then BVH against BVH with triangle-triangle tests in parallel.
+    /// Returns the number of colliding pairs (pairs left incomplete by the time budget are listed, not counted).
+    int DetectCollisions(std::vector<CollisionPair> &pairList);
+
+    /// Pairs of objects whose world boxes overlap
+    void ComputeOverlapPairs(std::vector<std::pair<int, int>> &overlapPairList);
+
+    /// Intersection of two triangles: false if they do not cross, otherwise the end points of the crossing segment
+    static bool IntersectTriangles(const Eigen::Vector3d &a0, const Eigen::Vector3d &a1, const Eigen::Vector3d &a2,
+                                   const Eigen::Vector3d &b0, const Eigen::Vector3d &b1, const Eigen::Vector3d &b2,
+                                   Eigen::Vector3d &segStart, Eigen::Vector3d &segEnd);
+
+private:
+    void UpdateBox(CollisionObject &object);
+    /// Returns false if the deadline passed before the traversal finished
+    bool CollidePair(CollisionPair &pair, const std::chrono::steady_clock::time_point &deadline) const;
+};
+
+
+#endif //MESHCOLLISION_H
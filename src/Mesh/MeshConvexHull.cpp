@@ -0,0 +1,483 @@
+/// ========================================
+///
+///     MeshConvexHull.cpp
+///
+///     Quickhull with filtered predicates
+///     and an exact fallback
+///
+/// ========================================
+
+#include "MeshConvexHull.h"
+
+#include <cfloat>
+#include <unordered_map>
+#include <Eigen/Geometry>
+
+#include <igl/parallel_for.h>
+#include <igl/copyleft/cgal/convex_hull.h>
+
+namespace {
+    /// Static error bound of orient3d (Shewchuk, Adaptive Precision Floating-Point Arithmetic), eps = 2^-53
+    const double Epsilon = DBL_EPSILON * 0.5;
+    const double Orient3dErrorBound = (7.0 + 56.0 * Epsilon) * Epsilon;
+
+    /// Points per chunk of the parallel reductions
+    const long ChunkSize = 1 << 16;
+
+    /// Positive if d is below the plane of a, b, c (counter-clockwise seen from above), 0 if the sign is not
+    /// certain in floating point
+    int Orient3dFiltered(const Eigen::Vector3d &a, const Eigen::Vector3d &b, const Eigen::Vector3d &c,
+                         const Eigen::Vector3d &d) {
+        double adx = a.x() - d.x(), bdx = b.x() - d.x(), cdx = c.x() - d.x();
+        double ady = a.y() - d.y(), bdy = b.y() - d.y(), cdy = c.y() - d.y();
+        double adz = a.z() - d.z(), bdz = b.z() - d.z(), cdz = c.z() - d.z();
+
+        double bdxcdy = bdx * cdy, cdxbdy = cdx * bdy;
+        double cdxady = cdx * ady, adxcdy = adx * cdy;
+        double adxbdy = adx * bdy, bdxady = bdx * ady;
+        double det = adz * (bdxcdy - cdxbdy) + bdz * (cdxady - adxcdy) + cdz * (adxbdy - bdxady);
+        double permanent = (std::abs(bdxcdy) + std::abs(cdxbdy)) * std::abs(adz) +
+                           (std::abs(cdxady) + std::abs(adxcdy)) * std::abs(bdz) +
+                           (std::abs(adxbdy) + std::abs(bdxady)) * std::abs(cdz);
+        double errorBound = Orient3dErrorBound * permanent;
+        if (det > errorBound)
+            return 1;
+        if (-det > errorBound)
+            return -1;
+        return 0;
+    }
+
+    /// Index of the row with the largest value (the first one on ties), reduced over chunks in parallel
+    template<typename ValueFunc>
+    long FindMaxRow(const Eigen::MatrixX3d &verM, const ValueFunc &valueFunc) {
+        long chunkNum = (verM.rows() + ChunkSize - 1) / ChunkSize;
+        std::vector<std::pair<double, long>> bestList(chunkNum, {-std::numeric_limits<double>::infinity(), -1});
+        igl::parallel_for(chunkNum, [&](long chunkID) {
+            long end = std::min(verM.rows(), (chunkID + 1) * ChunkSize);
+            for (long i = chunkID * ChunkSize; i < end; i++) {
+                double value = valueFunc(Eigen::Vector3d(verM.row(i).transpose()));
+                if (value > bestList[chunkID].first)
+                    bestList[chunkID] = {value, i};
+            }
+        }, 1);
+
+        std::pair<double, long> best = {-std::numeric_limits<double>::infinity(), -1};
+        for (const auto &chunkBest: bestList) {
+            if (chunkBest.first > best.first)
+                best = chunkBest;
+        }
+        return best.second;
+    }
+}
+
+/// ========================================
+///                 Build
+/// ========================================
+
+void MeshConvexHull::Clear() {
+    pointList.clear();
+    interiorFlagList.clear();
+    faceList.clear();
+    visitMarkList.clear();
+    visitStamp = 0;
+    isExactMode = false;
+    exactVerM.resize(0, 3);
+    exactFaceM.resize(0, 3);
+}
+
+void MeshConvexHull::Build(const Eigen::MatrixX3d &verM) {
+    Clear();
+    if (verM.rows() < 4) {
+        ComputeExactHull(verM);
+        return;
+    }
+
+    /// 1. Extreme points along 26 directions (Akl-Toussaint), in parallel chunks
+    std::vector<Eigen::Vector3d> dirList;
+    for (int x = -1; x <= 1; x++) {
+        for (int y = -1; y <= 1; y++) {
+            for (int z = -1; z <= 1; z++) {
+                if (x != 0 || y != 0 || z != 0)
+                    dirList.emplace_back(x, y, z);
+            }
+        }
+    }
+    long chunkNum = (verM.rows() + ChunkSize - 1) / ChunkSize;
+    std::vector<std::vector<long>> chunkExtremeList(chunkNum, std::vector<long>(dirList.size(), -1));
+    igl::parallel_for(chunkNum, [&](long chunkID) {
+        long begin = chunkID * ChunkSize;
+        long end = std::min(verM.rows(), begin + ChunkSize);
+        std::vector<double> maxList(dirList.size(), -std::numeric_limits<double>::infinity());
+        for (long i = begin; i < end; i++) {
+            Eigen::Vector3d point = verM.row(i).transpose();
+            for (int k = 0; k < dirList.size(); k++) {
+                double value = dirList[k].dot(point);
+                if (value > maxList[k]) {
+                    maxList[k] = value;
+                    chunkExtremeList[chunkID][k] = i;
+                }
+            }
+        }
+    }, 1);
+
+    std::vector<long> extremeIndexList;
+    for (int k = 0; k < dirList.size(); k++) {
+        long best = -1;
+        for (long chunkID = 0; chunkID < chunkNum; chunkID++) {
+            long i = chunkExtremeList[chunkID][k];
+            if (best < 0 || dirList[k].dot(verM.row(i).transpose()) > dirList[k].dot(verM.row(best).transpose()))
+                best = i;
+        }
+        if (std::find(extremeIndexList.begin(), extremeIndexList.end(), best) == extremeIndexList.end())
+            extremeIndexList.push_back(best);
+    }
+    Eigen::MatrixX3d extremeM(extremeIndexList.size(), 3);
+    for (int i = 0; i < extremeIndexList.size(); i++)
+        extremeM.row(i) = verM.row(extremeIndexList[i]);
+
+    /// 2. Hull of the extreme points, then cull all points against it and expand by the rest
+    if (!BuildSimplex(verM, extremeM) || !AddCandidates(extremeM) || !Expand() || !AddCandidates(verM) ||
+        !Expand()) {
+        Clear();
+        ComputeExactHull(verM);
+    }
+}
+
+void MeshConvexHull::AddPoints(const Eigen::MatrixX3d &verM) {
+    if (isExactMode) {
+        ComputeExactHull(verM);
+        return;
+    }
+    if (faceList.empty()) {
+        Build(verM);
+        return;
+    }
+    if (!AddCandidates(verM) || !Expand())
+        ComputeExactHull(Eigen::MatrixX3d(0, 3));
+}
+
+/// Tetrahedron of two far apart extreme points, the point farthest from their line and the one farthest
+/// from that plane
+bool MeshConvexHull::BuildSimplex(const Eigen::MatrixX3d &verM, const Eigen::MatrixX3d &extremeM) {
+    long indexA = 0, indexB = 0;
+    double maxDistance = 0;
+    for (long i = 0; i < extremeM.rows(); i++) {
+        for (long j = i + 1; j < extremeM.rows(); j++) {
+            double distance = (extremeM.row(i) - extremeM.row(j)).squaredNorm();
+            if (distance > maxDistance) {
+                maxDistance = distance;
+                indexA = i;
+                indexB = j;
+            }
+        }
+    }
+    if (maxDistance == 0)
+        return false;
+    Eigen::Vector3d a = extremeM.row(indexA).transpose();
+    Eigen::Vector3d b = extremeM.row(indexB).transpose();
+
+    Eigen::Vector3d dirAB = (b - a).normalized();
+    long indexC = FindMaxRow(verM, [&](const Eigen::Vector3d &point) {
+        return (point - a - dirAB * dirAB.dot(point - a)).squaredNorm();
+    });
+    Eigen::Vector3d c = verM.row(indexC).transpose();
+    Eigen::Vector3d normal = (b - a).cross(c - a);
+    if (normal.squaredNorm() == 0)
+        return false;
+
+    long indexD = FindMaxRow(verM, [&](const Eigen::Vector3d &point) {
+        return std::abs(normal.dot(point - a));
+    });
+    Eigen::Vector3d d = verM.row(indexD).transpose();
+    int orient = Orient3dFiltered(a, b, c, d);
+    if (orient == 0)
+        return false;
+    /// d below (a, b, c)
+    if (orient < 0)
+        std::swap(b, c);
+
+    pointList = {a, b, c, d};
+    interiorFlagList.assign(4, 0);
+    int faceVerList[4][3] = {{0, 1, 2}, {0, 3, 1}, {1, 3, 2}, {2, 3, 0}};
+    for (auto &faceVer: faceVerList)
+        CreateFace(faceVer[0], faceVer[1], faceVer[2]);
+
+    /// Link the faces by their shared (opposite) edges, and check that the fourth point is below each face
+    for (int i = 0; i < 4; i++) {
+        HullFace &face = faceList[i];
+        for (int e = 0; e < 3; e++) {
+            for (int j = 0; j < 4; j++) {
+                const int *verList = faceList[j].verList;
+                for (int k = 0; k < 3; k++) {
+                    if (verList[k] == face.verList[(e + 1) % 3] && verList[(k + 1) % 3] == face.verList[e])
+                        face.adjList[e] = j;
+                }
+            }
+        }
+        int oppositeID = 6 - face.verList[0] - face.verList[1] - face.verList[2];
+        if (ComputeSide(face, pointList[oppositeID]) >= 0)
+            return false;
+    }
+    return true;
+}
+
+/// ========================================
+///               Quickhull
+/// ========================================
+
+bool MeshConvexHull::AddCandidates(const Eigen::MatrixX3d &verM) {
+    std::vector<int> faceIndexList = GetLiveFaces();
+
+    /// Points in a ball inside the hull skip the face tests. Its center is the mean of the hull vertices,
+    /// its radius the distance to the nearest face plane, less a bound on the rounding (far above the
+    /// errors of the normal and the distance)
+    Eigen::Vector3d center = Eigen::Vector3d::Zero();
+    std::vector<char> isHullVertexList(pointList.size(), 0);
+    for (int faceID: faceIndexList) {
+        for (int verID: faceList[faceID].verList)
+            isHullVertexList[verID] = 1;
+    }
+    int hullVerNum = 0;
+    for (int pointID = 0; pointID < pointList.size(); pointID++) {
+        if (isHullVertexList[pointID]) {
+            center += pointList[pointID];
+            hullVerNum++;
+        }
+    }
+    center /= std::max(hullVerNum, 1);
+    double radius = std::numeric_limits<double>::infinity();
+    for (int faceID: faceIndexList) {
+        const HullFace &face = faceList[faceID];
+        const Eigen::Vector3d &a = pointList[face.verList[0]];
+        double edgeProduct = (pointList[face.verList[1]] - a).norm() * (pointList[face.verList[2]] - a).norm();
+        double area = (pointList[face.verList[1]] - a).cross(pointList[face.verList[2]] - a).norm();
+        double margin = 1e-13 * (1 + edgeProduct / area) * (center - a).norm();
+        radius = std::min(radius, -face.normal.dot(center - a) - margin);
+    }
+    double sqrRadius = radius > 0 ? radius * radius * (1 - 1e-12) : 0;
+
+    std::vector<int> resultList(verM.rows());
+    igl::parallel_for(verM.rows(), [&](long i) {
+        Eigen::Vector3d point = verM.row(i).transpose();
+        resultList[i] = (point - center).squaredNorm() < sqrRadius ? -1 : ClassifyPoint(point, faceIndexList);
+    }, 1000);
+
+    bool isDecided = true;
+    for (long i = 0; i < verM.rows(); i++) {
+        if (resultList[i] == -1)
+            continue;
+        /// Undecided points are kept for the exact hull
+        int pointID = static_cast<int>(pointList.size());
+        pointList.emplace_back(verM.row(i).transpose());
+        interiorFlagList.push_back(0);
+        if (resultList[i] >= 0)
+            faceList[resultList[i]].outsideList.push_back(pointID);
+        else
+            isDecided = false;
+    }
+    return isDecided;
+}
+
+/// New faces are appended, so one pass over the faces empties all outside lists
+bool MeshConvexHull::Expand() {
+    for (int faceID = 0; faceID < faceList.size(); faceID++) {
+        if (faceList[faceID].isDeleted || faceList[faceID].outsideList.empty())
+            continue;
+
+        /// The farthest point of the outside list is on the hull
+        int eyeID = -1;
+        double maxDistance = -1;
+        for (int pointID: faceList[faceID].outsideList) {
+            double distance = faceList[faceID].normal.dot(pointList[pointID] - pointList[faceList[faceID].verList[0]]);
+            if (distance > maxDistance) {
+                maxDistance = distance;
+                eyeID = pointID;
+            }
+        }
+        if (!AddEyePoint(faceID, eyeID))
+            return false;
+    }
+    return true;
+}
+
+bool MeshConvexHull::AddEyePoint(int faceID, int eyeID) {
+    const Eigen::Vector3d eye = pointList[eyeID];
+    struct HorizonEdge {
+        int verA, verB;
+        int faceID, edgeID;
+    };
+
+    /// 1. Faces visible from the eye (1 in the marks) and the horizon around them (-1 for faces not visible)
+    visitMarkList.resize(faceList.size(), 0);
+    int visibleStamp = ++visitStamp;
+    int hiddenStamp = ++visitStamp;
+    std::vector<int> visibleList = {faceID};
+    std::vector<HorizonEdge> horizonList;
+    visitMarkList[faceID] = visibleStamp;
+    for (int k = 0; k < visibleList.size(); k++) {
+        int visibleID = visibleList[k];
+        for (int e = 0; e < 3; e++) {
+            int adjID = faceList[visibleID].adjList[e];
+            if (visitMarkList[adjID] == visibleStamp)
+                continue;
+            if (visitMarkList[adjID] != hiddenStamp) {
+                int side = ComputeSide(faceList[adjID], eye);
+                if (side == 0)
+                    return false;
+                if (side > 0) {
+                    visitMarkList[adjID] = visibleStamp;
+                    visibleList.push_back(adjID);
+                    continue;
+                }
+                visitMarkList[adjID] = hiddenStamp;
+            }
+            const HullFace &adjFace = faceList[adjID];
+            int adjEdge = adjFace.adjList[0] == visibleID ? 0 : (adjFace.adjList[1] == visibleID ? 1 : 2);
+            horizonList.push_back({faceList[visibleID].verList[e], faceList[visibleID].verList[(e + 1) % 3],
+                                   adjID, adjEdge});
+        }
+    }
+
+    /// 2. A cone of new faces from the horizon to the eye
+    std::unordered_map<int, int> startMap, endMap;
+    std::vector<int> newFaceList;
+    for (const HorizonEdge &edge: horizonList) {
+        int newID = CreateFace(edge.verA, edge.verB, eyeID);
+        faceList[newID].adjList[0] = edge.faceID;
+        faceList[edge.faceID].adjList[edge.edgeID] = newID;
+        startMap[edge.verA] = newID;
+        endMap[edge.verB] = newID;
+        newFaceList.push_back(newID);
+    }
+    for (int newID: newFaceList) {
+        HullFace &face = faceList[newID];
+        face.adjList[1] = startMap[face.verList[1]];
+        face.adjList[2] = endMap[face.verList[0]];
+    }
+
+    /// 3. Points above the visible faces go to the new faces, or are inside now
+    std::vector<int> orphanList;
+    for (int visibleID: visibleList) {
+        HullFace &face = faceList[visibleID];
+        face.isDeleted = true;
+        for (int pointID: face.outsideList) {
+            if (pointID != eyeID)
+                orphanList.push_back(pointID);
+        }
+        std::vector<int>().swap(face.outsideList);
+    }
+    bool isDecided = true;
+    for (int pointID: orphanList) {
+        int result = ClassifyPoint(pointList[pointID], newFaceList);
+        if (result >= 0)
+            faceList[result].outsideList.push_back(pointID);
+        else if (result == -1)
+            interiorFlagList[pointID] = 1;
+        else
+            isDecided = false;
+    }
+    return isDecided;
+}
+
+int MeshConvexHull::CreateFace(int verA, int verB, int verC) {
+    HullFace face;
+    face.verList[0] = verA;
+    face.verList[1] = verB;
+    face.verList[2] = verC;
+    std::fill(face.adjList, face.adjList + 3, -1);
+    face.normal = (pointList[verB] - pointList[verA]).cross(pointList[verC] - pointList[verA]).normalized();
+    faceList.push_back(face);
+    return static_cast<int>(faceList.size()) - 1;
+}
+
+int MeshConvexHull::ComputeSide(const HullFace &face, const Eigen::Vector3d &point) const {
+    const Eigen::Vector3d &a = pointList[face.verList[0]];
+    const Eigen::Vector3d &b = pointList[face.verList[1]];
+    const Eigen::Vector3d &c = pointList[face.verList[2]];
+    int orient = Orient3dFiltered(a, b, c, point);
+    if (orient != 0)
+        return -orient;
+    /// A copy of a hull vertex does not change the hull
+    if (point == a || point == b || point == c)
+        return -1;
+    return 0;
+}
+
+int MeshConvexHull::ClassifyPoint(const Eigen::Vector3d &point, const std::vector<int> &faceIndexList) const {
+    bool isDecided = true;
+    for (int faceID: faceIndexList) {
+        int side = ComputeSide(faceList[faceID], point);
+        if (side > 0)
+            return faceID;
+        if (side == 0)
+            isDecided = false;
+    }
+    return isDecided ? -1 : -2;
+}
+
+std::vector<int> MeshConvexHull::GetLiveFaces() const {
+    std::vector<int> faceIndexList;
+    for (int faceID = 0; faceID < faceList.size(); faceID++) {
+        if (!faceList[faceID].isDeleted)
+            faceIndexList.push_back(faceID);
+    }
+    return faceIndexList;
+}
+
+/// ========================================
+///             Exact Fallback
+/// ========================================
+
+void MeshConvexHull::ComputeExactHull(const Eigen::MatrixX3d &extraM) {
+    std::vector<Eigen::Vector3d> candidateList;
+    if (isExactMode) {
+        for (long i = 0; i < exactVerM.rows(); i++)
+            candidateList.emplace_back(exactVerM.row(i).transpose());
+    } else {
+        for (int i = 0; i < pointList.size(); i++) {
+            if (!interiorFlagList[i])
+                candidateList.push_back(pointList[i]);
+        }
+    }
+
+    Eigen::MatrixXd candidateM(candidateList.size() + extraM.rows(), 3);
+    for (int i = 0; i < candidateList.size(); i++)
+        candidateM.row(i) = candidateList[i].transpose();
+    candidateM.bottomRows(extraM.rows()) = extraM;
+
+    igl::copyleft::cgal::convex_hull(candidateM, exactVerM, exactFaceM);
+    isExactMode = true;
+    pointList.clear();
+    interiorFlagList.clear();
+    faceList.clear();
+}
+
+/// ========================================
+///                 Output
+/// ========================================
+
+void MeshConvexHull::GetHull(Eigen::MatrixXd &hullVerM, Eigen::MatrixX3i &hullFaceM) const {
+    if (isExactMode) {
+        hullVerM = exactVerM;
+        hullFaceM = exactFaceM;
+        return;
+    }
+
+    std::vector<int> faceIndexList = GetLiveFaces();
+    std::vector<int> verMap(pointList.size(), -1);
+    int verNum = 0;
+    hullFaceM.resize(static_cast<long>(faceIndexList.size()), 3);
+    for (int i = 0; i < faceIndexList.size(); i++) {
+        for (int k = 0; k < 3; k++) {
+            int pointID = faceList[faceIndexList[i]].verList[k];
+            if (verMap[pointID] < 0)
+                verMap[pointID] = verNum++;
+            hullFaceM(i, k) = verMap[pointID];
+        }
+    }
+    hullVerM.resize(verNum, 3);
+    for (int pointID = 0; pointID < pointList.size(); pointID++) {
+        if (verMap[pointID] >= 0)
+            hullVerM.row(verMap[pointID]) = pointList[pointID].transpose();
+    }
+}
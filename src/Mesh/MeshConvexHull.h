@@ -0,0 +1,82 @@
+/// ========================================
+///
+///     MeshConvexHull.h
+///
+///     Quickhull with filtered predicates
+///     and an exact fallback
+///
+/// ========================================
+
+#ifndef MESHCONVEXHULL_H
+#define MESHCONVEXHULL_H
+
+#include <vector>
+#include <Eigen/Core>
+
+/// Convex hull of a point set, kept up to date as points are added.
+/// Orientation tests run in doubles with a static error bound (Shewchuk's orient3d filter); if one of them
+/// cannot be decided (coplanar points on the hull, flat inputs), the hull is computed by CGAL instead, over
+/// the points not yet known to be interior. Points in general position give the same hull as CGAL.
+class MeshConvexHull {
+private:
+    struct HullFace {
+        int verList[3];
+        /// Face across the edge (verList[i], verList[i + 1])
+        int adjList[3];
+        Eigen::Vector3d normal;
+        /// Points above the face, not yet on the hull
+        std::vector<int> outsideList;
+        bool isDeleted = false;
+    };
+
+    std::vector<Eigen::Vector3d> pointList;
+    /// Points of pointList found inside the hull
+    std::vector<char> interiorFlagList;
+    std::vector<HullFace> faceList;
+    /// Marks of the faces while searching the faces visible from a point
+    std::vector<int> visitMarkList;
+    int visitStamp = 0;
+
+    /// Hull computed by CGAL after a predicate could not be decided; later points are added by CGAL as well
+    bool isExactMode = false;
+    Eigen::MatrixXd exactVerM;
+    Eigen::MatrixXi exactFaceM;
+
+public:
+    MeshConvexHull() = default;
+    ~MeshConvexHull() = default;
+
+    /// Hull of the points; points inside the hull of the extreme points along 26 directions are culled in
+    /// parallel first (Akl-Toussaint)
+    void Build(const Eigen::MatrixX3d &verM);
+
+    /// Grow the hull by more points
+    void AddPoints(const Eigen::MatrixX3d &verM);
+
+    /// Extreme points and outward oriented triangles of the hull
+    void GetHull(Eigen::MatrixXd &hullVerM, Eigen::MatrixX3i &hullFaceM) const;
+
+    /// Whether the last update fell back to CGAL
+    bool IsExactMode() const { return isExactMode; }
+
+private:
+    void Clear();
+    bool BuildSimplex(const Eigen::MatrixX3d &verM, const Eigen::MatrixX3d &extremeM);
+    /// Sort points into the outside lists of the live faces (in parallel), points inside are dropped
+    bool AddCandidates(const Eigen::MatrixX3d &verM);
+    bool Expand();
+    bool AddEyePoint(int faceID, int eyeID);
+
+    int CreateFace(int verA, int verB, int verC);
+    /// 1 above the face, -1 below (or on one of its vertices), 0 if the filter cannot decide
+    int ComputeSide(const HullFace &face, const Eigen::Vector3d &point) const;
+    /// A face the point is above, -1 if it is inside all of them, -2 if undecided
+    int ClassifyPoint(const Eigen::Vector3d &point, const std::vector<int> &faceIndexList) const;
+    std::vector<int> GetLiveFaces() const;
+
+    /// CGAL over the points not known to be interior, plus the extra ones
+    void ComputeExactHull(const Eigen::MatrixX3d &extraM);
+};
+
+
+#endif //MESHCONVEXHULL_H
@@ -12,6 +12,192 @@
 
 #include "MeshCreator.h"
 
+#include <map>
+#include <shared_mutex>
+
+/// ========================================
+///          Unit Primitive Templates
+/// ========================================
+
+namespace {
+    /// Templates keyed by (primitive type, radSamp), shared by all threads and never modified once built
+    std::map<std::pair<int, int>, std::shared_ptr<const PrimitiveTemplate>> templateMap;
+    /// Ring tables keyed by radSamp
+    std::map<int, std::shared_ptr<const RingTable>> ringMap;
+    std::shared_mutex templateMutex;
+}
+
+/// Scale each coordinate first and multiply by the factor second, which is the evaluation order of
+/// the generators (e.g. radius * cos(alpha) * cos(beta)), so instances are bit-identical to them
+Mesh *PrimitiveTemplate::Instantiate(const Eigen::Vector3d &scaleVec) const {
+    Mesh *mesh = new Mesh();
+    mesh->EditVerM() = (ScaleM.array().rowwise() * scaleVec.transpose().array()) * FactorM.array();
+    mesh->EditFaceM() = FaceM;
+    return mesh;
+}
+
+std::shared_ptr<const PrimitiveTemplate> MeshCreator::GetTemplate(PrimitiveType type, int radSamp) {
+    std::pair<int, int> key(type, radSamp);
+    {
+        std::shared_lock<std::shared_mutex> lock(templateMutex);
+        auto iterator = templateMap.find(key);
+        if (iterator != templateMap.end())
+            return iterator->second;
+    }
+
+    /// Built outside the lock; if another thread inserted the same template meanwhile, use that one
+    std::shared_ptr<const PrimitiveTemplate> primitive = BuildTemplate(type, radSamp);
+    std::unique_lock<std::shared_mutex> lock(templateMutex);
+    return templateMap.emplace(key, primitive).first->second;
+}
+
+void MeshCreator::ClearTemplates() {
+    std::unique_lock<std::shared_mutex> lock(templateMutex);
+    templateMap.clear();
+    ringMap.clear();
+}
+
+/// Tables shared by all generators: vectors are written straight into VerM with the tables
+/// (no trig per vertex), in the same evaluation order as the former per-vertex code
+std::shared_ptr<const RingTable> MeshCreator::GetRingTable(int radSamp) {
+    {
+        std::shared_lock<std::shared_mutex> lock(templateMutex);
+        auto iterator = ringMap.find(radSamp);
+        if (iterator != ringMap.end())
+            return iterator->second;
+    }
+
+    auto ring = std::make_shared<RingTable>();
+    ring->CosV.resize(radSamp);
+    ring->SinV.resize(radSamp);
+    for (int i = 0; i < radSamp; i++) {
+        double beta = i * 2.0 * M_PI / radSamp;
+        ring->CosV(i) = cos(beta);
+        ring->SinV(i) = sin(beta);
+    }
+
+    std::unique_lock<std::shared_mutex> lock(templateMutex);
+    return ringMap.emplace(radSamp, ring).first->second;
+}
+
+int MeshCreator::GetRadSamp(double radius, double maxError, int minSamp, int maxSamp) {
+    if (maxError <= 0 || radius <= 0)
+        return radius <= 0 ? minSamp : maxSamp;
+    if (maxError >= radius)
+        return minSamp;
+    /// radius * (1 - cos(PI / n)) <= maxError
+    double radSamp = std::ceil(M_PI / std::acos(1 - maxError / radius));
+    return static_cast<int>(std::max<double>(minSamp, std::min<double>(maxSamp, radSamp)));
+}
+
+double MeshCreator::GetChordError(double radius, int radSamp) {
+    return radius * (1 - cos(M_PI / radSamp));
+}
+
+std::shared_ptr<PrimitiveTemplate> MeshCreator::BuildTemplate(PrimitiveType type, int radSamp) {
+    auto primitive = std::make_shared<PrimitiveTemplate>();
+    std::shared_ptr<const RingTable> ring = GetRingTable(radSamp);
+    Eigen::MatrixX3d &scaleM = primitive->ScaleM;
+    Eigen::MatrixX3d &factorM = primitive->FactorM;
+    Eigen::MatrixX3i &faceM = primitive->FaceM;
+
+    if (type == PRIMITIVE_CYLINDER) {
+        /// Unit cylinder along the x-axis, scaled by (halfLength, radius, radius)
+        int n = radSamp;
+        scaleM.resize(2 * n + 2, 3);
+        /// Sampled points on the right cap, then on the left cap
+        for (int k = 0; k < 2; k++) {
+            scaleM.col(0).segment(k * n, n).setConstant(k == 0 ? 1 : -1);
+            scaleM.col(1).segment(k * n, n) = ring->CosV.matrix();
+            scaleM.col(2).segment(k * n, n) = ring->SinV.matrix();
+        }
+        /// Center points of the right and left caps
+        scaleM.row(2 * n) << 1, 0, 0;
+        scaleM.row(2 * n + 1) << -1, 0, 0;
+
+        faceM.resize(4 * n, 3);
+        for (int i = 0; i < n; i++) {
+            int i1 = i;
+            int j1 = (i + 1) % n;
+            int i2 = i + n;
+            int j2 = j1 + n;
+            faceM.row(4 * i) << i1, j2, j1;
+            faceM.row(4 * i + 1) << i2, j2, i1;
+            faceM.row(4 * i + 2) << i1, j1, 2 * n;
+            faceM.row(4 * i + 3) << j2, i2, 2 * n + 1;
+        }
+    } else if (type == PRIMITIVE_SPHERE) {
+        /// Unit sphere, scaled by radius; x and y are radius * cos(alpha) times cos/sin(beta)
+        int polarSamp = radSamp / 2;
+        int azimuSamp = radSamp;
+
+        int midNum = (polarSamp - 1) * azimuSamp;
+        scaleM.resize(midNum + 2, 3);
+        factorM.resize(midNum + 2, 3);
+        for (int i = 1; i < polarSamp; i++) {
+            double alpha = M_PI_2 - M_PI * i / polarSamp;
+            int start = (i - 1) * azimuSamp;
+            scaleM.col(0).segment(start, azimuSamp).setConstant(cos(alpha));
+            scaleM.col(1).segment(start, azimuSamp).setConstant(cos(alpha));
+            scaleM.col(2).segment(start, azimuSamp).setConstant(sin(alpha));
+            factorM.col(0).segment(start, azimuSamp) = ring->CosV.matrix();
+            factorM.col(1).segment(start, azimuSamp) = ring->SinV.matrix();
+            factorM.col(2).segment(start, azimuSamp).setOnes();
+        }
+        scaleM.row(midNum) << 0, 0, 1;
+        scaleM.row(midNum + 1) << 0, 0, -1;
+        factorM.bottomRows(2).setOnes();
+
+        faceM.resize(2 * azimuSamp + 2 * azimuSamp * std::max(0, polarSamp - 2), 3);
+        int f = 0;
+        /// Top ring of triangles
+        for (int j = 0; j < azimuSamp; j++) {
+            faceM.row(f++) << midNum, j, (j + 1) % azimuSamp;
+        }
+        /// Middle rings of triangles
+        for (int i = 1; i < polarSamp - 1; i++) {
+            for (int j = 0; j < azimuSamp; j++) {
+                int i1 = (i - 1) * azimuSamp + j;
+                int j1 = (i - 1) * azimuSamp + (j + 1) % azimuSamp;
+                int i2 = i * azimuSamp + j;
+                int j2 = i * azimuSamp + (j + 1) % azimuSamp;
+                faceM.row(f++) << i1, i2, j1;
+                faceM.row(f++) << i2, j2, j1;
+            }
+        }
+        /// Bottom ring of triangles
+        for (int j = 0; j < azimuSamp; j++) {
+            faceM.row(f++) << midNum + 1, midNum - azimuSamp + (j + 1) % azimuSamp, midNum - azimuSamp + j;
+        }
+    } else if (type == PRIMITIVE_CONE) {
+        /// Unit cone along the +x-axis with its base centered at the origin, scaled by (length, radius, radius)
+        int n = radSamp;
+        scaleM.resize(n + 2, 3);
+        /// Sampled points on the base
+        scaleM.col(0).head(n).setZero();
+        scaleM.col(1).head(n) = ring->CosV.matrix();
+        scaleM.col(2).head(n) = ring->SinV.matrix();
+        /// Base center point and apex point
+        scaleM.row(n) << 0, 0, 0;
+        scaleM.row(n + 1) << 1, 0, 0;
+
+        faceM.resize(2 * n, 3);
+        for (int j = 0; j < n; j++) {
+            faceM.row(2 * j) << n, (j + 1) % n, j;
+            faceM.row(2 * j + 1) << n + 1, j, (j + 1) % n;
+        }
+    }
+
+    /// Templates without a factor are only scaled
+    if (factorM.rows() != scaleM.rows())
+        factorM = Eigen::MatrixX3d::Ones(scaleM.rows(), 3);
+    return primitive;
+}
+
+/// ========================================
+///                Primitives
+/// ========================================
+
 Mesh *MeshCreator::CreateCuboid(const Eigen::Vector3d &minPt, const Eigen::Vector3d &maxPt) {
     /// 1. Create a cuboid with the computed size
     Eigen::Vector3d sizeVec = maxPt - minPt;
@@ -96,53 +282,8 @@ Mesh *MeshCreator::CreateCylinder(const Eigen::Vector3d &capCenterA, const Eigen
 }
 
 Mesh *MeshCreator::CreateCylinder(double length, double radius, int radSamp) {
-    std::vector<Eigen::Vector3d> verList;
-    std::vector<Eigen::Vector3i> faceList;
-
-    /// 1. Computer vertices of the cylinder
     double halfLength = 0.5f * length;
-    verList.reserve(2 * radSamp + 2);
-    /// Sampled points on the right cap
-    for (int i = 0; i < radSamp; i++) {
-        double beta = i * 2.0 * M_PI / radSamp;
-
-        double x = halfLength;
-        double y = radius * cos(beta);
-        double z = radius * sin(beta);
-
-        verList.emplace_back(x, y, z);
-    }
-    /// Sampled points on the left cap
-    for (int i = 0; i < radSamp; i++) {
-        double beta = i * 2.0 * M_PI / radSamp;
-
-        double x = -halfLength;
-        double y = radius * cos(beta);
-        double z = radius * sin(beta);
-
-        verList.emplace_back(x, y, z);
-    }
-    /// Center point of the right cap
-    verList.emplace_back(halfLength, 0, 0);
-    /// Center point of the left cap
-    verList.emplace_back(-halfLength, 0, 0);
-
-    /// 2. Computer triangles of the cylinder
-    faceList.reserve(radSamp * 4);
-    for (int i = 0; i < radSamp; i++) {
-        int i1 = i;
-        int j1 = (i + 1) % radSamp;
-        int i2 = i + radSamp;
-        int j2 = j1 + radSamp;
-        faceList.emplace_back(i1, j2, j1);
-        faceList.emplace_back(i2, j2, i1);
-        faceList.emplace_back(i1, j1, 2 * radSamp);
-        faceList.emplace_back(j2, i2, 2 * radSamp + 1);
-    }
-
-    /// 3. Construct a triangular mesh of the cylinder
-    Mesh *mesh = new Mesh(verList, faceList);
-    return mesh;
+    return GetTemplate(PRIMITIVE_CYLINDER, radSamp)->Instantiate(Eigen::Vector3d(halfLength, radius, radius));
 }
 
 Mesh *MeshCreator::CreateSphere(const Eigen::Vector3d &center, double radius, int radSamp) {
@@ -152,56 +293,7 @@ Mesh *MeshCreator::CreateSphere(const Eigen::Vector3d &center, double radius, in
 }
 
 Mesh *MeshCreator::CreateSphere(double radius, int radSamp) {
-    std::vector<Eigen::Vector3d> verList;
-    std::vector<Eigen::Vector3i> faceList;
-
-    int polarSamp = radSamp / 2;
-    int azimuSamp = radSamp;
-
-    /// 1. Compute vertices of the sphere
-    int midNum = (polarSamp - 1) * azimuSamp;
-    verList.reserve(midNum + 2);
-    for (int i = 1; i < polarSamp; i++) {
-        double alpha = M_PI_2 - M_PI * i / polarSamp;
-        for (int j = 0; j < azimuSamp; j++) {
-            double beta = j * 2.0 * M_PI / azimuSamp;
-            double x = radius * cos(alpha) * cos(beta);
-            double y = radius * cos(alpha) * sin(beta);
-            double z = radius * sin(alpha);
-            verList.emplace_back(x, y, z);
-        }
-    }
-    verList.emplace_back(0, 0, radius);
-    verList.emplace_back(0, 0, -radius);
-
-    /// 2. Compute triangles of the sphere
-    faceList.reserve(polarSamp * azimuSamp * 2);
-
-    /// Top ring of triangles
-    for (int j = 0; j < azimuSamp; j++) {
-        faceList.emplace_back(midNum, j, (j + 1) % azimuSamp);
-    }
-
-    /// Middle rings of triangles
-    for (int i = 1; i < polarSamp - 1; i++) {
-        for (int j = 0; j < azimuSamp; j++) {
-            int i1 = (i - 1) * azimuSamp + j;
-            int j1 = (i - 1) * azimuSamp + (j + 1) % azimuSamp;
-            int i2 = i * azimuSamp + j;
-            int j2 = i * azimuSamp + (j + 1) % azimuSamp;
-            faceList.emplace_back(i1, i2, j1);
-            faceList.emplace_back(i2, j2, j1);
-        }
-    }
-
-    /// Bottom ring of triangles
-    for (int j = 0; j < azimuSamp; j++) {
-        faceList.emplace_back(midNum + 1, midNum - azimuSamp + (j + 1) % azimuSamp, midNum - azimuSamp + j);
-    }
-
-    /// 3. Construct a triangular mesh of the sphere
-    Mesh *mesh = new Mesh(verList, faceList);
-    return mesh;
+    return GetTemplate(PRIMITIVE_SPHERE, radSamp)->Instantiate(Eigen::Vector3d(radius, radius, radius));
 }
 
 Mesh *MeshCreator::CreateCone(const Eigen::Vector3d &baseCenter, const Eigen::Vector3d &apexPoint, double radius,
@@ -225,36 +317,7 @@ Mesh *MeshCreator::CreateCone(const Eigen::Vector3d &baseCenter, const Eigen::Ve
 
 Mesh *MeshCreator::CreateCone(double length, double radius, int radSamp) {
     /// Create a cone that is oriented along the +x-axis; its base is centered at the origin
-    std::vector<Eigen::Vector3d> verList;
-    std::vector<Eigen::Vector3i> faceList;
-
-    /// 1. Compute vertices of the cone
-    verList.reserve(radSamp + 2);
-
-    /// Sampled points on the base
-    for (int i = 0; i < radSamp; i++) {
-        double beta = i * 2.0 * M_PI / radSamp;
-        double x = 0;
-        double y = radius * cos(beta);
-        double z = radius * sin(beta);
-        verList.emplace_back(x, y, z);
-    }
-    /// Base center point
-    verList.emplace_back(0, 0, 0);
-    /// Apex point
-    verList.emplace_back(length, 0, 0);
-
-    /// 2. Compute triangles of the cone
-    faceList.reserve(2 * radSamp);
-    /// Triangles of the base
-    for (int j = 0; j < radSamp; j++) {
-        faceList.emplace_back(radSamp, (j + 1) % radSamp, j);
-        faceList.emplace_back(radSamp + 1, j, (j + 1) % radSamp);
-    }
-
-    /// 3. Construct a triangular mesh of the cylinder
-    Mesh *mesh = new Mesh(verList, faceList);
-    return mesh;
+    return GetTemplate(PRIMITIVE_CONE, radSamp)->Instantiate(Eigen::Vector3d(length, radius, radius));
 }
 
 Mesh *MeshCreator::CreateRectangularSurface(const std::vector<Eigen::Vector3d> &verList, int rows, int cols) {
@@ -264,91 +327,170 @@ Mesh *MeshCreator::CreateRectangularSurface(const std::vector<Eigen::Vector3d> &
     if (rows < 2 || cols < 2)
         std::cout << "rows/cols is less than 2!" << std::endl;
 
-    std::vector<Eigen::Vector3i> faceList;
-    faceList.reserve((rows - 1) * (cols - 1));
+    Mesh *mesh = new Mesh();
+    mesh->VerList2VerMat(verList);
+    Eigen::MatrixX3i &faceM = mesh->EditFaceM();
+    faceM.resize(2 * std::max(0, rows - 1) * std::max(0, cols - 1), 3);
+    int f = 0;
     for (int i = 0; i < rows - 1; i++) {
         for (int j = 0; j < cols - 1; j++) {
             int id = i * cols + j;
-            faceList.emplace_back(id, id + cols, id + 1);
-            faceList.emplace_back(id + 1, id + cols, id + cols + 1);
+            faceM.row(f++) << id, id + cols, id + 1;
+            faceM.row(f++) << id + 1, id + cols, id + cols + 1;
         }
     }
-    Mesh *mesh = new Mesh(verList, faceList);
     return mesh;
 }
 
 Mesh *MeshCreator::Create3DCurve(const std::vector<Eigen::Vector3d> &ptList, double radius, int radSamp,
                                  const std::string &type) {
-    int ptNum = static_cast<int>(ptList.size());
-    Eigen::Vector3d center = Eigen::Vector3d::Zero();
-    for (const Eigen::Vector3d &pt: ptList) {
-        center += pt;
-    }
-    center /= ptNum;
+    return CreateTubes({ptList}, radius, radSamp, type);
+}
 
-    std::vector<Eigen::Vector3d> tangentList(ptNum);
-    for (int i = 0; i < ptNum - 1; i++) {
-        int nexti = (i + 1) % ptNum;
-        tangentList[i] = (ptList[nexti] - ptList[i]).normalized();
+/// ========================================
+///               Tube Sweep
+/// ========================================
+
+Mesh *MeshCreator::CreateTubes(const std::vector<std::vector<Eigen::Vector3d>> &curveList, double radius, int radSamp,
+                               const std::string &type) {
+    if (type != "open" && type != "closed") {
+        printf("Type in 'CreateTubes' is invaild!");
+        return new Mesh();
+    }
+    if (radSamp < 3) {
+        std::cout << "radSamp in 'CreateTubes' should be at least 3!" << std::endl;
+        return new Mesh();
+    }
+    bool isOpen = type == "open";
+
+    /// 1. Prefix-sum the vertex and face numbers of the tubes. Curves too short to enclose a volume are
+    ///    skipped: an open tube needs 2 points, a closed one 3 (2 points would go back and forth on one segment).
+    int curveNum = static_cast<int>(curveList.size());
+    size_t minPtNum = isOpen ? 2 : 3;
+    std::vector<long> verOffset(curveNum + 1, 0);
+    std::vector<long> faceOffset(curveNum + 1, 0);
+    int skipNum = 0;
+    for (int i = 0; i < curveNum; i++) {
+        long ptNum = static_cast<long>(curveList[i].size());
+        long segNum = isOpen ? ptNum - 1 : ptNum;
+        bool isValid = curveList[i].size() >= minPtNum;
+        skipNum += isValid ? 0 : 1;
+        verOffset[i + 1] = verOffset[i] + (isValid ? ptNum * radSamp + (isOpen ? 2 : 0) : 0);
+        faceOffset[i + 1] = faceOffset[i] + (isValid ? 2 * segNum * radSamp + (isOpen ? 2 * radSamp : 0) : 0);
     }
-    tangentList[ptNum - 1] = (ptList[ptNum - 1] - ptList[ptNum - 2]).normalized();
+    if (skipNum > 0)
+        std::cout << skipNum << " curves with less than " << minPtNum << " points are skipped in 'CreateTubes'!" << std::endl;
+
+    /// 2. Allocate one mesh and sweep the tubes into it in parallel
+    std::shared_ptr<const RingTable> ring = GetRingTable(radSamp);
+    Mesh *mesh = new Mesh();
+    Eigen::MatrixX3d &verM = mesh->EditVerM();
+    Eigen::MatrixX3i &faceM = mesh->EditFaceM();
+    verM.resize(verOffset[curveNum], 3);
+    faceM.resize(faceOffset[curveNum], 3);
+    igl::parallel_for(curveNum, [&](int i) {
+        if (curveList[i].size() >= minPtNum)
+            SweepTube(curveList[i], radius, *ring, isOpen, verOffset[i], faceOffset[i], verM, faceM);
+    }, 16);
+    return mesh;
+}
+
+/// Rotation-minimizing frames by double reflection (Wang et al. 2008), which do not twist on non-planar
+/// curves. For a closed curve the remaining twist between the last and the first frame is spread evenly.
+void MeshCreator::ComputeCurveFrames(const std::vector<Eigen::Vector3d> &ptList, bool isOpen,
+                                     std::vector<Eigen::Vector3d> &tangentList, std::vector<Eigen::Vector3d> &normalList) {
+    int ptNum = static_cast<int>(ptList.size());
+    tangentList.resize(ptNum);
+    normalList.resize(ptNum);
 
-    std::vector<Eigen::Vector3d> normalList(ptNum), binormalList(ptNum);
+    /// 1. Tangents: central differences, one-sided at the ends of an open curve
     for (int i = 0; i < ptNum; i++) {
-        Eigen::Vector3d normal = ptList[i] - center;
-        normal = normal - normal.dot(tangentList[i]) * tangentList[i];
-        normalList[i] = normal.normalized();
+        int prev = (i == 0) ? (isOpen ? 0 : ptNum - 1) : i - 1;
+        int next = (i == ptNum - 1) ? (isOpen ? ptNum - 1 : 0) : i + 1;
+        Eigen::Vector3d tangent = ptList[next] - ptList[prev];
+        tangentList[i] = tangent.norm() > 0 ? tangent.normalized() : Eigen::Vector3d(1, 0, 0);
+    }
 
-        Eigen::Vector3d binormal = tangentList[i].cross(normalList[i]);
-        binormalList[i] = binormal.normalized();
+    /// 2. Initial normal: perpendicular to the first tangent
+    int minAxis;
+    tangentList[0].cwiseAbs().minCoeff(&minAxis);
+    Eigen::Vector3d axis = Eigen::Vector3d::Unit(minAxis);
+    normalList[0] = tangentList[0].cross(axis).normalized();
+
+    /// 3. Propagate the frame by two reflections per segment
+    auto propagate = [&](const Eigen::Vector3d &normal, int i, int j) -> Eigen::Vector3d {
+        Eigen::Vector3d v1 = ptList[j] - ptList[i];
+        double c1 = v1.dot(v1);
+        if (c1 == 0)
+            return normal;
+        Eigen::Vector3d normalL = normal - (2 / c1) * v1.dot(normal) * v1;
+        Eigen::Vector3d tangentL = tangentList[i] - (2 / c1) * v1.dot(tangentList[i]) * v1;
+        Eigen::Vector3d v2 = tangentList[j] - tangentL;
+        double c2 = v2.dot(v2);
+        Eigen::Vector3d newNormal = c2 == 0 ? normalL : Eigen::Vector3d(normalL - (2 / c2) * v2.dot(normalL) * v2);
+        /// Remove the drift off the plane of the tangent
+        newNormal -= newNormal.dot(tangentList[j]) * tangentList[j];
+        return newNormal.normalized();
+    };
+    for (int i = 0; i < ptNum - 1; i++)
+        normalList[i + 1] = propagate(normalList[i], i, i + 1);
+
+    /// 4. Close the frames of a closed curve
+    if (!isOpen) {
+        Eigen::Vector3d closeNormal = propagate(normalList[ptNum - 1], ptNum - 1, 0);
+        double angle = atan2(tangentList[0].dot(closeNormal.cross(normalList[0])), closeNormal.dot(normalList[0]));
+        for (int i = 1; i < ptNum; i++) {
+            Eigen::AngleAxisd rotation(angle * i / ptNum, tangentList[i]);
+            normalList[i] = rotation * normalList[i];
+        }
     }
+}
 
-    std::vector<Eigen::Vector3d> verList;
-    verList.reserve(ptNum * radSamp + 2);
+void MeshCreator::SweepTube(const std::vector<Eigen::Vector3d> &ptList, double radius, const RingTable &ring,
+                            bool isOpen, long verOffset, long faceOffset, Eigen::MatrixX3d &verM, Eigen::MatrixX3i &faceM) {
+    int ptNum = static_cast<int>(ptList.size());
+    int radSamp = static_cast<int>(ring.CosV.size());
+
+    std::vector<Eigen::Vector3d> tangentList, normalList;
+    ComputeCurveFrames(ptList, isOpen, tangentList, normalList);
+
+    /// 1. Rings of the tube
     for (int i = 0; i < ptNum; i++) {
-        for (int j = 0; j < radSamp; j++) {
-            double theta = j * 2 * M_PI / radSamp;
-            Eigen::Vector3d EnvPt = ptList[i] + radius * (normalList[i] * cos(theta) + binormalList[i] * sin(theta));
-            verList.emplace_back(EnvPt);
+        Eigen::Vector3d binormal = tangentList[i].cross(normalList[i]);
+        for (int k = 0; k < 3; k++) {
+            verM.col(k).segment(verOffset + i * radSamp, radSamp) =
+                    ptList[i](k) + radius * (normalList[i](k) * ring.CosV + binormal(k) * ring.SinV);
         }
     }
-    if (type == "open") {
-        verList.emplace_back(ptList[0]);
-        verList.emplace_back(ptList[ptNum - 1]);
+    int startCenter = ptNum * radSamp;
+    int endCenter = startCenter + 1;
+    if (isOpen) {
+        verM.row(verOffset + startCenter) = ptList[0].transpose();
+        verM.row(verOffset + endCenter) = ptList[ptNum - 1].transpose();
     }
 
-    std::vector<Eigen::Vector3d> faceList;
-    int maxFaceNum;
-    if (type == "closed")
-        maxFaceNum = ptNum;
-    else if (type == "open")
-        maxFaceNum = ptNum - 1;
-    else {
-        maxFaceNum = -1;
-        printf("Type in 'Create3DCurve' is invaild!");
-    }
-
-    faceList.reserve(maxFaceNum * radSamp + radSamp);
-    for (int i = 0; i < maxFaceNum; i++) {
+    /// 2. Faces of the tube (and fans of the two caps if open), indices relative to the tube
+    int segNum = isOpen ? ptNum - 1 : ptNum;
+    long f = faceOffset;
+    int base = static_cast<int>(verOffset);
+    for (int i = 0; i < segNum; i++) {
         for (int j = 0; j < radSamp; j++) {
             int i1 = i * radSamp;
             int i2 = (i1 + radSamp) % (ptNum * radSamp);
             int j1 = j;
             int j2 = (j + 1) % radSamp;
-            faceList.emplace_back(i1 + j1, i2 + j2, i2 + j1);
-            faceList.emplace_back(i1 + j1, i1 + j2, i2 + j2);
+            faceM.row(f++) << base + i1 + j1, base + i2 + j2, base + i2 + j1;
+            faceM.row(f++) << base + i1 + j1, base + i1 + j2, base + i2 + j2;
         }
     }
 
-    if (type == "open") {
+    if (isOpen) {
+        int last = (ptNum - 1) * radSamp;
         for (int j = 0; j < radSamp; j++) {
-            int i = ptNum * radSamp;
             int j1 = j;
             int j2 = (j + 1) % radSamp;
-            faceList.emplace_back(i, j2, j1);
-
-            i = (ptNum - 1) * radSamp;
-            faceList.emplace_back(i, i + j1, i + j2);
+            faceM.row(f++) << base + startCenter, base + j2, base + j1;
+            faceM.row(f++) << base + endCenter, base + last + j1, base + last + j2;
         }
     }
-}
\ No newline at end of file
+}
@@ -13,8 +13,32 @@
 #ifndef MESHCREATOR_H
 #define MESHCREATOR_H
 
+#include <memory>
+
 #include "Mesh/Mesh.h"
 
+/// Primitives cached by the template library of MeshCreator
+enum PrimitiveType {
+    PRIMITIVE_CYLINDER,
+    PRIMITIVE_SPHERE,
+    PRIMITIVE_CONE
+};
+
+/// A unit primitive: vertex (i,j) of an instance is scaleVec(j) * ScaleM(i,j) * FactorM(i,j)
+struct PrimitiveTemplate {
+    Eigen::MatrixX3d ScaleM;
+    Eigen::MatrixX3d FactorM;
+    Eigen::MatrixX3i FaceM;
+
+    Mesh *Instantiate(const Eigen::Vector3d &scaleVec) const;
+};
+
+/// cos/sin of the angles i * 2 * PI / radSamp, shared by all generators with radSamp samples per ring
+struct RingTable {
+    Eigen::ArrayXd CosV;
+    Eigen::ArrayXd SinV;
+};
+
 class MeshCreator {
 public:
     MeshCreator() = default;
@@ -41,6 +65,31 @@ public:
 
     /// 3D curve
     static Mesh* Create3DCurve(const std::vector<Eigen::Vector3d> &ptList, double radius, int radSamp, const std::string &type);
+
+    /// Tubes of many polylines swept in parallel into one mesh; type is "open" (capped) or "closed".
+    /// radSamp must be at least 3; curves with less than 2 (open) or 3 (closed) points are skipped.
+    static Mesh* CreateTubes(const std::vector<std::vector<Eigen::Vector3d>> &curveList, double radius, int radSamp,
+                             const std::string &type);
+
+    /// Thread-safe library of unit primitives, built once per (type, radSamp)
+    static std::shared_ptr<const PrimitiveTemplate> GetTemplate(PrimitiveType type, int radSamp);
+    static void ClearTemplates();
+
+    static std::shared_ptr<const RingTable> GetRingTable(int radSamp);
+
+    /// Ring samples needed for the chord error of a circle of the radius to stay below maxError
+    /// (e.g. a screen-space error converted to object space)
+    static int GetRadSamp(double radius, double maxError, int minSamp = 3, int maxSamp = 256);
+    /// Largest distance between a circle of the radius and its polygon of radSamp samples
+    static double GetChordError(double radius, int radSamp);
+
+private:
+    static std::shared_ptr<PrimitiveTemplate> BuildTemplate(PrimitiveType type, int radSamp);
+
+    static void ComputeCurveFrames(const std::vector<Eigen::Vector3d> &ptList, bool isOpen,
+                                   std::vector<Eigen::Vector3d> &tangentList, std::vector<Eigen::Vector3d> &normalList);
+    static void SweepTube(const std::vector<Eigen::Vector3d> &ptList, double radius, const RingTable &ring, bool isOpen,
+                          long verOffset, long faceOffset, Eigen::MatrixX3d &verM, Eigen::MatrixX3i &faceM);
 };
 
 
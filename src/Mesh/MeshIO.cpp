@@ -0,0 +1,589 @@
+/// ========================================
+///
+///     MeshIO.cpp
+///
+///     Fast mesh file reading and writing
+///
+/// ========================================
+
+#include "MeshIO.h"
+
+#include <vector>
+#include <thread>
+#include <future>
+#include <fstream>
+#include <iostream>
+#include <charconv>
+#include <cstring>
+#include <cstdlib>
+#include <limits>
+#include <filesystem>
+#include <igl/parallel_for.h>
+
+#include "Utility/HelpFunc.h"
+
+#ifndef _WIN32
+#include <cerrno>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+bool MeshIO::UseSidecarCache = true;
+
+namespace {
+    /// Chunks smaller than this are not worth a thread
+    const size_t MinChunkSize = 1 << 20;
+
+    inline bool IsBlank(char c) {
+        return c == ' ' || c == '\t' || c == '\r';
+    }
+
+    inline const char *SkipBlank(const char *p, const char *end) {
+        while (p < end && IsBlank(*p)) p++;
+        return p;
+    }
+
+    inline const char *NextLine(const char *p, const char *end) {
+        const void *newline = std::memchr(p, '\n', end - p);
+        return newline ? static_cast<const char *>(newline) + 1 : end;
+    }
+
+    inline const char *ParseDoubleSlow(const char *p, const char *end, double &value) {
+        char token[128];
+        size_t length = 0;
+        while (p + length < end && length < sizeof(token) - 1 && !IsBlank(p[length]) && p[length] != '\n') length++;
+        std::memcpy(token, p, length);
+        token[length] = '\0';
+        char *tokenEnd;
+        value = std::strtod(token, &tokenEnd);
+        return tokenEnd == token ? nullptr : p + (tokenEnd - token);
+    }
+
+    /// Correctly rounded, like the sscanf("%lf") of igl::readOBJ
+    inline const char *ParseDouble(const char *p, const char *end, double &value) {
+#if defined(__cpp_lib_to_chars)
+        const char *q = (p < end && *p == '+') ? p + 1 : p;
+        std::from_chars_result result = std::from_chars(q, end, value);
+        if (result.ec == std::errc())
+            return result.ptr;
+#endif
+        /// Out-of-range values (and compilers without a floating-point from_chars) go through strtod
+        return ParseDoubleSlow(p, end, value);
+    }
+
+    inline const char *ParseInt(const char *p, const char *end, long &value) {
+        std::from_chars_result result = std::from_chars(p, end, value);
+        if (result.ec != std::errc()) return nullptr;
+        return result.ptr;
+    }
+
+    /// Line types that matter for the vertices and faces
+    inline bool IsVertexLine(const char *p, const char *end) {
+        return p + 1 < end && p[0] == 'v' && IsBlank(p[1]);
+    }
+
+    inline bool IsFaceLine(const char *p, const char *end) {
+        return p + 1 < end && p[0] == 'f' && IsBlank(p[1]);
+    }
+
+    /// Number of corners of a face line (p points after the 'f')
+    inline int CountCorners(const char *p, const char *end) {
+        int cornerNum = 0;
+        while (true) {
+            p = SkipBlank(p, end);
+            if (p >= end || *p == '\n' || *p == '#') break;
+            cornerNum++;
+            while (p < end && !IsBlank(*p) && *p != '\n') p++;
+        }
+        return cornerNum;
+    }
+
+    /// Read-only view of a whole file: regular files are memory-mapped, pipes (and platforms
+    /// without mmap) are read as a stream into a buffer
+    class MappedFile {
+    private:
+        const char *data = nullptr;
+        size_t size = 0;
+        bool isOpen = false;
+        bool isMapped = false;
+        std::string buffer;
+
+    public:
+        explicit MappedFile(const std::string &fileName) {
+#ifndef _WIN32
+            int fd = open(fileName.c_str(), O_RDONLY);
+            if (fd < 0)
+                return;
+            struct stat fileStat{};
+            if (fstat(fd, &fileStat) == 0 && S_ISREG(fileStat.st_mode)) {
+                size = static_cast<size_t>(fileStat.st_size);
+                void *map = size > 0 ? mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0) : MAP_FAILED;
+                if (map != MAP_FAILED) {
+                    madvise(map, size, MADV_SEQUENTIAL);
+                    data = static_cast<const char *>(map);
+                    isMapped = true;
+                    isOpen = true;
+                    close(fd);
+                    return;
+                }
+            }
+
+            /// Read the descriptor that is already open: a pipe or FIFO cannot be opened a second time
+            std::vector<char> block(1 << 20);
+            while (true) {
+                ssize_t readSize = read(fd, block.data(), block.size());
+                if (readSize < 0 && errno == EINTR)
+                    continue;
+                if (readSize < 0) {
+                    close(fd);
+                    return;
+                }
+                if (readSize == 0)
+                    break;
+                buffer.append(block.data(), static_cast<size_t>(readSize));
+            }
+            close(fd);
+#else
+            std::ifstream file(fileName, std::ios::binary);
+            if (!file.is_open())
+                return;
+            std::vector<char> block(1 << 20);
+            while (file) {
+                file.read(block.data(), static_cast<std::streamsize>(block.size()));
+                buffer.append(block.data(), static_cast<size_t>(file.gcount()));
+            }
+#endif
+            data = buffer.data();
+            size = buffer.size();
+            isOpen = true;
+        }
+
+        ~MappedFile() {
+#ifndef _WIN32
+            if (isMapped)
+                munmap(const_cast<char *>(data), size);
+#endif
+        }
+
+        MappedFile(const MappedFile &) = delete;
+        MappedFile &operator=(const MappedFile &) = delete;
+
+        bool IsOpen() const { return isOpen; }
+        const char *GetData() const { return data; }
+        size_t GetSize() const { return size; }
+    };
+
+    /// Header of the binary mesh format (64 bytes)
+    struct BinaryHeader {
+        char magic[8];          // "MESHBIN"
+        uint32_t version;
+        uint32_t endianTag;     // BinaryEndianTag as written by the host
+        int64_t verNum;
+        int64_t faceNum;
+        int64_t sourceSize;     // size of the source OBJ of a sidecar (-1 otherwise)
+        int64_t sourceTime;     // last write time of the source OBJ
+        uint64_t sourceHash;    // content hash of the source OBJ
+        uint64_t reserved;
+    };
+    static_assert(sizeof(BinaryHeader) == 64, "BinaryHeader must be 64 bytes");
+
+    const char BinaryMagic[8] = {'M', 'E', 'S', 'H', 'B', 'I', 'N', '\0'};
+    const uint32_t BinaryVersion = 1;
+    const uint32_t BinaryEndianTag = 0x01020304;
+    const size_t BinaryAlignment = 64;
+
+    inline size_t AlignUp(size_t offset) {
+        return (offset + BinaryAlignment - 1) / BinaryAlignment * BinaryAlignment;
+    }
+
+    /// The counts of a valid header fit in an int (the index type of the face matrix), so the sizes
+    /// below cannot overflow 64 bits
+    inline uint64_t GetIndexBlockOffset(int64_t verNum) {
+        return AlignUp(sizeof(BinaryHeader) + 3 * static_cast<uint64_t>(verNum) * sizeof(double));
+    }
+
+    inline uint64_t GetBinarySize(int64_t verNum, int64_t faceNum) {
+        return GetIndexBlockOffset(verNum) + 3 * static_cast<uint64_t>(faceNum) * sizeof(int32_t);
+    }
+
+    bool IsValidHeader(const BinaryHeader &header) {
+        return std::memcmp(header.magic, BinaryMagic, 8) == 0 && header.version == BinaryVersion &&
+               header.endianTag == BinaryEndianTag && header.verNum >= 0 && header.faceNum >= 0 &&
+               header.verNum <= std::numeric_limits<int>::max() && header.faceNum <= std::numeric_limits<int>::max();
+    }
+
+    bool ReadHeader(const std::string &fileName, BinaryHeader &header) {
+        std::ifstream file(fileName, std::ios::binary);
+        file.read(reinterpret_cast<char *>(&header), sizeof(header));
+        return file && IsValidHeader(header);
+    }
+
+    bool WriteBinaryFile(const std::string &fileName, const Eigen::MatrixX3d &verM, const Eigen::MatrixX3i &faceM,
+                         const BinaryHeader &stamp) {
+        BinaryHeader header = stamp;
+        std::memcpy(header.magic, BinaryMagic, 8);
+        header.version = BinaryVersion;
+        header.endianTag = BinaryEndianTag;
+        header.verNum = verM.rows();
+        header.faceNum = faceM.rows();
+
+        /// Write to a temporary file of this writer first, so that a concurrent reader (or writer) never sees
+        /// a partial file
+        std::string tmpName = GetUniqueTempPath(fileName);
+        bool isWritten;
+        {
+            std::ofstream file(tmpName, std::ios::binary);
+            if (!file.is_open())
+                return false;
+
+            std::vector<char> padding(BinaryAlignment, 0);
+            size_t verBlockEnd = sizeof(BinaryHeader) + verM.size() * sizeof(double);
+            file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+            file.write(reinterpret_cast<const char *>(verM.data()), static_cast<std::streamsize>(verM.size() * sizeof(double)));
+            file.write(padding.data(), static_cast<std::streamsize>(GetIndexBlockOffset(header.verNum) - verBlockEnd));
+            file.write(reinterpret_cast<const char *>(faceM.data()), static_cast<std::streamsize>(faceM.size() * sizeof(int32_t)));
+            file.close();
+            isWritten = !file.fail();
+        }
+
+        std::error_code error;
+        if (isWritten)
+            std::filesystem::rename(tmpName, fileName, error);
+        if (!isWritten || error) {
+            std::error_code removeError;
+            std::filesystem::remove(tmpName, removeError);
+            return false;
+        }
+        return true;
+    }
+
+    bool GetSourceStamp(const std::string &fileName, int64_t &sourceSize, int64_t &sourceTime) {
+        std::error_code error;
+        sourceSize = static_cast<int64_t>(std::filesystem::file_size(fileName, error));
+        if (error)
+            return false;
+        sourceTime = std::filesystem::last_write_time(fileName, error).time_since_epoch().count();
+        return !error;
+    }
+
+    /// Rows formatted by one task, and rows formatted before each write to the file
+    const long FormatBlockSize = 16384;
+    const long WriteBatchSize = 1 << 18;
+
+    /// Longest text of an OBJ line: a shortest round-trip double takes at most 24 characters
+    const size_t MaxVertexLineSize = 2 + 3 * 25;
+    const size_t MaxFaceLineSize = 2 + 3 * 12;
+
+    /// Format rows in parallel blocks into large buffers, written to the file in order
+    template <typename FormatRow>
+    bool WriteRows(std::ofstream &file, long rowNum, size_t maxLineSize, const FormatRow &formatRow) {
+        std::vector<std::string> bufferList;
+        for (long batch = 0; batch < rowNum; batch += WriteBatchSize) {
+            long batchEnd = std::min(rowNum, batch + WriteBatchSize);
+            long blockNum = (batchEnd - batch + FormatBlockSize - 1) / FormatBlockSize;
+            bufferList.resize(blockNum);
+            igl::parallel_for(blockNum, [&](long b) {
+                long start = batch + b * FormatBlockSize;
+                long end = std::min(batchEnd, start + FormatBlockSize);
+                std::string &buffer = bufferList[b];
+                buffer.resize((end - start) * maxLineSize);
+                char *p = &buffer[0];
+                for (long i = start; i < end; i++)
+                    p = formatRow(p, i);
+                buffer.resize(p - buffer.data());
+            }, 1);
+
+            for (long b = 0; b < blockNum; b++)
+                file.write(bufferList[b].data(), static_cast<std::streamsize>(bufferList[b].size()));
+        }
+        return static_cast<bool>(file);
+    }
+
+    /// Write fileName + ".mbin" stamped with the just written OBJ, so that ReadMesh uses it directly
+    void WriteSidecar(const std::string &fileName, const Eigen::MatrixX3d &verM, const Eigen::MatrixX3i &faceM) {
+        BinaryHeader stamp{};
+        MappedFile file(fileName);
+        if (!file.IsOpen() || !GetSourceStamp(fileName, stamp.sourceSize, stamp.sourceTime))
+            return;
+        stamp.sourceHash = HashBytes(file.GetData(), file.GetSize());
+        if (!WriteBinaryFile(MeshIO::GetSidecarName(fileName), verM, faceM, stamp))
+            std::cout << "Cannot write file: " << MeshIO::GetSidecarName(fileName) << std::endl;
+    }
+
+    struct OBJChunk {
+        const char *begin;
+        const char *end;
+        long verNum = 0;
+        long faceNum = 0;
+        long verOffset = 0;
+        long faceOffset = 0;
+        bool isValid = true;
+    };
+}
+
+/// ========================================
+///                 Read
+/// ========================================
+
+bool MeshIO::ReadOBJ(const std::string &fileName, Eigen::MatrixX3d &verM, Eigen::MatrixX3i &faceM) {
+    MappedFile file(fileName);
+    if (!file.IsOpen()) {
+        std::cout << "Cannot open file: " << fileName << std::endl;
+        return false;
+    }
+    return ParseOBJ(file.GetData(), file.GetSize(), verM, faceM);
+}
+
+/// ========================================
+///                 Write
+/// ========================================
+
+bool MeshIO::WriteOBJ(const std::string &fileName, const Eigen::MatrixX3d &verM, const Eigen::MatrixX3i &faceM,
+                      bool writeBinary) {
+    {
+        std::ofstream file(fileName, std::ios::binary);
+        if (!file.is_open()) {
+            std::cout << "Cannot write file: " << fileName << std::endl;
+            return false;
+        }
+
+        bool isWritten = WriteRows(file, verM.rows(), MaxVertexLineSize, [&](char *p, long i) {
+            *p++ = 'v';
+            for (int j = 0; j < 3; j++) {
+                *p++ = ' ';
+                p = std::to_chars(p, p + 24, verM(i, j)).ptr;
+            }
+            *p++ = '\n';
+            return p;
+        });
+        isWritten = isWritten && WriteRows(file, faceM.rows(), MaxFaceLineSize, [&](char *p, long i) {
+            *p++ = 'f';
+            for (int j = 0; j < 3; j++) {
+                *p++ = ' ';
+                p = std::to_chars(p, p + 11, faceM(i, j) + 1).ptr;
+            }
+            *p++ = '\n';
+            return p;
+        });
+        if (!isWritten) {
+            std::cout << "Cannot write file: " << fileName << std::endl;
+            return false;
+        }
+    }
+
+    if (writeBinary)
+        WriteSidecar(fileName, verM, faceM);
+    return true;
+}
+
+std::future<bool> MeshIO::WriteOBJAsync(const std::string &fileName, Eigen::MatrixX3d verM, Eigen::MatrixX3i faceM,
+                                        bool writeBinary) {
+    return std::async(std::launch::async,
+                      [fileName, verM = std::move(verM), faceM = std::move(faceM), writeBinary]() {
+        return WriteOBJ(fileName, verM, faceM, writeBinary);
+    });
+}
+
+/// ========================================
+///              Binary Format
+/// ========================================
+
+bool MeshIO::ReadBinary(const std::string &fileName, Eigen::MatrixX3d &verM, Eigen::MatrixX3i &faceM) {
+    MappedFile file(fileName);
+    if (!file.IsOpen()) {
+        std::cout << "Cannot open file: " << fileName << std::endl;
+        return false;
+    }
+
+    BinaryHeader header{};
+    if (file.GetSize() < sizeof(header))
+        return false;
+    std::memcpy(&header, file.GetData(), sizeof(header));
+    if (!IsValidHeader(header) || file.GetSize() != GetBinarySize(header.verNum, header.faceNum)) {
+        std::cout << "Invalid binary mesh file: " << fileName << std::endl;
+        return false;
+    }
+
+    /// The blocks already have the layout of the Eigen matrices: one copy out of the mapping
+    const char *verBlock = file.GetData() + sizeof(BinaryHeader);
+    const char *indexBlock = file.GetData() + GetIndexBlockOffset(header.verNum);
+    Eigen::Map<const Eigen::MatrixX3i> indexMap(reinterpret_cast<const int32_t *>(indexBlock), header.faceNum, 3);
+    if (header.faceNum > 0 && (indexMap.minCoeff() < 0 || indexMap.maxCoeff() >= header.verNum)) {
+        std::cout << "Face index out of range in binary mesh file: " << fileName << std::endl;
+        return false;
+    }
+    verM = Eigen::Map<const Eigen::MatrixX3d>(reinterpret_cast<const double *>(verBlock), header.verNum, 3);
+    faceM = indexMap;
+    return true;
+}
+
+bool MeshIO::WriteBinary(const std::string &fileName, const Eigen::MatrixX3d &verM, const Eigen::MatrixX3i &faceM) {
+    BinaryHeader stamp{};
+    stamp.sourceSize = -1;
+    if (!WriteBinaryFile(fileName, verM, faceM, stamp)) {
+        std::cout << "Cannot write file: " << fileName << std::endl;
+        return false;
+    }
+    return true;
+}
+
+/// ========================================
+///            Cached Mesh Reading
+/// ========================================
+
+std::string MeshIO::GetSidecarName(const std::string &fileName) {
+    return fileName + ".mbin";
+}
+
+bool MeshIO::ReadMesh(const std::string &fileName, Eigen::MatrixX3d &verM, Eigen::MatrixX3i &faceM) {
+    std::filesystem::path path(fileName);
+    if (path.extension() == ".mbin")
+        return ReadBinary(fileName, verM, faceM);
+
+    /// Pipes and other special files have no stable stamp to validate a sidecar against
+    std::error_code error;
+    if (!UseSidecarCache || !std::filesystem::is_regular_file(path, error))
+        return ReadOBJ(fileName, verM, faceM);
+
+    int64_t sourceSize, sourceTime;
+    if (!GetSourceStamp(fileName, sourceSize, sourceTime))
+        return ReadOBJ(fileName, verM, faceM);
+
+    /// 1. A sidecar with the same size and write time is used without touching the source
+    std::string sidecarName = GetSidecarName(fileName);
+    BinaryHeader header{};
+    bool hasSidecar = ReadHeader(sidecarName, header);
+    if (hasSidecar && header.sourceSize == sourceSize && header.sourceTime == sourceTime &&
+        ReadBinary(sidecarName, verM, faceM))
+        return true;
+
+    MappedFile file(fileName);
+    if (!file.IsOpen()) {
+        std::cout << "Cannot open file: " << fileName << std::endl;
+        return false;
+    }
+    uint64_t sourceHash = HashBytes(file.GetData(), file.GetSize());
+
+    /// 2. A touched but unchanged source (same content hash) still uses the sidecar
+    bool isSidecarValid = hasSidecar && header.sourceSize == sourceSize && header.sourceHash == sourceHash &&
+                          ReadBinary(sidecarName, verM, faceM);
+
+    /// 3. Otherwise parse the OBJ
+    if (!isSidecarValid && !ParseOBJ(file.GetData(), file.GetSize(), verM, faceM))
+        return false;
+
+    /// Write (or re-stamp) the sidecar; failing to write it, e.g. in a read-only directory, is not an error
+    BinaryHeader stamp{};
+    stamp.sourceSize = sourceSize;
+    stamp.sourceTime = sourceTime;
+    stamp.sourceHash = sourceHash;
+    WriteBinaryFile(sidecarName, verM, faceM, stamp);
+    return true;
+}
+
+/// ========================================
+///               OBJ Parser
+/// ========================================
+
+bool MeshIO::ParseOBJ(const char *data, size_t size, Eigen::MatrixX3d &verM, Eigen::MatrixX3i &faceM) {
+    const char *dataEnd = data + size;
+
+    /// 1. Split the data into chunks at line boundaries
+    size_t threadNum = std::max(1u, std::thread::hardware_concurrency());
+    size_t chunkNum = std::max<size_t>(1, std::min(threadNum, size / MinChunkSize));
+    std::vector<OBJChunk> chunkList;
+    const char *begin = data;
+    for (size_t i = 0; i < chunkNum && begin < dataEnd; i++) {
+        const char *end = (i + 1 == chunkNum) ? dataEnd : std::max(begin, data + (i + 1) * size / chunkNum);
+        if (end < dataEnd)
+            end = NextLine(end, dataEnd);
+        chunkList.push_back({begin, end});
+        begin = end;
+    }
+
+    /// 2. Count the vertices and triangles of each chunk, then prefix-sum them
+    igl::parallel_for(static_cast<int>(chunkList.size()), [&](int c) {
+        OBJChunk &chunk = chunkList[c];
+        for (const char *line = chunk.begin; line < chunk.end; line = NextLine(line, chunk.end)) {
+            const char *p = SkipBlank(line, chunk.end);
+            if (IsVertexLine(p, chunk.end))
+                chunk.verNum++;
+            else if (IsFaceLine(p, chunk.end))
+                chunk.faceNum += std::max(0, CountCorners(p + 1, chunk.end) - 2);
+        }
+    }, 2);
+
+    long verNum = 0, faceNum = 0;
+    for (OBJChunk &chunk: chunkList) {
+        chunk.verOffset = verNum;
+        chunk.faceOffset = faceNum;
+        verNum += chunk.verNum;
+        faceNum += chunk.faceNum;
+    }
+    verM.resize(verNum, 3);
+    faceM.resize(faceNum, 3);
+
+    /// 3. Parse every chunk straight into its rows of verM and faceM
+    igl::parallel_for(static_cast<int>(chunkList.size()), [&](int c) {
+        OBJChunk &chunk = chunkList[c];
+        long verID = chunk.verOffset;
+        long faceID = chunk.faceOffset;
+        std::vector<long> corners;
+        for (const char *line = chunk.begin; line < chunk.end && chunk.isValid; line = NextLine(line, chunk.end)) {
+            const char *p = SkipBlank(line, chunk.end);
+            if (IsVertexLine(p, chunk.end)) {
+                /// "v x y z [w]"
+                p++;
+                for (int k = 0; k < 3; k++) {
+                    p = ParseDouble(SkipBlank(p, chunk.end), chunk.end, verM(verID, k));
+                    if (p == nullptr) {
+                        std::cout << "Error: vertex should have 3 or 4 coordinates in 'MeshIO::ReadOBJ' !" << std::endl;
+                        chunk.isValid = false;
+                        break;
+                    }
+                }
+                verID++;
+            } else if (IsFaceLine(p, chunk.end)) {
+                /// "f v v v ...", "f v/vt ...", "f v/vt/vn ...", "f v//vn ..."; only v is used
+                p++;
+                corners.clear();
+                while (true) {
+                    p = SkipBlank(p, chunk.end);
+                    if (p >= chunk.end || *p == '\n' || *p == '#') break;
+                    long index;
+                    const char *next = ParseInt(p, chunk.end, index);
+                    if (next == nullptr || index == 0) {
+                        std::cout << "Error: invalid face index in 'MeshIO::ReadOBJ' !" << std::endl;
+                        chunk.isValid = false;
+                        break;
+                    }
+                    /// Negative indices are relative to the vertices read so far
+                    long corner = index < 0 ? verID + index : index - 1;
+                    if (corner < 0 || corner >= verNum) {
+                        std::cout << "Error: face index out of range in 'MeshIO::ReadOBJ' !" << std::endl;
+                        chunk.isValid = false;
+                        break;
+                    }
+                    corners.push_back(corner);
+                    p = next;
+                    while (p < chunk.end && !IsBlank(*p) && *p != '\n') p++;
+                }
+                /// Polygons are fan-triangulated from their first corner
+                for (int k = 1; k + 1 < corners.size(); k++) {
+                    faceM(faceID, 0) = static_cast<int>(corners[0]);
+                    faceM(faceID, 1) = static_cast<int>(corners[k]);
+                    faceM(faceID, 2) = static_cast<int>(corners[k + 1]);
+                    faceID++;
+                }
+            }
+        }
+    }, 2);
+
+    for (const OBJChunk &chunk: chunkList) {
+        if (!chunk.isValid)
+            return false;
+    }
+    return true;
+}
@@ -0,0 +1,56 @@
+/// ========================================
+///
+///     MeshIO.h
+///
+///     Fast mesh file reading and writing
+///
+/// ========================================
+
+#ifndef MESHIO_H
+#define MESHIO_H
+
+#include <string>
+#include <future>
+#include <Eigen/Core>
+
+class MeshIO {
+public:
+    /// Write a binary sidecar the first time an OBJ is read by ReadMesh, and reuse it afterwards
+    static bool UseSidecarCache;
+
+public:
+    MeshIO() = default;
+    ~MeshIO() = default;
+
+    /// Read the vertices and (fan-triangulated) faces of an OBJ file, same results as igl::readOBJ.
+    /// Regular files are memory-mapped and parsed in parallel chunks; pipes are read as a stream.
+    static bool ReadOBJ(const std::string &fileName, Eigen::MatrixX3d &verM, Eigen::MatrixX3i &faceM);
+
+    /// Parse an OBJ held in memory
+    static bool ParseOBJ(const char *data, size_t size, Eigen::MatrixX3d &verM, Eigen::MatrixX3i &faceM);
+
+    /// Write an OBJ to any path. Numbers use the shortest text that reads back to the same double and are
+    /// formatted in parallel into large buffers. With writeBinary, the ".mbin" sidecar is written as well.
+    static bool WriteOBJ(const std::string &fileName, const Eigen::MatrixX3d &verM, const Eigen::MatrixX3i &faceM,
+                         bool writeBinary = false);
+
+    /// Same as WriteOBJ on a background thread; the matrices are taken by value (move them to avoid a copy).
+    /// The destructor of the returned future waits for the write: dropping it makes the call synchronous.
+    [[nodiscard]] static std::future<bool> WriteOBJAsync(const std::string &fileName, Eigen::MatrixX3d verM,
+                                                         Eigen::MatrixX3i faceM, bool writeBinary = false);
+
+    /// Binary mesh format (".mbin"): a 64-byte versioned header, then a 64-byte aligned vertex block
+    /// (column-major double, the layout of Mesh::VerM) and index block (column-major int32), so that
+    /// both blocks can be copied straight out of a memory-mapped file
+    static bool ReadBinary(const std::string &fileName, Eigen::MatrixX3d &verM, Eigen::MatrixX3i &faceM);
+    static bool WriteBinary(const std::string &fileName, const Eigen::MatrixX3d &verM, const Eigen::MatrixX3i &faceM);
+
+    /// Read an OBJ or binary mesh file. With UseSidecarCache, an OBJ is parsed once and cached in
+    /// fileName + ".mbin", which is reused while the size/last write time (or content hash) of the OBJ is unchanged
+    static bool ReadMesh(const std::string &fileName, Eigen::MatrixX3d &verM, Eigen::MatrixX3i &faceM);
+
+    static std::string GetSidecarName(const std::string &fileName);
+};
+
+
+#endif //MESHIO_H
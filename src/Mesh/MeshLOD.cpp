@@ -0,0 +1,138 @@
+/// ========================================
+///
+///     MeshLOD.cpp
+///
+///     Levels of detail of a mesh by
+///     quadric error decimation
+///
+/// ========================================
+
+#include "MeshLOD.h"
+#include "MeshTopology.h"
+
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <iostream>
+#include <condition_variable>
+
+#include <igl/qslim.h>
+#include <igl/hausdorff.h>
+
+bool MeshLOD::BuildOnLoad = false;
+std::vector<double> MeshLOD::DefaultRatioList = {0.25, 0.0625};
+int MeshLOD::MinFaceNum = 1000;
+
+namespace {
+    /// Workers running the queued builds, started on first use. The pool is never destroyed, so the
+    /// detached workers can outlive static destruction at exit without touching a dead queue.
+    class BuildPool {
+    private:
+        std::mutex mutex;
+        std::condition_variable condition;
+        std::deque<std::weak_ptr<MeshLODBuild>> buildQueue;
+
+    public:
+        BuildPool() {
+            int workerNum = std::max(1, static_cast<int>(std::thread::hardware_concurrency()));
+            for (int i = 0; i < workerNum; i++)
+                std::thread([this] { Run(); }).detach();
+        }
+
+        void Push(const std::shared_ptr<MeshLODBuild> &build) {
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                buildQueue.emplace_back(build);
+            }
+            condition.notify_one();
+        }
+
+    private:
+        void Run() {
+            while (true) {
+                std::shared_ptr<MeshLODBuild> build;
+                {
+                    std::unique_lock<std::mutex> lock(mutex);
+                    condition.wait(lock, [this] { return !buildQueue.empty(); });
+                    build = buildQueue.front().lock();
+                    buildQueue.pop_front();
+                }
+                /// Dropped by all of its owners before it started
+                if (build == nullptr)
+                    continue;
+                MeshLOD::RunBuild(*build);
+            }
+        }
+    };
+
+    BuildPool &GetBuildPool() {
+        static BuildPool *pool = new BuildPool();
+        return *pool;
+    }
+}
+
+MeshLODChain MeshLOD::BuildLODChain(const Eigen::MatrixXd &verM, const Eigen::MatrixXi &faceM,
+                                    const std::vector<double> &ratioList) {
+    MeshLODChain chain;
+    if (faceM.rows() < MinFaceNum)
+        return chain;
+    MeshTopology topology;
+    topology.Build(faceM, static_cast<int>(verM.rows()));
+    if (!topology.IsEdgeManifold()) {
+        std::cout << "MeshLOD: the mesh is not edge-manifold, no levels of detail are built" << std::endl;
+        return chain;
+    }
+
+    /// Each level is decimated from the previous one in double precision, then stored in float
+    const Eigen::MatrixXd *prevVerM = &verM;
+    const Eigen::MatrixXi *prevFaceM = &faceM;
+    Eigen::MatrixXd levelVerM, nextVerM;
+    Eigen::MatrixXi levelFaceM, nextFaceM;
+    chain.reserve(ratioList.size());
+    for (double ratio: ratioList) {
+        int maxFaceNum = static_cast<int>(ratio * static_cast<double>(faceM.rows()));
+        if (maxFaceNum >= prevFaceM->rows() || maxFaceNum < 4)
+            break;
+
+        /// Self-intersections are not blocked: the levels are only drawn. qslim returns false when it stops
+        /// above maxFaceNum (no edge left that can be collapsed), the level is kept if it got any coarser.
+        Eigen::VectorXi birthFaceV, birthVerV;
+        bool isReached = igl::qslim(*prevVerM, *prevFaceM, maxFaceNum, false, nextVerM, nextFaceM, birthFaceV,
+                                    birthVerV);
+        if (!isReached && nextFaceM.rows() >= prevFaceM->rows()) {
+            std::cout << "MeshLOD: decimation to " << maxFaceNum << " faces failed" << std::endl;
+            break;
+        }
+        MeshLODLevel level;
+        level.storage = MeshStorageF(nextVerM, nextFaceM);
+        /// Against the full mesh, so the errors of the levels do not accumulate
+        igl::hausdorff(verM, faceM, nextVerM, nextFaceM, level.error);
+        chain.emplace_back(std::move(level));
+
+        levelVerM.swap(nextVerM);
+        levelFaceM.swap(nextFaceM);
+        prevVerM = &levelVerM;
+        prevFaceM = &levelFaceM;
+        if (!isReached)
+            break;
+    }
+    return chain;
+}
+
+std::shared_ptr<const MeshLODBuild>
+MeshLOD::BuildLODChainAsync(Eigen::MatrixXd verM, Eigen::MatrixXi faceM, const std::vector<double> &ratioList) {
+    auto build = std::make_shared<MeshLODBuild>();
+    build->verM = std::move(verM);
+    build->faceM = std::move(faceM);
+    build->ratioList = ratioList;
+    GetBuildPool().Push(build);
+    return build;
+}
+
+void MeshLOD::RunBuild(MeshLODBuild &build) {
+    auto chain = std::make_shared<const MeshLODChain>(BuildLODChain(build.verM, build.faceM, build.ratioList));
+    std::lock_guard<std::mutex> lock(build.mutex);
+    build.chain = chain;
+    build.verM.resize(0, 3);
+    build.faceM.resize(0, 3);
+}
@@ -0,0 +1,87 @@
+/// ========================================
+///
+///     MeshLOD.h
+///
+///     Levels of detail of a mesh by
+///     quadric error decimation
+///
+/// ========================================
+
+#ifndef MESHLOD_H
+#define MESHLOD_H
+
+#include <mutex>
+#include <memory>
+#include <vector>
+#include <Eigen/Core>
+
+#include "Mesh/MeshStorage.h"
+
+/// A decimated copy of a mesh, only ever displayed: float vertices in the layout of a vertex buffer,
+/// at half the memory of the full mesh
+struct MeshLODLevel {
+    MeshStorageF storage;
+
+    /// Hausdorff distance to the full mesh (measured at the vertices of both meshes)
+    double error = 0;
+};
+
+/// Levels in the order of the face ratios, i.e. fine to coarse
+using MeshLODChain = std::vector<MeshLODLevel>;
+
+/// A build queued on the workers of MeshLOD. The queue only holds a weak reference: dropping the last
+/// handle cancels a build that has not started, and a running build finishes with its result dropped,
+/// so releasing a handle never waits.
+class MeshLODBuild {
+private:
+    friend class MeshLOD;
+
+    mutable std::mutex mutex;
+    std::shared_ptr<const MeshLODChain> chain;
+
+    /// Input, released once the build has run
+    Eigen::MatrixXd verM;
+    Eigen::MatrixXi faceM;
+    std::vector<double> ratioList;
+
+public:
+    /// The levels, or nullptr while the build is queued or running
+    std::shared_ptr<const MeshLODChain> GetChain() const {
+        std::lock_guard<std::mutex> lock(mutex);
+        return chain;
+    }
+};
+
+class MeshLOD {
+public:
+    /// Start building the levels when a mesh is read from a file (see Mesh::BuildLODAsync); off by default,
+    /// the builds are started for the meshes shown by levels of detail (RenderManager::SetModelLOD)
+    static bool BuildOnLoad;
+
+    /// Face ratios of the levels below the full mesh (25% and 6.25%)
+    static std::vector<double> DefaultRatioList;
+
+    /// Meshes with fewer faces are not decimated
+    static int MinFaceNum;
+
+public:
+    MeshLOD() = default;
+    ~MeshLOD() = default;
+
+    /// Decimate by qslim, each level from the previous one. Returns no levels for meshes that are
+    /// not edge-manifold (qslim requires it) or too small; a level that qslim cannot bring down to its
+    /// ratio ends the chain.
+    static MeshLODChain BuildLODChain(const Eigen::MatrixXd &verM, const Eigen::MatrixXi &faceM,
+                                      const std::vector<double> &ratioList = DefaultRatioList);
+
+    /// Queue a build on a fixed pool of one worker per hardware thread (started on first use), so that
+    /// loading many meshes neither spawns a thread per mesh nor oversubscribes the machine
+    static std::shared_ptr<const MeshLODBuild> BuildLODChainAsync(Eigen::MatrixXd verM, Eigen::MatrixXi faceM,
+                                                                  const std::vector<double> &ratioList = DefaultRatioList);
+
+    /// Run a queued build and publish its levels (called by the workers)
+    static void RunBuild(MeshLODBuild &build);
+};
+
+
+#endif //MESHLOD_H
@@ -0,0 +1,181 @@
+/// ========================================
+///
+///     MeshMassProperties.cpp
+///
+///     Volume, area, centroids, inertia and
+///     bounding box of a mesh in one pass
+///
+/// ========================================
+
+#include "MeshMassProperties.h"
+
+#include <vector>
+#include <igl/parallel_for.h>
+
+namespace {
+    /// Faces (and vertices) reduced by one task; fixed so that the summation order is fixed
+    const long MassBlockSize = 4096;
+
+    /// Accumulated integrals, relative to a reference point:
+    ///   0      6 x volume                    sum of det(a, b, c)
+    ///   1-3    24 x first volume moment      sum of det * (a + b + c)
+    ///   4-9    120 x second volume moment    sum of det * (aa' + bb' + cc' + ss'), xx yy zz xy yz zx
+    ///   10     2 x area                      sum of |n|
+    ///   11-13  6 x first area moment         sum of |n| * (a + b + c)
+    const int TermNum = 14;
+
+    /// Neumaier compensated sum
+    struct CompensatedSum {
+        double sum = 0;
+        double comp = 0;
+
+        void Add(double value) {
+            double t = sum + value;
+            if (std::abs(sum) >= std::abs(value))
+                comp += (sum - t) + value;
+            else
+                comp += (value - t) + sum;
+            sum = t;
+        }
+
+        void Add(const CompensatedSum &other) {
+            Add(other.sum);
+            Add(other.comp);
+        }
+
+        double Get() const {
+            return sum + comp;
+        }
+    };
+
+    struct MassBlock {
+        CompensatedSum termList[TermNum];
+        Eigen::AlignedBox3d box;
+
+        void Add(const MassBlock &other) {
+            for (int k = 0; k < TermNum; k++)
+                termList[k].Add(other.termList[k]);
+            box.extend(other.box);
+        }
+    };
+
+    /// Vertex of the mesh, optionally under an affine that has not been applied to verM yet
+    inline Eigen::Vector3d GetPoint(const Eigen::MatrixX3d &verM, const Eigen::Affine3d *affineMat, long i) {
+        Eigen::Vector3d p = verM.row(i).transpose();
+        return affineMat ? Eigen::Vector3d(*affineMat * p) : p;
+    }
+
+    void ReduceFaces(const Eigen::MatrixX3d &verM, const Eigen::MatrixX3i &faceM, const Eigen::Affine3d *affineMat,
+                     const Eigen::Vector3d &ref,
+                     long start, long end, MassBlock &block) {
+        double term[TermNum];
+        for (long i = start; i < end; i++) {
+            Eigen::Vector3d a = GetPoint(verM, affineMat, faceM(i, 0)) - ref;
+            Eigen::Vector3d b = GetPoint(verM, affineMat, faceM(i, 1)) - ref;
+            Eigen::Vector3d c = GetPoint(verM, affineMat, faceM(i, 2)) - ref;
+            Eigen::Vector3d s = a + b + c;
+
+            double det = a.dot(b.cross(c));
+            double doubleArea = (b - a).cross(c - a).norm();
+
+            term[0] = det;
+            for (int j = 0; j < 3; j++) {
+                term[1 + j] = det * s(j);
+                term[4 + j] = det * (a(j) * a(j) + b(j) * b(j) + c(j) * c(j) + s(j) * s(j));
+                int k = (j + 1) % 3;
+                term[7 + j] = det * (a(j) * a(k) + b(j) * b(k) + c(j) * c(k) + s(j) * s(k));
+                term[11 + j] = doubleArea * s(j);
+            }
+            term[10] = doubleArea;
+
+            for (int k = 0; k < TermNum; k++)
+                block.termList[k].Add(term[k]);
+        }
+    }
+}
+
+MeshMassProperties ComputeMassProperties(const Eigen::MatrixX3d &verM, const Eigen::MatrixX3i &faceM) {
+    return ComputeMassProperties(verM, faceM, nullptr);
+}
+
+MeshMassProperties ComputeMassProperties(const Eigen::MatrixX3d &verM, const Eigen::MatrixX3i &faceM,
+                                         const Eigen::Affine3d *affineMat) {
+    MeshMassProperties massProp;
+    long faceNum = faceM.rows();
+    long verNum = verM.rows();
+    if (verNum == 0)
+        return massProp;
+
+    /// Integrate relative to a vertex of the mesh rather than the world origin, which keeps
+    /// the terms small for meshes far from the origin
+    Eigen::Vector3d ref = GetPoint(verM, affineMat, 0);
+
+    /// 1. Reduce fixed blocks of faces and vertices in parallel
+    long faceBlockNum = (faceNum + MassBlockSize - 1) / MassBlockSize;
+    long verBlockNum = (verNum + MassBlockSize - 1) / MassBlockSize;
+    long blockNum = std::max(faceBlockNum, verBlockNum);
+    std::vector<MassBlock> blockList(blockNum);
+    igl::parallel_for(blockNum, [&](long b) {
+        long start = b * MassBlockSize;
+        if (start < faceNum)
+            ReduceFaces(verM, faceM, affineMat, ref, start, std::min(faceNum, start + MassBlockSize), blockList[b]);
+        if (start < verNum && affineMat) {
+            for (long i = start; i < std::min(verNum, start + MassBlockSize); i++)
+                blockList[b].box.extend(GetPoint(verM, affineMat, i));
+        } else if (start < verNum) {
+            long size = std::min(verNum, start + MassBlockSize) - start;
+            blockList[b].box.min() = verM.middleRows(start, size).colwise().minCoeff().transpose();
+            blockList[b].box.max() = verM.middleRows(start, size).colwise().maxCoeff().transpose();
+        }
+    }, 1);
+
+    /// 2. Combine the blocks pairwise in a fixed order
+    for (long step = 1; step < blockNum; step *= 2) {
+        for (long b = 0; b + step < blockNum; b += 2 * step)
+            blockList[b].Add(blockList[b + step]);
+    }
+    const MassBlock &total = blockList[0];
+
+    double term[TermNum];
+    for (int k = 0; k < TermNum; k++)
+        term[k] = total.termList[k].Get();
+
+    /// 3. Convert the integrals
+    massProp.box = total.box;
+    massProp.volume = term[0] / 6.0;
+    massProp.area = term[10] / 2.0;
+
+    Eigen::Vector3d areaCentroid(term[11], term[12], term[13]);
+    massProp.surfaceCentroid = term[10] != 0 ? Eigen::Vector3d(ref + areaCentroid / (3.0 * term[10])) : ref;
+
+    if (term[0] != 0) {
+        Eigen::Vector3d volumeCentroid = Eigen::Vector3d(term[1], term[2], term[3]) / (4.0 * term[0]);
+        massProp.volumeCentroid = ref + volumeCentroid;
+
+        /// Second moment about the reference point, moved to the centroid (parallel axis theorem)
+        Eigen::Matrix3d secondMoment;
+        secondMoment << term[4], term[7], term[9],
+                        term[7], term[5], term[8],
+                        term[9], term[8], term[6];
+        secondMoment /= 120.0;
+        secondMoment -= massProp.volume * volumeCentroid * volumeCentroid.transpose();
+
+        massProp.inertia = secondMoment.trace() * Eigen::Matrix3d::Identity() - secondMoment;
+    } else {
+        massProp.volumeCentroid = massProp.surfaceCentroid;
+    }
+
+    return massProp;
+}
+
+std::ostream &operator<<(std::ostream &os, const MeshMassProperties &massProp) {
+    Eigen::IOFormat rowFormat(Eigen::StreamPrecision, Eigen::DontAlignCols, " ", " ", "", "", "(", ")");
+    os << "Volume: " << massProp.volume << std::endl;
+    os << "Area: " << massProp.area << std::endl;
+    os << "Surface Centroid: " << massProp.surfaceCentroid.transpose().format(rowFormat) << std::endl;
+    os << "Volume Centroid: " << massProp.volumeCentroid.transpose().format(rowFormat) << std::endl;
+    os << "Inertia: " << massProp.inertia.format(rowFormat) << std::endl;
+    os << "Bounding Box: " << massProp.box.min().transpose().format(rowFormat) << " - "
+       << massProp.box.max().transpose().format(rowFormat) << std::endl;
+    return os;
+}
@@ -0,0 +1,43 @@
+/// ========================================
+///
+///     MeshMassProperties.h
+///
+///     Volume, area, centroids, inertia and
+///     bounding box of a mesh in one pass
+///
+/// ========================================
+
+#ifndef MESHMASSPROPERTIES_H
+#define MESHMASSPROPERTIES_H
+
+#include <iostream>
+#include <Eigen/Geometry>
+
+/// Mass properties of a closed, consistently oriented triangle mesh (unit density)
+struct MeshMassProperties {
+    double volume = 0;
+    double area = 0;
+
+    /// Area-weighted centroid of the faces
+    Eigen::Vector3d surfaceCentroid = Eigen::Vector3d::Zero();
+    /// Centroid of the enclosed solid
+    Eigen::Vector3d volumeCentroid = Eigen::Vector3d::Zero();
+    /// Inertia tensor about the volume centroid
+    Eigen::Matrix3d inertia = Eigen::Matrix3d::Zero();
+
+    Eigen::AlignedBox3d box;
+};
+
+/// Faces (and vertices, for the bounding box) are reduced in fixed-size blocks in parallel; sums inside
+/// a block are compensated and blocks are combined pairwise in a fixed order, so the result does not
+/// depend on the number of threads
+MeshMassProperties ComputeMassProperties(const Eigen::MatrixX3d &verM, const Eigen::MatrixX3i &faceM);
+
+/// Same as above for the vertices transformed by affineMat (if not null), without transforming verM
+MeshMassProperties ComputeMassProperties(const Eigen::MatrixX3d &verM, const Eigen::MatrixX3i &faceM,
+                                         const Eigen::Affine3d *affineMat);
+
+std::ostream &operator<<(std::ostream &os, const MeshMassProperties &massProp);
+
+
+#endif //MESHMASSPROPERTIES_H
@@ -0,0 +1,109 @@
+/// ========================================
+///
+///     MeshStorage.h
+///
+///     Mesh storage templated on scalar type,
+///     index width and vertex layout
+///
+/// ========================================
+
+#ifndef MESHSTORAGE_H
+#define MESHSTORAGE_H
+
+#include <limits>
+#include <cstdint>
+#include <stdexcept>
+
+#include "Utility/HelpFunc.h"
+
+/// Vertex layout of a mesh storage
+///   LAYOUT_AOS: row-major (n,3), the coordinates of a vertex are adjacent (x0 y0 z0 x1 y1 z1 ...)
+///   LAYOUT_SOA: column-major (n,3), one contiguous array per coordinate (x0 x1 ... y0 y1 ... z0 z1 ...)
+enum MeshLayout {
+    LAYOUT_AOS,
+    LAYOUT_SOA
+};
+
+/// ========================================
+///              Mesh Storage
+/// ========================================
+
+template <typename Scalar, typename Index, MeshLayout Layout>
+class MeshStorage {
+public:
+    typedef Eigen::Matrix<Scalar, Eigen::Dynamic, 3, Layout == LAYOUT_AOS ? Eigen::RowMajor : Eigen::ColMajor> VerMatrix;
+    /// The three indices of a face are always read together, so faces are always stored row-major
+    typedef Eigen::Matrix<Index, Eigen::Dynamic, 3, Eigen::RowMajor> FaceMatrix;
+
+    /// Store vertices in a matrix (n,3)
+    VerMatrix VerM;
+
+    /// Store triangles in a matrix (m,3)
+    FaceMatrix FaceM;
+
+public:
+    MeshStorage() = default;
+    ~MeshStorage() = default;
+
+    /// Throws std::length_error if the index type cannot address every vertex
+    template <typename DerivedV, typename DerivedF>
+    MeshStorage(const Eigen::MatrixBase<DerivedV> &verM, const Eigen::MatrixBase<DerivedF> &faceM) {
+        if (!CanIndex(verM.rows()))
+            throw std::length_error("MeshStorage: too many vertices for the index type");
+        VerM = verM.template cast<Scalar>();
+        FaceM = faceM.template cast<Index>();
+    }
+
+    /// Explicit conversion between storages of different scalar type, index width or layout;
+    /// throws std::length_error if the index type cannot address every vertex
+    template <typename OtherScalar, typename OtherIndex, MeshLayout OtherLayout>
+    explicit MeshStorage(const MeshStorage<OtherScalar, OtherIndex, OtherLayout> &other) {
+        if (!CanIndex(other.VerM.rows()))
+            throw std::length_error("MeshStorage: too many vertices for the index type");
+        VerM = other.VerM.template cast<Scalar>();
+        FaceM = other.FaceM.template cast<Index>();
+    }
+
+    /// Maximum vertex number addressable by the index type
+    static long GetMaxVerNum() {
+        return static_cast<long>(std::min<unsigned long long>(std::numeric_limits<Index>::max(),
+                                                               std::numeric_limits<long>::max()));
+    }
+
+    static bool CanIndex(long verNum) {
+        return verNum - 1 <= GetMaxVerNum();
+    }
+
+    /// The layout of Mesh and of libigl
+    void ToMatrices(Eigen::MatrixXd &verM, Eigen::MatrixXi &faceM) const {
+        verM = VerM.template cast<double>();
+        faceM = FaceM.template cast<int>();
+    }
+
+    size_t GetMemoryBytes() const {
+        return VerM.size() * sizeof(Scalar) + FaceM.size() * sizeof(Index);
+    }
+
+    void Transform(const Eigen::Affine3d &affineMat) {
+        TransformVertexMatrix(affineMat, VerM, VerM);
+    }
+
+    Eigen::AlignedBox<Scalar, 3> ComputeBoundingBox() const {
+        Eigen::AlignedBox<Scalar, 3> box;
+        if (VerM.rows() > 0) {
+            box.min() = VerM.colwise().minCoeff().transpose();
+            box.max() = VerM.colwise().maxCoeff().transpose();
+        }
+        return box;
+    }
+};
+
+/// Display data: float AoS, the layout of an OpenGL vertex buffer (half the memory of Mesh)
+typedef MeshStorage<float, uint32_t, LAYOUT_AOS> MeshStorageF;
+/// Small parts (up to 65536 vertices) with 16-bit indices
+typedef MeshStorage<float, uint16_t, LAYOUT_AOS> MeshStorageF16;
+/// Same scalar type and layout as Mesh
+typedef MeshStorage<double, int, LAYOUT_SOA> MeshStorageD;
+
+
+#endif //MESHSTORAGE_H
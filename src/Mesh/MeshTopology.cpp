@@ -0,0 +1,236 @@
+/// ========================================
+///
+///     MeshTopology.cpp
+///
+///     Connectivity of a triangle mesh
+///     in compact (CSR) arrays
+///
+/// ========================================
+
+#include "MeshTopology.h"
+
+#include <atomic>
+#include <thread>
+#include <algorithm>
+
+#include <igl/parallel_for.h>
+
+namespace {
+    const int ParallelChunk = 1000;
+
+    /// Group entry i under row getRow(i) with value getValue(i), keeping the entry order within each row.
+    /// A parallel counting sort: the entries are split into chunks, each counted and scattered by one thread
+    /// into the slots left for it by the chunks before it, so the result is the same as a serial pass.
+    template<typename RowFunc, typename ValueFunc>
+    void BuildCSR(int rowNum, int entryNum, const RowFunc &getRow, const ValueFunc &getValue,
+                  std::vector<int> &offsetList, std::vector<int> &valueList) {
+        int chunkNum = std::max(1, std::min(static_cast<int>(std::thread::hardware_concurrency()),
+                                            entryNum / (16 * ParallelChunk)));
+        auto getChunkStart = [&](int chunkID) { return static_cast<int>(static_cast<long>(entryNum) * chunkID / chunkNum); };
+
+        std::vector<std::vector<int>> chunkCursorList(chunkNum);
+        igl::parallel_for(chunkNum, [&](int chunkID) {
+            std::vector<int> &cursorList = chunkCursorList[chunkID];
+            cursorList.assign(rowNum, 0);
+            for (int i = getChunkStart(chunkID); i < getChunkStart(chunkID + 1); i++)
+                cursorList[getRow(i)]++;
+        }, 1);
+
+        /// Counts become the first slot of each chunk in each row
+        offsetList.resize(rowNum + 1);
+        igl::parallel_for(rowNum, [&](int row) {
+            int count = 0;
+            for (std::vector<int> &cursorList: chunkCursorList) {
+                int chunkCount = cursorList[row];
+                cursorList[row] = count;
+                count += chunkCount;
+            }
+            offsetList[row + 1] = count;
+        }, ParallelChunk);
+        offsetList[0] = 0;
+        for (int row = 0; row < rowNum; row++)
+            offsetList[row + 1] += offsetList[row];
+
+        valueList.resize(entryNum);
+        igl::parallel_for(chunkNum, [&](int chunkID) {
+            std::vector<int> &cursorList = chunkCursorList[chunkID];
+            for (int i = getChunkStart(chunkID); i < getChunkStart(chunkID + 1); i++) {
+                int row = getRow(i);
+                valueList[offsetList[row] + cursorList[row]++] = getValue(i);
+            }
+        }, 1);
+    }
+
+    /// Exclusive prefix sum of the counts, with the total appended
+    std::vector<int> ComputeOffsets(const std::vector<int> &countList) {
+        std::vector<int> offsetList(countList.size() + 1, 0);
+        for (size_t i = 0; i < countList.size(); i++)
+            offsetList[i + 1] = offsetList[i] + countList[i];
+        return offsetList;
+    }
+}
+
+/// ========================================
+///                 Build
+/// ========================================
+
+void MeshTopology::Build(const Eigen::MatrixX3i &faceM, int vertexNum) {
+    verNum = vertexNum;
+    faceNum = static_cast<int>(faceM.rows());
+
+    BuildCSR(verNum, 3 * faceNum, [&](int h) { return faceM(h / 3, h % 3); }, [](int h) { return h / 3; },
+             verFaceOffsetList, verFaceList);
+    BuildEdges(faceM);
+    BuildFaceFaces();
+    BuildBoundaryLoops(faceM);
+}
+
+/// Half-edges are grouped by their smaller vertex and sorted by the other one, so the half-edges of an edge
+/// are adjacent: each run is one edge, numbered by counting the runs of each vertex
+void MeshTopology::BuildEdges(const Eigen::MatrixX3i &faceM) {
+    int halfEdgeNum = 3 * faceNum;
+    /// End points of the half-edges in sequential arrays, read many times by the sorts below
+    std::vector<int> minVerList(halfEdgeNum), maxVerList(halfEdgeNum);
+    igl::parallel_for(faceNum, [&](int faceID) {
+        for (int i = 0; i < 3; i++) {
+            int verA = faceM(faceID, i);
+            int verB = faceM(faceID, (i + 1) % 3);
+            minVerList[3 * faceID + i] = std::min(verA, verB);
+            maxVerList[3 * faceID + i] = std::max(verA, verB);
+        }
+    }, ParallelChunk);
+    auto getMinVer = [&](int h) { return minVerList[h]; };
+    auto getMaxVer = [&](int h) { return maxVerList[h]; };
+
+    /// Rows are mostly short (the valence of a vertex): an insertion sort, stable so ties stay in half-edge order
+    std::vector<int> minVerOffsetList;
+    BuildCSR(verNum, halfEdgeNum, getMinVer, [](int h) { return h; }, minVerOffsetList, edgeHalfList);
+    igl::parallel_for(verNum, [&](int verID) {
+        int first = minVerOffsetList[verID];
+        int last = minVerOffsetList[verID + 1];
+        if (last - first > 64) {
+            std::stable_sort(edgeHalfList.begin() + first, edgeHalfList.begin() + last,
+                             [&](int a, int b) { return getMaxVer(a) < getMaxVer(b); });
+            return;
+        }
+        for (int i = first + 1; i < last; i++) {
+            int h = edgeHalfList[i];
+            int j = i;
+            for (; j > first && getMaxVer(edgeHalfList[j - 1]) > getMaxVer(h); j--)
+                edgeHalfList[j] = edgeHalfList[j - 1];
+            edgeHalfList[j] = h;
+        }
+    }, ParallelChunk);
+
+    auto isRunStart = [&](int verID, int i) {
+        return i == minVerOffsetList[verID] || getMaxVer(edgeHalfList[i]) != getMaxVer(edgeHalfList[i - 1]);
+    };
+    std::vector<int> verEdgeNumList(verNum, 0);
+    igl::parallel_for(verNum, [&](int verID) {
+        for (int i = minVerOffsetList[verID]; i < minVerOffsetList[verID + 1]; i++)
+            verEdgeNumList[verID] += isRunStart(verID, i);
+    }, ParallelChunk);
+    std::vector<int> verEdgeOffsetList = ComputeOffsets(verEdgeNumList);
+
+    int edgeNum = verEdgeOffsetList[verNum];
+    edgeList.resize(edgeNum);
+    edgeHalfOffsetList.resize(edgeNum + 1);
+    edgeHalfOffsetList[edgeNum] = halfEdgeNum;
+    halfEdgeToEdgeList.resize(halfEdgeNum);
+    igl::parallel_for(verNum, [&](int verID) {
+        int edgeID = verEdgeOffsetList[verID] - 1;
+        for (int i = minVerOffsetList[verID]; i < minVerOffsetList[verID + 1]; i++) {
+            int h = edgeHalfList[i];
+            if (isRunStart(verID, i)) {
+                edgeID++;
+                edgeList[edgeID] = Eigen::Vector2i(verID, getMaxVer(h));
+                edgeHalfOffsetList[edgeID] = i;
+            }
+            halfEdgeToEdgeList[h] = edgeID;
+        }
+    }, ParallelChunk);
+
+    twinList.assign(halfEdgeNum, -1);
+    std::atomic<int> boundaryNum(0);
+    std::atomic<int> nonManifoldNum(0);
+    igl::parallel_for(edgeNum, [&](int edgeID) {
+        IndexRange halfEdges = GetEdgeHalfEdges(edgeID);
+        if (halfEdges.size() == 1) {
+            boundaryNum.fetch_add(1, std::memory_order_relaxed);
+        } else if (halfEdges.size() == 2) {
+            twinList[halfEdges[0]] = halfEdges[1];
+            twinList[halfEdges[1]] = halfEdges[0];
+        } else {
+            nonManifoldNum.fetch_add(1, std::memory_order_relaxed);
+        }
+    }, ParallelChunk);
+    boundaryEdgeNum = boundaryNum;
+    nonManifoldEdgeNum = nonManifoldNum;
+}
+
+void MeshTopology::BuildFaceFaces() {
+    std::vector<int> neighborNumList(faceNum, 0);
+    igl::parallel_for(faceNum, [&](int faceID) {
+        for (int h = 3 * faceID; h < 3 * faceID + 3; h++)
+            neighborNumList[faceID] += GetEdgeHalfEdges(halfEdgeToEdgeList[h]).size() - 1;
+    }, ParallelChunk);
+    faceFaceOffsetList = ComputeOffsets(neighborNumList);
+
+    faceFaceList.resize(faceFaceOffsetList[faceNum]);
+    igl::parallel_for(faceNum, [&](int faceID) {
+        int i = faceFaceOffsetList[faceID];
+        for (int h = 3 * faceID; h < 3 * faceID + 3; h++) {
+            for (int other: GetEdgeHalfEdges(halfEdgeToEdgeList[h])) {
+                if (other != h)
+                    faceFaceList[i++] = GetFace(other);
+            }
+        }
+    }, ParallelChunk);
+}
+
+/// Boundary half-edges are chained head to tail; at a vertex with several boundary half-edges leaving it
+/// (two holes touching at a vertex) the loop is closed as soon as it gets back to its first vertex
+void MeshTopology::BuildBoundaryLoops(const Eigen::MatrixX3i &faceM) {
+    auto getStart = [&](int h) { return faceM(h / 3, h % 3); };
+    auto getEnd = [&](int h) { return faceM(h / 3, (h % 3 + 1) % 3); };
+
+    std::vector<int> boundaryList;
+    boundaryList.reserve(boundaryEdgeNum);
+    for (int edgeID = 0; edgeID < edgeList.size(); edgeID++) {
+        if (edgeHalfOffsetList[edgeID + 1] - edgeHalfOffsetList[edgeID] == 1)
+            boundaryList.push_back(edgeHalfList[edgeHalfOffsetList[edgeID]]);
+    }
+
+    std::vector<int> startOffsetList, startHalfList;
+    BuildCSR(verNum, static_cast<int>(boundaryList.size()), [&](int i) { return getStart(boundaryList[i]); },
+             [&](int i) { return boundaryList[i]; }, startOffsetList, startHalfList);
+
+    std::vector<char> isVisitedList(startHalfList.size(), 0);
+    loopOffsetList.assign(1, 0);
+    loopVerList.clear();
+    loopVerList.reserve(boundaryList.size());
+    for (int i = 0; i < startHalfList.size(); i++) {
+        if (isVisitedList[i])
+            continue;
+        int firstVer = getStart(startHalfList[i]);
+        int current = i;
+        while (current >= 0) {
+            isVisitedList[current] = 1;
+            loopVerList.push_back(getStart(startHalfList[current]));
+            int verID = getEnd(startHalfList[current]);
+            current = -1;
+            if (verID == firstVer)
+                break;
+            for (int j = startOffsetList[verID]; j < startOffsetList[verID + 1]; j++) {
+                if (!isVisitedList[j]) {
+                    current = j;
+                    break;
+                }
+            }
+            /// Open chain (non-manifold or inconsistently oriented faces): keep its last vertex
+            if (current < 0)
+                loopVerList.push_back(verID);
+        }
+        loopOffsetList.push_back(static_cast<int>(loopVerList.size()));
+    }
+}
@@ -0,0 +1,104 @@
+/// ========================================
+///
+///     MeshTopology.h
+///
+///     Connectivity of a triangle mesh
+///     in compact (CSR) arrays
+///
+/// ========================================
+
+#ifndef MESHTOPOLOGY_H
+#define MESHTOPOLOGY_H
+
+#include <vector>
+#include <Eigen/Core>
+
+/// Connectivity of the faces, built once in parallel and read-only afterwards.
+/// Half-edge h = 3 * face + i runs from faceM(face, i) to faceM(face, (i + 1) % 3); the lists of a vertex,
+/// a face or an edge are stored back to back in one array, addressed by an offset array (CSR).
+class MeshTopology {
+public:
+    /// Read-only view of one row of a CSR array
+    struct IndexRange {
+        const int *first = nullptr;
+        const int *last = nullptr;
+
+        const int *begin() const { return first; }
+        const int *end() const { return last; }
+        int size() const { return static_cast<int>(last - first); }
+        bool empty() const { return first == last; }
+        int operator[](int i) const { return first[i]; }
+    };
+
+private:
+    int verNum = 0;
+    int faceNum = 0;
+
+    /// Faces around each vertex (ascending)
+    std::vector<int> verFaceOffsetList;
+    std::vector<int> verFaceList;
+
+    /// Faces sharing an edge with each face (more than three around non-manifold edges)
+    std::vector<int> faceFaceOffsetList;
+    std::vector<int> faceFaceList;
+
+    /// Undirected edges with the smaller vertex first, sorted; the half-edges of edge e are
+    /// edgeHalfList[edgeHalfOffsetList[e]] up to the next offset
+    std::vector<Eigen::Vector2i> edgeList;
+    std::vector<int> edgeHalfOffsetList;
+    std::vector<int> edgeHalfList;
+    std::vector<int> halfEdgeToEdgeList;
+    /// Opposite half-edge, -1 on boundary and non-manifold edges
+    std::vector<int> twinList;
+
+    /// Vertices of each boundary loop, in the direction of its half-edges. Around non-manifold edges, or where
+    /// the orientation of the faces flips, a loop may be an open chain that ends with the vertex its last
+    /// half-edge points to.
+    std::vector<int> loopOffsetList;
+    std::vector<int> loopVerList;
+
+    int boundaryEdgeNum = 0;
+    int nonManifoldEdgeNum = 0;
+
+public:
+    MeshTopology() = default;
+    ~MeshTopology() = default;
+
+    void Build(const Eigen::MatrixX3i &faceM, int vertexNum);
+
+    int GetVerNum() const { return verNum; }
+    int GetFaceNum() const { return faceNum; }
+    int GetEdgeNum() const { return static_cast<int>(edgeList.size()); }
+    int GetBoundaryLoopNum() const { return static_cast<int>(loopOffsetList.size()) - 1; }
+
+    IndexRange GetVertexFaces(int verID) const { return GetRow(verFaceOffsetList, verFaceList, verID); }
+    IndexRange GetFaceFaces(int faceID) const { return GetRow(faceFaceOffsetList, faceFaceList, faceID); }
+    IndexRange GetEdgeHalfEdges(int edgeID) const { return GetRow(edgeHalfOffsetList, edgeHalfList, edgeID); }
+    IndexRange GetBoundaryLoop(int loopID) const { return GetRow(loopOffsetList, loopVerList, loopID); }
+
+    const std::vector<Eigen::Vector2i> &GetEdgeList() const { return edgeList; }
+    int GetEdge(int halfEdgeID) const { return halfEdgeToEdgeList[halfEdgeID]; }
+    int GetTwin(int halfEdgeID) const { return twinList[halfEdgeID]; }
+    static int GetFace(int halfEdgeID) { return halfEdgeID / 3; }
+    static int GetNext(int halfEdgeID) { return halfEdgeID % 3 == 2 ? halfEdgeID - 2 : halfEdgeID + 1; }
+    static int GetPrev(int halfEdgeID) { return halfEdgeID % 3 == 0 ? halfEdgeID + 2 : halfEdgeID - 1; }
+
+    int GetBoundaryEdgeNum() const { return boundaryEdgeNum; }
+    int GetNonManifoldEdgeNum() const { return nonManifoldEdgeNum; }
+    /// No edge has more than two faces (same test as igl::is_edge_manifold)
+    bool IsEdgeManifold() const { return nonManifoldEdgeNum == 0; }
+    /// Every edge has exactly two faces
+    bool IsWatertight() const { return faceNum > 0 && nonManifoldEdgeNum == 0 && boundaryEdgeNum == 0; }
+
+private:
+    static IndexRange GetRow(const std::vector<int> &offsetList, const std::vector<int> &valueList, int row) {
+        return {valueList.data() + offsetList[row], valueList.data() + offsetList[row + 1]};
+    }
+
+    void BuildEdges(const Eigen::MatrixX3i &faceM);
+    void BuildFaceFaces();
+    void BuildBoundaryLoops(const Eigen::MatrixX3i &faceM);
+};
+
+
+#endif //MESHTOPOLOGY_H
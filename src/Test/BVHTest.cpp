@@ -0,0 +1,218 @@
+/// ========================================
+///
+///     BVHTest.cpp
+///
+///     BVH queries against brute force
+///     over all the faces
+///
+/// ========================================
+
+#include <random>
+
+#include "Mesh/MeshBoolean.h"
+#include "Mesh/MeshCreator.h"
+#include "Test/TestUtil.h"
+
+/// ========================================
+///              Brute Force
+/// ========================================
+
+/// Moller-Trumbore, nearest hit over all faces
+double IntersectRayBrute(const Eigen::MatrixX3d &verM, const Eigen::MatrixX3i &faceM, const Eigen::Vector3d &origin,
+                         const Eigen::Vector3d &dir) {
+    double tMin = std::numeric_limits<double>::infinity();
+    for (int i = 0; i < faceM.rows(); i++) {
+        Eigen::Vector3d v0 = verM.row(faceM(i, 0)).transpose();
+        Eigen::Vector3d e1 = verM.row(faceM(i, 1)).transpose() - v0;
+        Eigen::Vector3d e2 = verM.row(faceM(i, 2)).transpose() - v0;
+        Eigen::Vector3d p = dir.cross(e2);
+        double det = e1.dot(p);
+        if (std::abs(det) < 1e-300)
+            continue;
+        Eigen::Vector3d s = origin - v0;
+        double u = s.dot(p) / det;
+        Eigen::Vector3d q = s.cross(e1);
+        double v = dir.dot(q) / det;
+        double t = e2.dot(q) / det;
+        if (u >= 0 && v >= 0 && u + v <= 1 && t >= 0)
+            tMin = std::min(tMin, t);
+    }
+    return tMin;
+}
+
+/// Closest point of a triangle by its Voronoi regions (Ericson, Real-Time Collision Detection 5.1.5)
+Eigen::Vector3d ClosestPointOnTriangle(const Eigen::Vector3d &p, const Eigen::Vector3d &a, const Eigen::Vector3d &b,
+                                       const Eigen::Vector3d &c) {
+    Eigen::Vector3d ab = b - a, ac = c - a, ap = p - a;
+    double d1 = ab.dot(ap), d2 = ac.dot(ap);
+    if (d1 <= 0 && d2 <= 0) return a;
+    Eigen::Vector3d bp = p - b;
+    double d3 = ab.dot(bp), d4 = ac.dot(bp);
+    if (d3 >= 0 && d4 <= d3) return b;
+    double vc = d1 * d4 - d3 * d2;
+    if (vc <= 0 && d1 >= 0 && d3 <= 0) return a + d1 / (d1 - d3) * ab;
+    Eigen::Vector3d cp = p - c;
+    double d5 = ab.dot(cp), d6 = ac.dot(cp);
+    if (d6 >= 0 && d5 <= d6) return c;
+    double vb = d5 * d2 - d1 * d6;
+    if (vb <= 0 && d2 >= 0 && d6 <= 0) return a + d2 / (d2 - d6) * ac;
+    double va = d3 * d6 - d5 * d4;
+    if (va <= 0 && d4 - d3 >= 0 && d5 - d6 >= 0) return b + (d4 - d3) / ((d4 - d3) + (d5 - d6)) * (c - b);
+    double denom = 1.0 / (va + vb + vc);
+    return a + ab * (vb * denom) + ac * (vc * denom);
+}
+
+double ComputeSqrDistanceBrute(const Eigen::MatrixX3d &verM, const Eigen::MatrixX3i &faceM, const Eigen::Vector3d &point) {
+    double sqrDistance = std::numeric_limits<double>::infinity();
+    for (int i = 0; i < faceM.rows(); i++) {
+        Eigen::Vector3d q = ClosestPointOnTriangle(point, verM.row(faceM(i, 0)).transpose(),
+                                                   verM.row(faceM(i, 1)).transpose(), verM.row(faceM(i, 2)).transpose());
+        sqrDistance = std::min(sqrDistance, (q - point).squaredNorm());
+    }
+    return sqrDistance;
+}
+
+std::vector<int> QueryBoxBrute(const Eigen::MatrixX3d &verM, const Eigen::MatrixX3i &faceM, const Eigen::AlignedBox3d &box) {
+    std::vector<int> faceList;
+    for (int i = 0; i < faceM.rows(); i++) {
+        if (MeshBVH::ComputeFaceBox(verM, faceM, i).intersects(box))
+            faceList.push_back(i);
+    }
+    return faceList;
+}
+
+/// ========================================
+///                 Tests
+/// ========================================
+
+/// A bumpy sphere and a cylinder through it, so that the tree has uneven and overlapping leaves
+Mesh *CreateTestMesh(std::mt19937 &generator) {
+    std::uniform_real_distribution<double> noise(-0.02, 0.02);
+    Mesh *sphere = MeshCreator::CreateSphere(1.0, 48);
+    Eigen::MatrixX3d &verM = sphere->EditVerM();
+    for (long i = 0; i < verM.size(); i++)
+        verM(i) += noise(generator);
+    Mesh *cylinder = MeshCreator::CreateCylinder(Eigen::Vector3d(-1.5, 0.2, 0), Eigen::Vector3d(1.5, -0.3, 0.4), 0.3, 24);
+    Mesh *mesh = MeshBoolean::MeshConnect(sphere, cylinder);
+    delete sphere;
+    delete cylinder;
+    return mesh;
+}
+
+void CheckQueries(const MeshBVH &bvh, const Eigen::MatrixX3d &verM, const Eigen::MatrixX3i &faceM,
+                  std::mt19937 &generator) {
+    std::uniform_real_distribution<double> coord(-2.0, 2.0);
+    auto getRandomPoint = [&]() { return Eigen::Vector3d(coord(generator), coord(generator), coord(generator)); };
+
+    const int queryNum = 300;
+    Eigen::MatrixX3d originM(queryNum, 3), dirM(queryNum, 3), pointM(queryNum, 3);
+    std::vector<Eigen::AlignedBox3d> boxList;
+    for (int i = 0; i < queryNum; i++) {
+        Eigen::Vector3d origin = 1.5 * getRandomPoint();
+        /// Aim at a point near the mesh so that most rays hit
+        Eigen::Vector3d dir = 0.5 * getRandomPoint() - origin;
+        originM.row(i) = origin.transpose();
+        dirM.row(i) = dir.transpose();
+        pointM.row(i) = getRandomPoint().transpose();
+        Eigen::Vector3d corner = getRandomPoint();
+        boxList.emplace_back(corner, corner + 0.3 * getRandomPoint().cwiseAbs());
+    }
+
+    std::vector<MeshRayHit> hitList;
+    std::vector<MeshClosestPoint> resultList;
+    std::vector<std::vector<int>> faceLists;
+    bvh.IntersectRays(verM, faceM, originM, dirM, hitList);
+    bvh.ComputeClosestPoints(verM, faceM, pointM, resultList);
+    bvh.QueryBoxes(verM, faceM, boxList, faceLists);
+
+    int hitNum = 0;
+    for (int i = 0; i < queryNum; i++) {
+        double t = IntersectRayBrute(verM, faceM, originM.row(i).transpose(), dirM.row(i).transpose());
+        CHECK(hitList[i].IsHit() == std::isfinite(t));
+        if (hitList[i].IsHit() && std::isfinite(t)) {
+            hitNum++;
+            CHECK(IsClose(hitList[i].t, t, 1e-9));
+        }
+
+        double sqrDistance = ComputeSqrDistanceBrute(verM, faceM, pointM.row(i).transpose());
+        CHECK(IsClose(resultList[i].sqrDistance, sqrDistance, 1e-9));
+        CHECK(IsClose((resultList[i].point - pointM.row(i).transpose()).squaredNorm(), sqrDistance, 1e-9));
+
+        std::vector<int> faceList = faceLists[i];
+        std::sort(faceList.begin(), faceList.end());
+        CHECK(faceList == QueryBoxBrute(verM, faceM, boxList[i]));
+    }
+    /// The rays must exercise the hit path, not only misses
+    CHECK(hitNum > queryNum / 4);
+}
+
+/// Every face is in exactly one leaf
+void CheckLeaves(const MeshBVH &bvh, long faceNum) {
+    std::vector<int> faceIndexList = bvh.GetFaceIndexList();
+    std::sort(faceIndexList.begin(), faceIndexList.end());
+    bool isPermutation = faceIndexList.size() == faceNum;
+    for (int i = 0; isPermutation && i < faceIndexList.size(); i++)
+        isPermutation = faceIndexList[i] == i;
+    CHECK(isPermutation);
+}
+
+void TestBuild() {
+    std::mt19937 generator(7);
+    int defaultLeafSize = MeshBVH::MaxLeafSize;
+    for (int maxLeafSize: {1, 4, 16}) {
+        MeshBVH::MaxLeafSize = maxLeafSize;
+        Mesh *mesh = CreateTestMesh(generator);
+        MeshBVH bvh;
+        bvh.Build(mesh->GetVerM(), mesh->GetFaceM());
+
+        CheckLeaves(bvh, mesh->GetFaceM().rows());
+        CheckQueries(bvh, mesh->GetVerM(), mesh->GetFaceM(), generator);
+        delete mesh;
+    }
+    MeshBVH::MaxLeafSize = defaultLeafSize;
+}
+
+void TestLargeBuild() {
+    /// Enough faces for the top levels to be built on several threads
+    std::mt19937 generator(5);
+    Mesh *mesh = MeshCreator::CreateSphere(1.0, 260);
+    CHECK(mesh->GetFaceM().rows() > 2 * (1 << 15));
+    MeshBVH bvh;
+    bvh.Build(mesh->GetVerM(), mesh->GetFaceM());
+    CheckLeaves(bvh, mesh->GetFaceM().rows());
+    CheckQueries(bvh, mesh->GetVerM(), mesh->GetFaceM(), generator);
+    delete mesh;
+}
+
+void TestRefit() {
+    /// Moved vertices keep the tree; the refit boxes must still bound every face
+    std::mt19937 generator(11);
+    Mesh *mesh = CreateTestMesh(generator);
+    std::shared_ptr<const MeshBVH> bvh = mesh->GetBVH();
+    mesh->Transform(GetRotationMatrix(Eigen::Vector3d(0.3, 1, -0.2).normalized(), 1.1) * GetScalingMatrix(1.3));
+    Eigen::MatrixX3d &verM = mesh->EditVerM();
+    std::uniform_real_distribution<double> noise(-0.1, 0.1);
+    for (long i = 0; i < verM.rows(); i++)
+        verM(i, 0) += noise(generator);
+
+    std::shared_ptr<const MeshBVH> refitBVH = mesh->GetBVH();
+    CHECK(refitBVH != bvh);
+    CheckQueries(*refitBVH, mesh->GetVerM(), mesh->GetFaceM(), generator);
+
+    /// The single-query wrappers of Mesh go through the same tree
+    Eigen::Vector3d origin(3, 0.1, 0.2);
+    MeshRayHit hit;
+    mesh->IntersectRay(origin, -origin, hit);
+    CHECK(IsClose(hit.t, IntersectRayBrute(mesh->GetVerM(), mesh->GetFaceM(), origin, -origin), 1e-9));
+    MeshClosestPoint closest;
+    mesh->ComputeClosestPoint(origin, closest);
+    CHECK(IsClose(closest.sqrDistance, ComputeSqrDistanceBrute(mesh->GetVerM(), mesh->GetFaceM(), origin), 1e-9));
+    delete mesh;
+}
+
+int main() {
+    TestBuild();
+    TestLargeBuild();
+    TestRefit();
+    return ReportTest("BVHTest");
+}
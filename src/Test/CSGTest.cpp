@@ -0,0 +1,209 @@
+/// ========================================
+///
+///     CSGTest.cpp
+///
+///     Sharing of sub-expressions, release of
+///     intermediate results and failures of
+///     the CSG evaluation
+///
+/// ========================================
+
+#include <thread>
+#include <stdexcept>
+
+#include "Mesh/MeshCSG.h"
+#include "Mesh/MeshCreator.h"
+#include "Test/TestUtil.h"
+
+/// Spheres far enough apart that the booleans between them are decided by their boxes, without CGAL;
+/// each carries a pending transform, so shared leaves are materialized by concurrent readers
+std::vector<Mesh *> CreateSpheres(int sphereNum) {
+    std::vector<Mesh *> sphereList;
+    for (int i = 0; i < sphereNum; i++) {
+        Mesh *sphere = MeshCreator::CreateSphere(0.4 + 0.01 * i, 16);
+        sphere->Transform(GetTranslationMatrix(Eigen::Vector3d(2.0 * i, 0.1 * i, 0)));
+        sphereList.push_back(sphere);
+    }
+    return sphereList;
+}
+
+bool IsSameMesh(const Mesh &meshA, const Mesh &meshB) {
+    return meshA.GetVerM().rows() == meshB.GetVerM().rows() && meshA.GetFaceM().rows() == meshB.GetFaceM().rows() &&
+           meshA.GetVerM() == meshB.GetVerM() && meshA.GetFaceM() == meshB.GetFaceM();
+}
+
+/// Fails every XOR, after a delay so that other operations are running meanwhile
+class FailingCSG : public MeshCSG {
+protected:
+    Mesh *EvaluateNode(const CSGNode &node, Mesh *meshA, Mesh *meshB) const override {
+        if (node.op == CSG_XOR) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(20));
+            throw std::runtime_error("XOR failed");
+        }
+        return MeshCSG::EvaluateNode(node, meshA, meshB);
+    }
+};
+
+/// ========================================
+///                 Tests
+/// ========================================
+
+void TestDedup() {
+    std::vector<Mesh *> sphereList = CreateSpheres(4);
+    MeshCSG csg;
+    int a = csg.AddMesh(sphereList[0]);
+    int b = csg.AddMesh(sphereList[1]);
+    int c = csg.AddMesh(sphereList[2]);
+    CHECK(csg.AddMesh(sphereList[0]) == a);
+
+    /// Commutative operations share one node for both operand orders, the others do not
+    int nodeNum = csg.GetNodeNum();
+    CHECK(csg.Union(a, b) == csg.Union(b, a));
+    CHECK(csg.Intersect(a, b) == csg.Intersect(b, a));
+    CHECK(csg.XOR(a, b) == csg.XOR(b, a));
+    CHECK(csg.Minus(a, b) != csg.Minus(b, a));
+    CHECK(csg.Connect(a, b) != csg.Connect(b, a));
+    CHECK(csg.Union(a, b) != csg.Intersect(a, b));
+    CHECK(csg.GetNodeNum() == nodeNum + 7);
+
+    /// The same list builds the same balanced tree, Union(a, Union(b, c))
+    nodeNum = csg.GetNodeNum();
+    int unionID = csg.Union(std::vector<int>{a, b, c});
+    CHECK(csg.Union(std::vector<int>{a, b, c}) == unionID);
+    CHECK(csg.Union(a, csg.Union(c, b)) == unionID);
+    CHECK(csg.GetNodeNum() == nodeNum + 2);
+
+    /// Invalid operands are rejected
+    CHECK(csg.Union(a, 100) == -1);
+    CHECK(csg.Union(std::vector<int>{}) == -1);
+    CHECK(csg.Evaluate(-1) == nullptr);
+
+    for (Mesh *sphere: sphereList)
+        delete sphere;
+}
+
+void TestEvaluate() {
+    /// A shared sub-expression is evaluated once and read by both of its consumers
+    std::vector<Mesh *> sphereList = CreateSpheres(4);
+    MeshCSG csg;
+    int a = csg.AddMesh(sphereList[0]);
+    int b = csg.AddMesh(sphereList[1]);
+    int c = csg.AddMesh(sphereList[2]);
+    int d = csg.AddMesh(sphereList[3]);
+    int ab = csg.Union(a, b);
+    int root = csg.Connect(csg.Union(ab, c), csg.Minus(ab, d));
+    csg.Connect(csg.Intersect(a, d), root);
+
+    Mesh *mesh = csg.Evaluate(root, 1);
+    CHECK(mesh != nullptr);
+    if (mesh != nullptr) {
+        /// a, b, c, then a and b again (nothing is removed: the spheres are disjoint)
+        long verNum = 0, faceNum = 0;
+        for (int i: {0, 1, 2, 0, 1}) {
+            verNum += sphereList[i]->GetVerM().rows();
+            faceNum += sphereList[i]->GetFaceM().rows();
+        }
+        CHECK(mesh->GetVerM().rows() == verNum);
+        CHECK(mesh->GetFaceM().rows() == faceNum);
+        double volume = 0;
+        for (int i: {0, 1, 2, 0, 1})
+            volume += sphereList[i]->ComputeMassProperties().volume;
+        CHECK(IsClose(mesh->ComputeMassProperties().volume, volume, 1e-12));
+    }
+
+    /// Only the reachable nodes run, the shared one once
+    MeshCSGStats stats;
+    Mesh *parallelMesh = csg.Evaluate(root, 0, &stats);
+    CHECK(stats.numEvaluate == 4);
+    CHECK(parallelMesh != nullptr && mesh != nullptr && IsSameMesh(*parallelMesh, *mesh));
+    delete parallelMesh;
+    delete mesh;
+
+    /// A leaf as the root is copied
+    Mesh *leafMesh = csg.Evaluate(a);
+    CHECK(leafMesh != sphereList[0] && IsSameMesh(*leafMesh, *sphereList[0]));
+    delete leafMesh;
+
+    /// Repeated evaluations reuse the pool and give the same mesh
+    std::vector<Mesh *> copyList = CreateSpheres(4);
+    for (int i = 0; i < 50; i++) {
+        Mesh *repeatMesh = csg.Evaluate(root, 4);
+        CHECK(repeatMesh != nullptr);
+        if (i == 0) {
+            for (int k = 0; k < 4; k++)
+                CHECK(IsSameMesh(*sphereList[k], *copyList[k]));
+        }
+        delete repeatMesh;
+    }
+
+    for (Mesh *sphere: sphereList)
+        delete sphere;
+    for (Mesh *sphere: copyList)
+        delete sphere;
+}
+
+void TestRelease() {
+    /// A chain holds one intermediate result at a time: each is freed once its only consumer is done
+    const int sphereNum = 12;
+    std::vector<Mesh *> sphereList = CreateSpheres(sphereNum);
+    MeshCSG csg;
+    int chain = csg.AddMesh(sphereList[0]);
+    for (int i = 1; i < sphereNum; i++)
+        chain = csg.Connect(chain, csg.AddMesh(sphereList[i]));
+
+    MeshCSGStats stats;
+    Mesh *mesh = csg.Evaluate(chain, 1, &stats);
+    CHECK(stats.numEvaluate == sphereNum - 1);
+    CHECK(stats.numPeakResult == 2);
+    CHECK(mesh != nullptr && mesh->GetFaceM().rows() == sphereNum * sphereList[0]->GetFaceM().rows());
+    delete mesh;
+
+    /// A result read by two operations survives the first one
+    int shared = csg.Connect(csg.AddMesh(sphereList[0]), csg.AddMesh(sphereList[1]));
+    int root = csg.Connect(csg.Connect(shared, csg.AddMesh(sphereList[2])), shared);
+    mesh = csg.Evaluate(root, 1, &stats);
+    CHECK(stats.numEvaluate == 3);
+    CHECK(mesh != nullptr && mesh->GetFaceM().rows() == 5 * sphereList[0]->GetFaceM().rows());
+    delete mesh;
+
+    for (Mesh *sphere: sphereList)
+        delete sphere;
+}
+
+void TestException() {
+    /// The failure of one operation is rethrown by Evaluate after the running ones are done
+    std::vector<Mesh *> sphereList = CreateSpheres(8);
+    FailingCSG csg;
+    std::vector<int> leafList;
+    for (Mesh *sphere: sphereList)
+        leafList.push_back(csg.AddMesh(sphere));
+    int unionID = csg.Union(leafList);
+    int root = csg.Connect(unionID, csg.XOR(leafList[0], leafList[7]));
+
+    for (int threadNum: {1, 4}) {
+        bool isThrown = false;
+        try {
+            Mesh *mesh = csg.Evaluate(root, threadNum);
+            delete mesh;
+        } catch (const std::runtime_error &error) {
+            isThrown = std::string(error.what()) == "XOR failed";
+        }
+        CHECK(isThrown);
+    }
+
+    /// The pool is not left blocked
+    Mesh *mesh = csg.Evaluate(unionID, 4);
+    CHECK(mesh != nullptr && mesh->GetFaceM().rows() == 8 * sphereList[0]->GetFaceM().rows());
+    delete mesh;
+
+    for (Mesh *sphere: sphereList)
+        delete sphere;
+}
+
+int main() {
+    TestDedup();
+    TestEvaluate();
+    TestRelease();
+    TestException();
+    return ReportTest("CSGTest");
+}
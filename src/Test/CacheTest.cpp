@@ -0,0 +1,254 @@
+/// ========================================
+///
+///     CacheTest.cpp
+///
+///     Lookups, collisions, eviction and the
+///     disk tier of the boolean result cache
+///
+/// ========================================
+
+#include <fstream>
+
+#include "Mesh/MeshCache.h"
+#include "Mesh/MeshCreator.h"
+#include "Test/TestUtil.h"
+
+/// ========================================
+///                 Helpers
+/// ========================================
+
+bool IsSameMesh(const Mesh &meshA, const Mesh &meshB) {
+    return meshA.GetVerM().rows() == meshB.GetVerM().rows() && meshA.GetFaceM().rows() == meshB.GetFaceM().rows() &&
+           meshA.GetVerM() == meshB.GetVerM() && meshA.GetFaceM() == meshB.GetFaceM();
+}
+
+size_t GetMeshBytes(const Mesh &mesh) {
+    return mesh.GetVerM().size() * sizeof(double) + mesh.GetFaceM().size() * sizeof(int);
+}
+
+/// An empty directory of its own for each test
+std::string CreateCacheDir(const std::string &name) {
+    std::filesystem::path dir = std::filesystem::temp_directory_path() / ("MeshCacheTest_" + name);
+    std::filesystem::remove_all(dir);
+    return dir.string();
+}
+
+/// The only entry written to a directory
+std::filesystem::path GetOnlyEntry(const std::string &dir) {
+    std::filesystem::path path;
+    int entryNum = 0;
+    for (const auto &entry: std::filesystem::directory_iterator(dir)) {
+        path = entry.path();
+        entryNum++;
+    }
+    CHECK(entryNum == 1);
+    return path;
+}
+
+std::string ReadBytes(const std::filesystem::path &path) {
+    std::ifstream file(path, std::ios::binary);
+    return std::string(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+}
+
+void WriteBytes(const std::filesystem::path &path, const std::string &bytes) {
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    file.write(bytes.data(), static_cast<std::streamsize>(bytes.size()));
+}
+
+/// ========================================
+///                 Tests
+/// ========================================
+
+void TestHit() {
+    /// A result is returned as a copy of what was inserted, under the key of the same inputs
+    Mesh *sphere = MeshCreator::CreateSphere(1.0, 16);
+    Mesh *cuboid = MeshCreator::CreateCuboid(Eigen::Vector3d(0, 0, 0), Eigen::Vector3d(1, 2, 3));
+    Mesh *result = MeshCreator::CreateSphere(Eigen::Vector3d(0.5, 0, 0), 0.7, 12);
+    MeshCache cache;
+
+    MeshCacheKey key = MeshCache::HashKey(*sphere, *cuboid, 1);
+    CHECK(cache.Find(key) == nullptr);
+    cache.Insert(key, *result);
+
+    Mesh *copyA = MeshCreator::CreateSphere(1.0, 16);
+    Mesh *copyB = MeshCreator::CreateCuboid(Eigen::Vector3d(0, 0, 0), Eigen::Vector3d(1, 2, 3));
+    MeshCacheKey copyKey = MeshCache::HashKey(*copyA, *copyB, 1);
+    CHECK(copyKey == key);
+    Mesh *found = cache.Find(copyKey);
+    CHECK(found != nullptr && found != result && IsSameMesh(*found, *result));
+    delete found;
+
+    /// Another operation, the operands swapped or a moved operand are other keys
+    CHECK(cache.Find(MeshCache::HashKey(*sphere, *cuboid, 2)) == nullptr);
+    CHECK(cache.Find(MeshCache::HashKey(*cuboid, *sphere, 1)) == nullptr);
+    copyA->Transform(GetTranslationMatrix(Eigen::Vector3d(1e-9, 0, 0)));
+    CHECK(cache.Find(MeshCache::HashKey(*copyA, *copyB, 1)) == nullptr);
+
+    MeshCacheStats stats = cache.GetStats();
+    CHECK(stats.numHit == 1);
+    CHECK(stats.numMiss == 4);
+    CHECK(stats.memoryBytes == GetMeshBytes(*result));
+
+    cache.Clear();
+    CHECK(cache.Find(key) == nullptr);
+    CHECK(cache.GetStats().memoryBytes == 0);
+
+    delete sphere;
+    delete cuboid;
+    delete result;
+    delete copyA;
+    delete copyB;
+}
+
+void TestCollision() {
+    /// A key whose lookup hash collides with a cached one is a miss, not the other result
+    Mesh *result = MeshCreator::CreateSphere(1.0, 12);
+    MeshCache cache;
+    MeshCacheKey key;
+    key.hash = 42;
+    key.checkHash = 7;
+    std::fill(key.sizeList, key.sizeList + 5, 10);
+    cache.Insert(key, *result);
+
+    MeshCacheKey checkKey = key;
+    checkKey.checkHash = 8;
+    CHECK(cache.Find(checkKey) == nullptr);
+    MeshCacheKey sizeKey = key;
+    sizeKey.sizeList[3] = 11;
+    CHECK(cache.Find(sizeKey) == nullptr);
+
+    Mesh *found = cache.Find(key);
+    CHECK(found != nullptr && IsSameMesh(*found, *result));
+    delete found;
+
+    /// Inserting the colliding key replaces the entry
+    Mesh *other = MeshCreator::CreateSphere(2.0, 8);
+    cache.Insert(checkKey, *other);
+    CHECK(cache.Find(key) == nullptr);
+    found = cache.Find(checkKey);
+    CHECK(found != nullptr && IsSameMesh(*found, *other));
+    delete found;
+    CHECK(cache.GetStats().memoryBytes == GetMeshBytes(*other));
+
+    delete result;
+    delete other;
+}
+
+void TestEviction() {
+    /// Three results of the same size in a budget of two: the least recently used one is dropped
+    std::vector<Mesh *> resultList;
+    std::vector<MeshCacheKey> keyList;
+    for (int i = 0; i < 3; i++) {
+        resultList.push_back(MeshCreator::CreateSphere(1.0 + i, 12));
+        keyList.push_back(MeshCache::HashKey(*resultList[i], *resultList[i], 0));
+    }
+    size_t bytes = GetMeshBytes(*resultList[0]);
+    MeshCache cache(2 * bytes + bytes / 2);
+
+    cache.Insert(keyList[0], *resultList[0]);
+    cache.Insert(keyList[1], *resultList[1]);
+    /// A hit makes 0 the most recent, so 1 goes
+    delete cache.Find(keyList[0]);
+    cache.Insert(keyList[2], *resultList[2]);
+
+    MeshCacheStats stats = cache.GetStats();
+    CHECK(stats.numEviction == 1);
+    CHECK(stats.memoryBytes == 2 * bytes);
+    for (int i: {0, 2}) {
+        Mesh *found = cache.Find(keyList[i]);
+        CHECK(found != nullptr && IsSameMesh(*found, *resultList[i]));
+        delete found;
+    }
+    CHECK(cache.Find(keyList[1]) == nullptr);
+
+    /// A smaller budget evicts down to it; a result larger than the budget is not kept
+    cache.SetMemoryBudget(bytes);
+    stats = cache.GetStats();
+    CHECK(stats.numEviction == 2);
+    CHECK(stats.memoryBytes == bytes);
+    CHECK(cache.Find(keyList[0]) == nullptr);
+    delete cache.Find(keyList[2]);
+
+    Mesh *large = MeshCreator::CreateSphere(1.0, 32);
+    MeshCacheKey largeKey = MeshCache::HashKey(*large, *large, 0);
+    cache.Insert(largeKey, *large);
+    CHECK(cache.Find(largeKey) == nullptr);
+    CHECK(cache.GetStats().memoryBytes <= bytes);
+
+    for (Mesh *result: resultList)
+        delete result;
+    delete large;
+}
+
+void TestDisk() {
+    /// A result written by one cache is read by another over the same directory, then kept in its memory
+    std::string dir = CreateCacheDir("Disk");
+    Mesh *result = MeshCreator::CreateSphere(Eigen::Vector3d(1, 2, 3), 0.5, 16);
+    MeshCacheKey key = MeshCache::HashKey(*result, *result, 3);
+    {
+        MeshCache cache(256 << 20, dir);
+        cache.Insert(key, *result);
+    }
+    std::filesystem::path path = GetOnlyEntry(dir);
+    std::string bytes = ReadBytes(path);
+    CHECK(bytes.compare(0, 4, "MBC3") == 0);
+
+    MeshCache cache(256 << 20, dir);
+    Mesh *found = cache.Find(key);
+    CHECK(found != nullptr && IsSameMesh(*found, *result));
+    delete found;
+    found = cache.Find(key);
+    CHECK(found != nullptr && IsSameMesh(*found, *result));
+    delete found;
+    MeshCacheStats stats = cache.GetStats();
+    CHECK(stats.numDiskHit == 1);
+    CHECK(stats.numHit == 1);
+
+    /// The same file under another key (its name is only the lookup hash) is not trusted
+    MeshCacheKey otherKey = key;
+    otherKey.checkHash++;
+    CHECK(MeshCache(256 << 20, dir).Find(otherKey) == nullptr);
+
+    /// Damaged files are misses: each is checked by a fresh cache, whose memory tier is empty
+    auto IsRejected = [&](const std::string &fileBytes) {
+        WriteBytes(path, fileBytes);
+        MeshCache freshCache(256 << 20, dir);
+        Mesh *mesh = freshCache.Find(key);
+        delete mesh;
+        return mesh == nullptr && freshCache.GetStats().numMiss == 1;
+    };
+    size_t headerSize = 4 + 2 * sizeof(uint64_t) + 5 * sizeof(int64_t) + 2 * sizeof(int64_t);
+    std::string damaged = bytes;
+    damaged[3] = '2';
+    CHECK(IsRejected(damaged));
+    CHECK(IsRejected(bytes.substr(0, bytes.size() - 1)));
+    CHECK(IsRejected(bytes.substr(0, headerSize)));
+    CHECK(IsRejected(bytes.substr(0, 10)));
+    CHECK(IsRejected(""));
+    CHECK(IsRejected(bytes + "x"));
+
+    /// A vertex number that does not match the size, and a face indexing past the vertices
+    damaged = bytes;
+    int64_t verNum = result->GetVerM().rows() + 1;
+    damaged.replace(headerSize - 2 * sizeof(int64_t), sizeof(verNum), reinterpret_cast<const char *>(&verNum),
+                    sizeof(verNum));
+    CHECK(IsRejected(damaged));
+    damaged = bytes;
+    int index = static_cast<int>(result->GetVerM().rows());
+    damaged.replace(bytes.size() - sizeof(int), sizeof(int), reinterpret_cast<const char *>(&index), sizeof(int));
+    CHECK(IsRejected(damaged));
+
+    /// The intact file is read again
+    CHECK(!IsRejected(bytes));
+
+    std::filesystem::remove_all(dir);
+    delete result;
+}
+
+int main() {
+    TestHit();
+    TestCollision();
+    TestEviction();
+    TestDisk();
+    return ReportTest("CacheTest");
+}
@@ -0,0 +1,232 @@
+/// ========================================
+///
+///     CollisionTest.cpp
+///
+///     Collision detection against brute force
+///     over all pairs of faces
+///
+/// ========================================
+
+#include <set>
+#include <random>
+
+#include "Mesh/MeshCollision.h"
+#include "Mesh/MeshCreator.h"
+#include "Test/TestUtil.h"
+
+typedef std::set<std::pair<int, int>> FacePairSet;
+
+/// ========================================
+///              Brute Force
+/// ========================================
+
+/// Segment pq against a triangle (Moller-Trumbore with t in [0, 1])
+bool IntersectSegmentBrute(const Eigen::Vector3d &p, const Eigen::Vector3d &q, const Eigen::Vector3d &v0,
+                           const Eigen::Vector3d &v1, const Eigen::Vector3d &v2) {
+    Eigen::Vector3d dir = q - p;
+    Eigen::Vector3d e1 = v1 - v0;
+    Eigen::Vector3d e2 = v2 - v0;
+    Eigen::Vector3d h = dir.cross(e2);
+    double det = e1.dot(h);
+    if (std::abs(det) < 1e-300)
+        return false;
+    Eigen::Vector3d s = p - v0;
+    double u = s.dot(h) / det;
+    Eigen::Vector3d r = s.cross(e1);
+    double v = dir.dot(r) / det;
+    double t = e2.dot(r) / det;
+    return u >= 0 && v >= 0 && u + v <= 1 && t >= 0 && t <= 1;
+}
+
+/// Two triangles in general position cross iff an edge of one passes through the other
+bool IntersectTrianglesBrute(const Eigen::Vector3d triA[3], const Eigen::Vector3d triB[3]) {
+    for (int k = 0; k < 3; k++) {
+        if (IntersectSegmentBrute(triA[k], triA[(k + 1) % 3], triB[0], triB[1], triB[2]) ||
+            IntersectSegmentBrute(triB[k], triB[(k + 1) % 3], triA[0], triA[1], triA[2]))
+            return true;
+    }
+    return false;
+}
+
+/// All crossing pairs of faces of two meshes placed in the world
+FacePairSet CollideBrute(const Mesh &meshA, const Eigen::Affine3d &matA, const Mesh &meshB,
+                         const Eigen::Affine3d &matB) {
+    FacePairSet facePairSet;
+    for (int i = 0; i < meshA.GetFaceM().rows(); i++) {
+        Eigen::Vector3d triA[3];
+        for (int k = 0; k < 3; k++)
+            triA[k] = matA * meshA.GetVerM().row(meshA.GetFaceM()(i, k)).transpose();
+        for (int j = 0; j < meshB.GetFaceM().rows(); j++) {
+            Eigen::Vector3d triB[3];
+            for (int k = 0; k < 3; k++)
+                triB[k] = matB * meshB.GetVerM().row(meshB.GetFaceM()(j, k)).transpose();
+            if (IntersectTrianglesBrute(triA, triB))
+                facePairSet.emplace(i, j);
+        }
+    }
+    return facePairSet;
+}
+
+FacePairSet GetFacePairs(const CollisionPair &pair) {
+    FacePairSet facePairSet;
+    for (const MeshContact &contact: pair.contactList)
+        facePairSet.emplace(contact.faceA, contact.faceB);
+    return facePairSet;
+}
+
+/// ========================================
+///                 Tests
+/// ========================================
+
+/// Every contact is wanted, however long it takes
+void SetExhaustive(MeshCollision &collision) {
+    collision.TimeBudget = 1e6;
+    collision.MaxContactNum = std::numeric_limits<int>::max();
+}
+
+void TestTwoSpheres() {
+    /// Overlapping spheres: the contacts are exactly the crossing faces
+    Mesh *sphereA = MeshCreator::CreateSphere(Eigen::Vector3d(0, 0, 0), 1.0, 24);
+    Mesh *sphereB = MeshCreator::CreateSphere(Eigen::Vector3d(1.3, 0.17, -0.11), 0.8, 20);
+    MeshCollision collision;
+    SetExhaustive(collision);
+    int objectA = collision.AddObject(sphereA);
+    int objectB = collision.AddObject(sphereB);
+
+    std::vector<CollisionPair> pairList;
+    CHECK(collision.DetectCollisions(pairList) == 1);
+    CHECK(pairList.size() == 1);
+    if (pairList.size() == 1) {
+        const CollisionPair &pair = pairList[0];
+        CHECK(pair.isComplete);
+        CHECK(pair.objectA == objectA && pair.objectB == objectB);
+        FacePairSet facePairSet = CollideBrute(*sphereA, Eigen::Affine3d::Identity(), *sphereB,
+                                               Eigen::Affine3d::Identity());
+        CHECK(!facePairSet.empty());
+        CHECK(GetFacePairs(pair) == facePairSet);
+        CHECK(pair.contactList.size() == facePairSet.size());
+
+        double maxDepth = 0;
+        for (const MeshContact &contact: pair.contactList) {
+            maxDepth = std::max(maxDepth, contact.depth);
+            /// Contacts lie on both surfaces, i.e. on the circle where the spheres cross (up to tessellation)
+            CHECK(std::abs(contact.point.norm() - 1.0) < 0.05);
+            CHECK(std::abs((contact.point - Eigen::Vector3d(1.3, 0.17, -0.11)).norm() - 0.8) < 0.05);
+        }
+        CHECK(pair.penetrationDepth > 0);
+        CHECK(pair.penetrationDepth == maxDepth);
+    }
+
+    /// Moved apart: no pair at all
+    collision.SetTransform(objectB, GetTranslationMatrix(Eigen::Vector3d(1.5, 0, 0)));
+    CHECK(collision.DetectCollisions(pairList) == 0);
+    CHECK(pairList.empty());
+
+    /// Moved back into A, rotated: the narrow phase runs in the frame of A with the relative transform
+    std::mt19937 generator(5);
+    std::uniform_real_distribution<double> coord(-1.0, 1.0);
+    for (int i = 0; i < 8; i++) {
+        Eigen::Vector3d axis = Eigen::Vector3d(coord(generator), coord(generator), coord(generator)).normalized();
+        Eigen::Affine3d matA = GetRotationMatrix(axis, 3 * coord(generator));
+        Eigen::Affine3d matB = GetTranslationMatrix(Eigen::Vector3d(-1.2, 0.3 * coord(generator), 0.1)) *
+                               GetRotationMatrix(axis.cross(Eigen::Vector3d::UnitZ()).normalized(), 3 * coord(generator));
+        collision.SetTransform(objectA, matA);
+        collision.SetTransform(objectB, matB);
+        FacePairSet facePairSet = CollideBrute(*sphereA, matA, *sphereB, matB);
+        int collisionNum = collision.DetectCollisions(pairList);
+        CHECK(collisionNum == (facePairSet.empty() ? 0 : 1));
+        CHECK(pairList.size() == (facePairSet.empty() ? 0 : 1));
+        if (pairList.size() == 1)
+            CHECK(GetFacePairs(pairList[0]) == facePairSet);
+    }
+
+    /// A sphere inside the other: the boxes overlap but the surfaces do not cross
+    collision.SetTransform(objectA, Eigen::Affine3d::Identity());
+    collision.SetTransform(objectB, GetTranslationMatrix(Eigen::Vector3d(-1.25, -0.17, 0.11)));
+    std::vector<std::pair<int, int>> overlapPairList;
+    collision.ComputeOverlapPairs(overlapPairList);
+    CHECK(overlapPairList.size() == 1);
+    CHECK(collision.DetectCollisions(pairList) == 0);
+    CHECK(pairList.empty());
+
+    delete sphereA;
+    delete sphereB;
+}
+
+void TestManyObjects() {
+    /// A row of spheres, each crossing its neighbours only: the broad phase must find every pair
+    std::vector<Mesh *> sphereList;
+    MeshCollision collision;
+    SetExhaustive(collision);
+    const int sphereNum = 6;
+    for (int i = 0; i < sphereNum; i++) {
+        sphereList.push_back(MeshCreator::CreateSphere(Eigen::Vector3d(0, 0.01 * i, 0), 0.6, 12));
+        collision.AddObject(sphereList.back(), GetTranslationMatrix(Eigen::Vector3d(1.03 * i, 0, 0.02 * i)));
+    }
+    /// A disabled object is skipped even though it crosses the others
+    Mesh *cuboid = MeshCreator::CreateCuboid(Eigen::Vector3d(-1, -0.1, -0.1), Eigen::Vector3d(8, 0.1, 0.1));
+    int cuboidID = collision.AddObject(cuboid);
+    collision.SetEnabled(cuboidID, false);
+
+    std::vector<CollisionPair> pairList;
+    CHECK(collision.DetectCollisions(pairList) == sphereNum - 1);
+    std::set<std::pair<int, int>> objectPairSet;
+    for (const CollisionPair &pair: pairList) {
+        CHECK(pair.isComplete);
+        objectPairSet.emplace(pair.objectA, pair.objectB);
+        Eigen::Affine3d matA = GetTranslationMatrix(Eigen::Vector3d(1.03 * pair.objectA, 0, 0.02 * pair.objectA));
+        Eigen::Affine3d matB = GetTranslationMatrix(Eigen::Vector3d(1.03 * pair.objectB, 0, 0.02 * pair.objectB));
+        CHECK(GetFacePairs(pair) == CollideBrute(*sphereList[pair.objectA], matA, *sphereList[pair.objectB], matB));
+    }
+    for (int i = 0; i + 1 < sphereNum; i++)
+        CHECK(objectPairSet.count(std::make_pair(i, i + 1)) == 1);
+
+    /// Enabled, it crosses all of them
+    collision.SetEnabled(cuboidID, true);
+    CHECK(collision.DetectCollisions(pairList) == 2 * sphereNum - 1);
+
+    /// A capped number of contacts still reports the pair
+    collision.MaxContactNum = 4;
+    collision.DetectCollisions(pairList);
+    for (const CollisionPair &pair: pairList)
+        CHECK(pair.contactList.size() <= 4 && !pair.contactList.empty());
+
+    for (Mesh *sphere: sphereList)
+        delete sphere;
+    delete cuboid;
+}
+
+void TestTriangles() {
+    /// The triangle test against the edge crossings, on random triangles in a small box
+    std::mt19937 generator(3);
+    std::uniform_real_distribution<double> coord(-1.0, 1.0);
+    int hitNum = 0;
+    for (int i = 0; i < 20000; i++) {
+        Eigen::Vector3d triA[3], triB[3];
+        for (int k = 0; k < 3; k++) {
+            triA[k] = Eigen::Vector3d(coord(generator), coord(generator), coord(generator));
+            triB[k] = Eigen::Vector3d(coord(generator), coord(generator), coord(generator));
+        }
+        Eigen::Vector3d segStart, segEnd;
+        bool isHit = MeshCollision::IntersectTriangles(triA[0], triA[1], triA[2], triB[0], triB[1], triB[2],
+                                                       segStart, segEnd);
+        bool isHitBrute = IntersectTrianglesBrute(triA, triB);
+        CHECK(isHit == isHitBrute);
+        if (isHit && isHitBrute) {
+            hitNum++;
+            /// The end points lie in both planes
+            Eigen::Vector3d normalA = (triA[1] - triA[0]).cross(triA[2] - triA[0]).normalized();
+            Eigen::Vector3d normalB = (triB[1] - triB[0]).cross(triB[2] - triB[0]).normalized();
+            CHECK(std::abs(normalA.dot(segStart - triA[0])) < 1e-9 && std::abs(normalA.dot(segEnd - triA[0])) < 1e-9);
+            CHECK(std::abs(normalB.dot(segStart - triB[0])) < 1e-9 && std::abs(normalB.dot(segEnd - triB[0])) < 1e-9);
+        }
+    }
+    CHECK(hitNum > 1000);
+}
+
+int main() {
+    TestTriangles();
+    TestTwoSpheres();
+    TestManyObjects();
+    return ReportTest("CollisionTest");
+}
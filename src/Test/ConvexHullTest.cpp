@@ -0,0 +1,200 @@
+/// ========================================
+///
+///     ConvexHullTest.cpp
+///
+///     Quickhull against the CGAL hull
+///
+/// ========================================
+
+#include <map>
+#include <array>
+#include <random>
+#include <Eigen/Geometry>
+
+#include <igl/copyleft/cgal/convex_hull.h>
+
+#include "Mesh/MeshConvexHull.h"
+#include "Test/TestUtil.h"
+
+/// ========================================
+///                 Helpers
+/// ========================================
+
+std::vector<std::array<double, 3>> GetSortedRows(const Eigen::MatrixXd &verM) {
+    std::vector<std::array<double, 3>> rowList;
+    for (long i = 0; i < verM.rows(); i++)
+        rowList.push_back({verM(i, 0), verM(i, 1), verM(i, 2)});
+    std::sort(rowList.begin(), rowList.end());
+    return rowList;
+}
+
+/// Signed volume and area of a closed triangle mesh (relative to its first vertex, which may be far from the origin)
+void ComputeVolumeArea(const Eigen::MatrixXd &verM, const Eigen::MatrixXi &faceM, double &volume, double &area) {
+    volume = 0;
+    area = 0;
+    for (long i = 0; i < faceM.rows(); i++) {
+        Eigen::Vector3d v0 = (verM.row(faceM(i, 0)) - verM.row(0)).transpose();
+        Eigen::Vector3d v1 = (verM.row(faceM(i, 1)) - verM.row(0)).transpose();
+        Eigen::Vector3d v2 = (verM.row(faceM(i, 2)) - verM.row(0)).transpose();
+        volume += v0.dot(v1.cross(v2)) / 6.0;
+        area += 0.5 * (v1 - v0).cross(v2 - v0).norm();
+    }
+}
+
+/// A closed, outward oriented hull with every point on the inner side of every face
+void CheckHull(const Eigen::MatrixXd &hullVerM, const Eigen::MatrixX3i &hullFaceM, const Eigen::MatrixX3d &verM) {
+    /// Each edge is used once in each direction
+    std::map<std::pair<int, int>, int> edgeCountMap;
+    for (long i = 0; i < hullFaceM.rows(); i++) {
+        for (int k = 0; k < 3; k++)
+            edgeCountMap[std::make_pair(hullFaceM(i, k), hullFaceM(i, (k + 1) % 3))]++;
+    }
+    bool isClosed = !edgeCountMap.empty();
+    for (const auto &edgeCount: edgeCountMap) {
+        auto reverseEdge = edgeCountMap.find(std::make_pair(edgeCount.first.second, edgeCount.first.first));
+        isClosed = isClosed && edgeCount.second == 1 && reverseEdge != edgeCountMap.end() && reverseEdge->second == 1;
+    }
+    CHECK(isClosed);
+    CHECK(hullVerM.rows() - edgeCountMap.size() / 2 + hullFaceM.rows() == 2);
+
+    double scale = verM.cwiseAbs().maxCoeff();
+    bool isInside = true;
+    for (long i = 0; i < hullFaceM.rows(); i++) {
+        Eigen::Vector3d v0 = hullVerM.row(hullFaceM(i, 0)).transpose();
+        Eigen::Vector3d v1 = hullVerM.row(hullFaceM(i, 1)).transpose();
+        Eigen::Vector3d v2 = hullVerM.row(hullFaceM(i, 2)).transpose();
+        Eigen::Vector3d normal = (v1 - v0).cross(v2 - v0).normalized();
+        for (long j = 0; j < verM.rows(); j++)
+            isInside = isInside && normal.dot(verM.row(j).transpose() - v0) <= 1e-12 * scale;
+    }
+    CHECK(isInside);
+
+    /// Hull vertices are input points
+    std::vector<std::array<double, 3>> rowList = GetSortedRows(verM);
+    bool isInput = true;
+    for (long i = 0; i < hullVerM.rows(); i++) {
+        std::array<double, 3> row = {hullVerM(i, 0), hullVerM(i, 1), hullVerM(i, 2)};
+        isInput = isInput && std::binary_search(rowList.begin(), rowList.end(), row);
+    }
+    CHECK(isInput);
+}
+
+/// Same extreme points, volume and area as the hull of CGAL (whose triangulation of coplanar faces may differ)
+void CheckSameAsCGAL(const MeshConvexHull &hull, const Eigen::MatrixX3d &verM) {
+    Eigen::MatrixXd hullVerM, cgalVerM;
+    Eigen::MatrixX3i hullFaceM;
+    Eigen::MatrixXi cgalFaceM;
+    hull.GetHull(hullVerM, hullFaceM);
+    igl::copyleft::cgal::convex_hull(Eigen::MatrixXd(verM), cgalVerM, cgalFaceM);
+
+    CheckHull(hullVerM, hullFaceM, verM);
+    CHECK(GetSortedRows(hullVerM) == GetSortedRows(cgalVerM));
+
+    double volume, area, cgalVolume, cgalArea;
+    ComputeVolumeArea(hullVerM, hullFaceM, volume, area);
+    ComputeVolumeArea(cgalVerM, cgalFaceM, cgalVolume, cgalArea);
+    CHECK(volume > 0);
+    CHECK(IsClose(volume, cgalVolume, 1e-9));
+    CHECK(IsClose(area, cgalArea, 1e-9));
+}
+
+/// ========================================
+///                 Tests
+/// ========================================
+
+Eigen::MatrixX3d CreateBallPoints(std::mt19937 &generator, long pointNum, bool isOnSphere) {
+    std::normal_distribution<double> normal(0.0, 1.0);
+    std::uniform_real_distribution<double> uniform(0.0, 1.0);
+    Eigen::MatrixX3d verM(pointNum, 3);
+    for (long i = 0; i < pointNum; i++) {
+        Eigen::Vector3d point = Eigen::Vector3d(normal(generator), normal(generator), normal(generator)).normalized();
+        verM.row(i) = (isOnSphere ? point : std::cbrt(uniform(generator)) * point).transpose();
+    }
+    return verM;
+}
+
+void TestGeneralPosition() {
+    /// Random points are in general position: quickhull must decide every predicate itself
+    std::mt19937 generator(13);
+    for (long pointNum: {4L, 50L, 2000L}) {
+        for (bool isOnSphere: {false, true}) {
+            Eigen::MatrixX3d verM = CreateBallPoints(generator, pointNum, isOnSphere);
+            MeshConvexHull hull;
+            hull.Build(verM);
+            CHECK(!hull.IsExactMode());
+            CheckSameAsCGAL(hull, verM);
+        }
+    }
+
+    /// Far from the origin and stretched, so that the error bounds of the filter are scaled
+    Eigen::MatrixX3d verM = CreateBallPoints(generator, 1000, false);
+    verM = (verM * Eigen::Vector3d(1e3, 1, 1e-2).asDiagonal()).rowwise() + Eigen::RowVector3d(1e5, -2e4, 3e3);
+    MeshConvexHull hull;
+    hull.Build(verM);
+    CheckSameAsCGAL(hull, verM);
+}
+
+void TestAddPoints() {
+    /// Grown in batches, the hull is the hull of all the points so far
+    std::mt19937 generator(17);
+    Eigen::MatrixX3d verM = CreateBallPoints(generator, 1500, false);
+    MeshConvexHull hull;
+    hull.Build(verM.topRows(500));
+    hull.AddPoints(verM.middleRows(500, 500));
+    CheckSameAsCGAL(hull, verM.topRows(1000));
+    /// Points further out replace most of the hull
+    Eigen::MatrixX3d outerM = 1.5 * verM.bottomRows(500);
+    hull.AddPoints(outerM);
+    Eigen::MatrixX3d allM(1500, 3);
+    allM << verM.topRows(1000), outerM;
+    CheckSameAsCGAL(hull, allM);
+}
+
+void TestDegenerate() {
+    /// Corners of a cube and grid points inside its faces: coplanar points on the hull send it to the CGAL fallback
+    Eigen::MatrixX3d verM(8 + 6 * 9, 3);
+    int pointNum = 0;
+    for (int corner = 0; corner < 8; corner++)
+        verM.row(pointNum++) = Eigen::RowVector3d(corner & 1, (corner >> 1) & 1, (corner >> 2) & 1);
+    for (int axis = 0; axis < 3; axis++) {
+        for (int side = 0; side < 2; side++) {
+            for (int i = 1; i < 4; i++) {
+                for (int j = 1; j < 4; j++) {
+                    Eigen::Vector3d point;
+                    point[axis] = side;
+                    point[(axis + 1) % 3] = i / 4.0;
+                    point[(axis + 2) % 3] = j / 4.0;
+                    verM.row(pointNum++) = point.transpose();
+                }
+            }
+        }
+    }
+    MeshConvexHull hull;
+    hull.Build(verM);
+    CHECK(hull.IsExactMode());
+    CheckSameAsCGAL(hull, verM);
+
+    Eigen::MatrixXd hullVerM;
+    Eigen::MatrixX3i hullFaceM;
+    hull.GetHull(hullVerM, hullFaceM);
+    double volume, area;
+    ComputeVolumeArea(hullVerM, hullFaceM, volume, area);
+    CHECK(hullVerM.rows() == 8);
+    CHECK(IsClose(volume, 1.0, 1e-12));
+    CHECK(IsClose(area, 6.0, 1e-12));
+
+    /// Points added after the fallback go through CGAL as well
+    Eigen::MatrixX3d extraM(2, 3);
+    extraM << 0.5, 0.5, 2, 0.5, 0.5, 0.5;
+    hull.AddPoints(extraM);
+    Eigen::MatrixX3d allM(verM.rows() + 2, 3);
+    allM << verM, extraM;
+    CheckSameAsCGAL(hull, allM);
+}
+
+int main() {
+    TestGeneralPosition();
+    TestAddPoints();
+    TestDegenerate();
+    return ReportTest("ConvexHullTest");
+}
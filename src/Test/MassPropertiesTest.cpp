@@ -0,0 +1,91 @@
+/// ========================================
+///
+///     MassPropertiesTest.cpp
+///
+///     Mass properties against analytic solids
+///
+/// ========================================
+
+#include "Mesh/MeshCreator.h"
+#include "Utility/HelpFunc.h"
+#include "Test/TestUtil.h"
+
+/// Inertia of a solid box of unit density about its center
+Eigen::Matrix3d GetCuboidInertia(const Eigen::Vector3d &sizeVec) {
+    double volume = sizeVec.prod();
+    Eigen::Vector3d sq = sizeVec.cwiseAbs2();
+    return volume / 12.0 * Eigen::Vector3d(sq.y() + sq.z(), sq.x() + sq.z(), sq.x() + sq.y()).asDiagonal();
+}
+
+void TestCuboid() {
+    /// Flat faces: exact up to rounding
+    Eigen::Vector3d minPt(1.0, -2.0, 0.5), maxPt(3.0, 1.0, 4.5);
+    Eigen::Vector3d sizeVec = maxPt - minPt;
+    Mesh *mesh = MeshCreator::CreateCuboid(minPt, maxPt);
+    MeshMassProperties massProp = mesh->ComputeMassProperties();
+
+    CHECK(IsClose(massProp.volume, sizeVec.prod(), 1e-12));
+    CHECK(IsClose(massProp.area, 2.0 * (sizeVec.x() * sizeVec.y() + sizeVec.y() * sizeVec.z() + sizeVec.x() * sizeVec.z()), 1e-12));
+    CHECK(IsClose(massProp.volumeCentroid, 0.5 * (minPt + maxPt), 1e-12));
+    CHECK(IsClose(massProp.surfaceCentroid, 0.5 * (minPt + maxPt), 1e-12));
+    CHECK(IsClose(massProp.inertia, GetCuboidInertia(sizeVec), 1e-12));
+    CHECK(IsClose(massProp.box.min(), minPt, 1e-12) && IsClose(massProp.box.max(), maxPt, 1e-12));
+
+    /// A rigid motion moves the centroid and rotates the inertia tensor: I' = R I R^T
+    Eigen::Affine3d affineMat = GetTranslationMatrix(0.3, 0.7, -1.1) *
+                                GetRotationMatrix(Eigen::Vector3d(1, 2, 3).normalized(), ToRadian(35.0));
+    mesh->Transform(affineMat);
+    MeshMassProperties movedProp = mesh->ComputeMassProperties();
+    Eigen::Matrix3d R = affineMat.linear();
+    CHECK(IsClose(movedProp.volume, massProp.volume, 1e-12));
+    CHECK(IsClose(movedProp.area, massProp.area, 1e-12));
+    CHECK(IsClose(movedProp.volumeCentroid, affineMat * massProp.volumeCentroid, 1e-12));
+    CHECK(IsClose(movedProp.inertia, R * massProp.inertia * R.transpose(), 1e-12));
+    delete mesh;
+}
+
+void TestSphere() {
+    /// The polyhedron converges to the sphere with the square of the sampling step
+    Eigen::Vector3d center(-1.0, 2.0, 0.25);
+    double radius = 1.5;
+    double volume = 4.0 / 3.0 * M_PI * std::pow(radius, 3);
+    double error = 1.0;
+    for (int radSamp: {64, 128}) {
+        Mesh *mesh = MeshCreator::CreateSphere(center, radius, radSamp);
+        MeshMassProperties massProp = mesh->ComputeMassProperties();
+        double relTol = 40.0 / (radSamp * radSamp);
+
+        CHECK(IsClose(massProp.volume, volume, relTol));
+        CHECK(IsClose(massProp.area, 4.0 * M_PI * radius * radius, relTol));
+        CHECK(IsClose(massProp.volumeCentroid, center, 1e-9, 1e-9));
+        CHECK(IsClose(massProp.inertia, (0.4 * volume * radius * radius * Eigen::Matrix3d::Identity()).eval(), relTol));
+
+        /// Inscribed polyhedra are always smaller, and get closer as the sampling gets finer
+        CHECK(massProp.volume < volume);
+        CHECK(volume - massProp.volume < error);
+        error = volume - massProp.volume;
+        delete mesh;
+    }
+}
+
+void TestCylinder() {
+    /// Along an oblique axis: the volume and centroid do not depend on the orientation
+    Eigen::Vector3d capA(0.5, -1.0, 2.0), capB(2.5, 1.0, 3.0);
+    double radius = 0.75;
+    int radSamp = 256;
+    Mesh *mesh = MeshCreator::CreateCylinder(capA, capB, radius, radSamp);
+    MeshMassProperties massProp = mesh->ComputeMassProperties();
+
+    /// The cross-section is a regular polygon: its area is exact
+    double polygonArea = 0.5 * radSamp * radius * radius * std::sin(2.0 * M_PI / radSamp);
+    CHECK(IsClose(massProp.volume, polygonArea * (capB - capA).norm(), 1e-9));
+    CHECK(IsClose(massProp.volumeCentroid, 0.5 * (capA + capB), 1e-9, 1e-9));
+    delete mesh;
+}
+
+int main() {
+    TestCuboid();
+    TestSphere();
+    TestCylinder();
+    return ReportTest("MassPropertiesTest");
+}
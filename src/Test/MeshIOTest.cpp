@@ -0,0 +1,112 @@
+/// ========================================
+///
+///     MeshIOTest.cpp
+///
+///     OBJ reading against igl::readOBJ on
+///     the data files, and malformed input
+///
+/// ========================================
+
+#include <cstring>
+#include <filesystem>
+
+#include <igl/readOBJ.h>
+
+#include "Mesh/MeshIO.h"
+#include "Test/TestUtil.h"
+
+/// ========================================
+///                 Helpers
+/// ========================================
+
+bool ParseText(const std::string &text, Eigen::MatrixX3d &verM, Eigen::MatrixX3i &faceM) {
+    return MeshIO::ParseOBJ(text.data(), text.size(), verM, faceM);
+}
+
+/// The same vertices (bit for bit) and faces as libigl
+void CheckSameAsIGL(const std::string &fileName) {
+    Eigen::MatrixXd V;
+    Eigen::MatrixXi F;
+    Eigen::MatrixX3d verM;
+    Eigen::MatrixX3i faceM;
+    bool isRead = igl::readOBJ(fileName, V, F);
+    CHECK(isRead);
+    CHECK(MeshIO::ReadOBJ(fileName, verM, faceM));
+    bool isSame = isRead && V.rows() == verM.rows() && V.cols() == 3 && F.rows() == faceM.rows() && F.cols() == 3 &&
+                  V == Eigen::MatrixXd(verM) && F == Eigen::MatrixXi(faceM);
+    if (!isSame)
+        printf("%s differs from igl::readOBJ\n", fileName.c_str());
+    CHECK(isSame);
+}
+
+/// ========================================
+///                 Tests
+/// ========================================
+
+void TestDataFiles(const std::string &dataDir) {
+    /// The bunny is large enough to be parsed in several chunks
+    CheckSameAsIGL(dataDir + "/bunny.obj");
+
+    int fileNum = 0;
+    for (const char *subDir: {"Letter", "Number"}) {
+        for (const auto &entry: std::filesystem::directory_iterator(dataDir + "/" + subDir)) {
+            if (entry.path().extension() != ".obj")
+                continue;
+            CheckSameAsIGL(entry.path().string());
+            fileNum++;
+        }
+    }
+    CHECK(fileNum >= 36);
+}
+
+void TestSyntax() {
+    /// Polygons are fan-triangulated, negative indices count back from the last vertex, and only
+    /// the vertex index of "v/vt/vn" is used
+    Eigen::MatrixX3d verM;
+    Eigen::MatrixX3i faceM;
+    std::string text = "# comment\n"
+                       "v 0 0 0\nv 1 0 0\nv 1 1 0\nv 0 1 0 1.0\n"
+                       "vn 0 0 1\nvt 0 0\n"
+                       "f 1/1/1 2/1/1 3/1/1 4/1/1\n"
+                       "f -4 -2 -1  # trailing comment\n"
+                       "f 1//1 3//1 4//1\r\n";
+    CHECK(ParseText(text, verM, faceM));
+    Eigen::MatrixX3i expectFaceM(4, 3);
+    expectFaceM << 0, 1, 2, 0, 2, 3, 0, 2, 3, 0, 2, 3;
+    CHECK(verM.rows() == 4 && verM(2, 0) == 1 && verM(3, 1) == 1);
+    CHECK(faceM == expectFaceM);
+}
+
+void TestInvalidIndex() {
+    /// An index past the vertices, or counting back past the first one, is rejected rather than
+    /// left in the faces
+    std::string vertices = "v 0 0 0\nv 1 0 0\nv 0 1 0\n";
+    Eigen::MatrixX3d verM;
+    Eigen::MatrixX3i faceM;
+    CHECK(ParseText(vertices + "f 1 2 3\n", verM, faceM));
+    CHECK(!ParseText(vertices + "f 1 2 4\n", verM, faceM));
+    CHECK(!ParseText(vertices + "f 1 2 0\n", verM, faceM));
+    CHECK(!ParseText(vertices + "f 1 2 -4\n", verM, faceM));
+    CHECK(!ParseText(vertices + "f 1 2 2147483648\n", verM, faceM));
+    CHECK(!ParseText("f 1 2 3\n", verM, faceM));
+    /// A negative index only sees the vertices above it
+    CHECK(!ParseText("v 0 0 0\nv 1 0 0\nf -1 -2 -3\nv 0 1 0\n", verM, faceM));
+
+    /// The same in a file large enough to be split into chunks: the last chunk refers past the end
+    std::string text;
+    for (int i = 0; i < 200000; i++)
+        text += vertices;
+    for (int i = 0; i < 200000; i++)
+        text += "f 1 2 3\n";
+    CHECK(ParseText(text, verM, faceM));
+    CHECK(verM.rows() == 600000 && faceM.rows() == 200000);
+    CHECK(!ParseText(text + "f 1 2 600001\n", verM, faceM));
+}
+
+int main(int argc, char *argv[]) {
+    std::string dataDir = argc > 1 ? argv[1] : "../data";
+    TestDataFiles(dataDir);
+    TestSyntax();
+    TestInvalidIndex();
+    return ReportTest("MeshIOTest");
+}
@@ -0,0 +1,172 @@
+/// ========================================
+///
+///     PrimitiveTest.cpp
+///
+///     Cached primitives against the loops
+///     of the original generators
+///
+/// ========================================
+
+#include <thread>
+
+#include "Mesh/MeshCreator.h"
+#include "Test/TestUtil.h"
+
+/// Reference generators: the per-vertex loops the templates and ring tables replaced, kept verbatim
+/// (same evaluation order), so the cached primitives must match them bit for bit
+Mesh *CreateReferenceCylinder(double length, double radius, int radSamp) {
+    std::vector<Eigen::Vector3d> verList;
+    std::vector<Eigen::Vector3i> faceList;
+    double halfLength = 0.5f * length;
+    for (int i = 0; i < radSamp; i++) {
+        double beta = i * 2.0 * M_PI / radSamp;
+        verList.emplace_back(halfLength, radius * cos(beta), radius * sin(beta));
+    }
+    for (int i = 0; i < radSamp; i++) {
+        double beta = i * 2.0 * M_PI / radSamp;
+        verList.emplace_back(-halfLength, radius * cos(beta), radius * sin(beta));
+    }
+    verList.emplace_back(halfLength, 0, 0);
+    verList.emplace_back(-halfLength, 0, 0);
+    for (int i = 0; i < radSamp; i++) {
+        int i1 = i;
+        int j1 = (i + 1) % radSamp;
+        int i2 = i + radSamp;
+        int j2 = j1 + radSamp;
+        faceList.emplace_back(i1, j2, j1);
+        faceList.emplace_back(i2, j2, i1);
+        faceList.emplace_back(i1, j1, 2 * radSamp);
+        faceList.emplace_back(j2, i2, 2 * radSamp + 1);
+    }
+    return new Mesh(verList, faceList);
+}
+
+Mesh *CreateReferenceSphere(double radius, int radSamp) {
+    std::vector<Eigen::Vector3d> verList;
+    std::vector<Eigen::Vector3i> faceList;
+    int polarSamp = radSamp / 2;
+    int azimuSamp = radSamp;
+    int midNum = (polarSamp - 1) * azimuSamp;
+    for (int i = 1; i < polarSamp; i++) {
+        double alpha = M_PI_2 - M_PI * i / polarSamp;
+        for (int j = 0; j < azimuSamp; j++) {
+            double beta = j * 2.0 * M_PI / azimuSamp;
+            verList.emplace_back(radius * cos(alpha) * cos(beta), radius * cos(alpha) * sin(beta), radius * sin(alpha));
+        }
+    }
+    verList.emplace_back(0, 0, radius);
+    verList.emplace_back(0, 0, -radius);
+    for (int j = 0; j < azimuSamp; j++)
+        faceList.emplace_back(midNum, j, (j + 1) % azimuSamp);
+    for (int i = 1; i < polarSamp - 1; i++) {
+        for (int j = 0; j < azimuSamp; j++) {
+            int i1 = (i - 1) * azimuSamp + j;
+            int j1 = (i - 1) * azimuSamp + (j + 1) % azimuSamp;
+            int i2 = i * azimuSamp + j;
+            int j2 = i * azimuSamp + (j + 1) % azimuSamp;
+            faceList.emplace_back(i1, i2, j1);
+            faceList.emplace_back(i2, j2, j1);
+        }
+    }
+    for (int j = 0; j < azimuSamp; j++)
+        faceList.emplace_back(midNum + 1, midNum - azimuSamp + (j + 1) % azimuSamp, midNum - azimuSamp + j);
+    return new Mesh(verList, faceList);
+}
+
+Mesh *CreateReferenceCone(double length, double radius, int radSamp) {
+    std::vector<Eigen::Vector3d> verList;
+    std::vector<Eigen::Vector3i> faceList;
+    for (int i = 0; i < radSamp; i++) {
+        double beta = i * 2.0 * M_PI / radSamp;
+        verList.emplace_back(0, radius * cos(beta), radius * sin(beta));
+    }
+    verList.emplace_back(0, 0, 0);
+    verList.emplace_back(length, 0, 0);
+    for (int j = 0; j < radSamp; j++) {
+        faceList.emplace_back(radSamp, (j + 1) % radSamp, j);
+        faceList.emplace_back(radSamp + 1, j, (j + 1) % radSamp);
+    }
+    return new Mesh(verList, faceList);
+}
+
+bool IsIdentical(Mesh *mesh, Mesh *reference) {
+    bool isIdentical = mesh->GetVerM().rows() == reference->GetVerM().rows() &&
+                       mesh->GetFaceM().rows() == reference->GetFaceM().rows() &&
+                       mesh->GetVerM() == reference->GetVerM() && mesh->GetFaceM() == reference->GetFaceM();
+    delete mesh;
+    delete reference;
+    return isIdentical;
+}
+
+void TestUnitPrimitives() {
+    for (int radSamp: {3, 4, 7, 16, 33, 64}) {
+        for (double radius: {0.1, 1.0, 2.75}) {
+            double length = 3.3 * radius;
+            CHECK(IsIdentical(MeshCreator::CreateCylinder(length, radius, radSamp),
+                              CreateReferenceCylinder(length, radius, radSamp)));
+            CHECK(IsIdentical(MeshCreator::CreateSphere(radius, radSamp), CreateReferenceSphere(radius, radSamp)));
+            CHECK(IsIdentical(MeshCreator::CreateCone(length, radius, radSamp),
+                              CreateReferenceCone(length, radius, radSamp)));
+        }
+    }
+}
+
+void TestPlacedPrimitives() {
+    /// The positioned overloads place the unit primitive by the same transform as before
+    Eigen::Vector3d startPt(0.2, -1.0, 0.5), endPt(1.7, 0.4, -0.3);
+    double radius = 0.35;
+    int radSamp = 24;
+    double length = (endPt - startPt).norm();
+    Eigen::Affine3d rotMat = GetRotationMatrix(Eigen::Vector3d(1, 0, 0), (endPt - startPt).normalized());
+
+    Mesh *cylinder = CreateReferenceCylinder(length, radius, radSamp);
+    cylinder->Transform(GetTranslationMatrix(0.5f * (startPt + endPt)) * rotMat);
+    CHECK(IsIdentical(MeshCreator::CreateCylinder(startPt, endPt, radius, radSamp), cylinder));
+
+    Mesh *cone = CreateReferenceCone(length, radius, radSamp);
+    cone->Transform(GetTranslationMatrix(startPt) * rotMat);
+    CHECK(IsIdentical(MeshCreator::CreateCone(startPt, endPt, radius, radSamp), cone));
+
+    Mesh *sphere = CreateReferenceSphere(radius, radSamp);
+    sphere->Transform(GetTranslationMatrix(startPt));
+    CHECK(IsIdentical(MeshCreator::CreateSphere(startPt, radius, radSamp), sphere));
+}
+
+void TestRectangularSurface() {
+    int rows = 5, cols = 7;
+    std::vector<Eigen::Vector3d> verList;
+    for (int i = 0; i < rows; i++) {
+        for (int j = 0; j < cols; j++)
+            verList.emplace_back(0.1 * j, 0.2 * i, 0.01 * i * j);
+    }
+    std::vector<Eigen::Vector3i> faceList;
+    for (int i = 0; i < rows - 1; i++) {
+        for (int j = 0; j < cols - 1; j++) {
+            int id = i * cols + j;
+            faceList.emplace_back(id, id + cols, id + 1);
+            faceList.emplace_back(id + 1, id + cols, id + cols + 1);
+        }
+    }
+    CHECK(IsIdentical(MeshCreator::CreateRectangularSurface(verList, rows, cols), new Mesh(verList, faceList)));
+}
+
+void TestConcurrentCreation() {
+    /// Threads asking for the same (new) template at once must all get the same primitive
+    const int threadNum = 8;
+    std::vector<Mesh *> meshList(threadNum);
+    std::vector<std::thread> threadList;
+    for (int t = 0; t < threadNum; t++)
+        threadList.emplace_back([&meshList, t]() { meshList[t] = MeshCreator::CreateSphere(1.5, 97); });
+    for (std::thread &thread: threadList)
+        thread.join();
+    for (int t = 0; t < threadNum; t++)
+        CHECK(IsIdentical(meshList[t], CreateReferenceSphere(1.5, 97)));
+}
+
+int main() {
+    TestUnitPrimitives();
+    TestPlacedPrimitives();
+    TestRectangularSurface();
+    TestConcurrentCreation();
+    return ReportTest("PrimitiveTest");
+}
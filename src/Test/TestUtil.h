@@ -0,0 +1,45 @@
+/// ========================================
+///
+///     TestUtil.h
+///
+///     Checks shared by the tests: each test
+///     is an executable returning 0 on success
+///
+/// ========================================
+
+#ifndef TESTUTIL_H
+#define TESTUTIL_H
+
+#include <cmath>
+#include <cstdio>
+#include <algorithm>
+#include <Eigen/Core>
+
+inline int TestFailNum = 0;
+
+inline void TestCheck(bool condition, const char *expression, const char *file, int line) {
+    if (!condition) {
+        TestFailNum++;
+        printf("%s:%d: check failed: %s\n", file, line, expression);
+    }
+}
+
+#define CHECK(condition) TestCheck((condition), #condition, __FILE__, __LINE__)
+
+/// Relative to the larger magnitude, with an absolute floor for values near zero
+inline bool IsClose(double a, double b, double relTol, double absTol = 1e-12) {
+    return std::abs(a - b) <= std::max(absTol, relTol * std::max(std::abs(a), std::abs(b)));
+}
+
+template <typename DerivedA, typename DerivedB>
+bool IsClose(const Eigen::MatrixBase<DerivedA> &a, const Eigen::MatrixBase<DerivedB> &b, double relTol, double absTol = 1e-12) {
+    return (a - b).cwiseAbs().maxCoeff() <= std::max(absTol, relTol * std::max(a.cwiseAbs().maxCoeff(), b.cwiseAbs().maxCoeff()));
+}
+
+inline int ReportTest(const char *testName) {
+    printf("%s: %s\n", testName, TestFailNum == 0 ? "passed" : "FAILED");
+    return TestFailNum == 0 ? 0 : 1;
+}
+
+
+#endif //TESTUTIL_H
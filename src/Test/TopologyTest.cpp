@@ -0,0 +1,313 @@
+/// ========================================
+///
+///     TopologyTest.cpp
+///
+///     Connectivity against a brute-force
+///     edge map
+///
+/// ========================================
+
+#include <map>
+#include <set>
+#include <limits>
+#include <random>
+#include <algorithm>
+
+#include "Mesh/MeshCreator.h"
+#include "Mesh/MeshTopology.h"
+#include "Test/TestUtil.h"
+
+typedef std::pair<int, int> Edge;
+typedef std::map<Edge, std::vector<int>> EdgeHalfMap;
+
+/// ========================================
+///              Brute Force
+/// ========================================
+
+int GetStartBrute(const Eigen::MatrixX3i &faceM, int h) {
+    return faceM(h / 3, h % 3);
+}
+
+int GetEndBrute(const Eigen::MatrixX3i &faceM, int h) {
+    return faceM(h / 3, (h % 3 + 1) % 3);
+}
+
+/// Half-edges of each undirected edge (smaller vertex first), in ascending order
+EdgeHalfMap BuildEdgeHalfMapBrute(const Eigen::MatrixX3i &faceM) {
+    EdgeHalfMap edgeHalfMap;
+    for (int h = 0; h < 3 * faceM.rows(); h++) {
+        int verA = GetStartBrute(faceM, h);
+        int verB = GetEndBrute(faceM, h);
+        edgeHalfMap[std::make_pair(std::min(verA, verB), std::max(verA, verB))].push_back(h);
+    }
+    return edgeHalfMap;
+}
+
+std::vector<int> ToVector(const MeshTopology::IndexRange &range) {
+    return std::vector<int>(range.begin(), range.end());
+}
+
+/// ========================================
+///                 Checks
+/// ========================================
+
+void CheckAdjacency(const MeshTopology &topology, const Eigen::MatrixX3i &faceM, int verNum) {
+    EdgeHalfMap edgeHalfMap = BuildEdgeHalfMapBrute(faceM);
+    int faceNum = static_cast<int>(faceM.rows());
+    CHECK(topology.GetVerNum() == verNum && topology.GetFaceNum() == faceNum);
+
+    /// Vertex -> faces, ascending
+    std::vector<std::vector<int>> verFaceLists(verNum);
+    for (int i = 0; i < faceNum; i++) {
+        for (int k = 0; k < 3; k++)
+            verFaceLists[faceM(i, k)].push_back(i);
+    }
+    bool isSame = true;
+    for (int verID = 0; verID < verNum; verID++)
+        isSame = isSame && ToVector(topology.GetVertexFaces(verID)) == verFaceLists[verID];
+    CHECK(isSame);
+
+    /// Edges in sorted order, each with its half-edges
+    CHECK(topology.GetEdgeNum() == static_cast<int>(edgeHalfMap.size()));
+    int edgeID = 0;
+    isSame = topology.GetEdgeNum() == static_cast<int>(edgeHalfMap.size());
+    for (auto iterator = edgeHalfMap.begin(); isSame && iterator != edgeHalfMap.end(); ++iterator, edgeID++) {
+        const Eigen::Vector2i &edge = topology.GetEdgeList()[edgeID];
+        std::vector<int> halfEdgeList = ToVector(topology.GetEdgeHalfEdges(edgeID));
+        std::sort(halfEdgeList.begin(), halfEdgeList.end());
+        isSame = edge(0) == iterator->first.first && edge(1) == iterator->first.second &&
+                 halfEdgeList == iterator->second;
+        for (int h: iterator->second)
+            isSame = isSame && topology.GetEdge(h) == edgeID;
+    }
+    CHECK(isSame);
+
+    /// Face -> faces: the other faces around each of its edges
+    isSame = true;
+    for (int faceID = 0; faceID < faceNum; faceID++) {
+        std::vector<int> neighborList;
+        for (int h = 3 * faceID; h < 3 * faceID + 3; h++) {
+            int verA = GetStartBrute(faceM, h);
+            int verB = GetEndBrute(faceM, h);
+            for (int other: edgeHalfMap[std::make_pair(std::min(verA, verB), std::max(verA, verB))]) {
+                if (other != h)
+                    neighborList.push_back(other / 3);
+            }
+        }
+        std::vector<int> faceList = ToVector(topology.GetFaceFaces(faceID));
+        std::sort(neighborList.begin(), neighborList.end());
+        std::sort(faceList.begin(), faceList.end());
+        isSame = isSame && faceList == neighborList;
+    }
+    CHECK(isSame);
+
+    /// Twins: the other half-edge of an edge with exactly two, -1 otherwise; the counts of the other edges
+    int boundaryEdgeNum = 0, nonManifoldEdgeNum = 0;
+    isSame = true;
+    for (const auto &edgeHalf: edgeHalfMap) {
+        const std::vector<int> &halfEdgeList = edgeHalf.second;
+        if (halfEdgeList.size() == 2) {
+            isSame = isSame && topology.GetTwin(halfEdgeList[0]) == halfEdgeList[1] &&
+                     topology.GetTwin(halfEdgeList[1]) == halfEdgeList[0];
+            continue;
+        }
+        boundaryEdgeNum += halfEdgeList.size() == 1;
+        nonManifoldEdgeNum += halfEdgeList.size() > 2;
+        for (int h: halfEdgeList)
+            isSame = isSame && topology.GetTwin(h) == -1;
+    }
+    CHECK(isSame);
+    CHECK(topology.GetBoundaryEdgeNum() == boundaryEdgeNum);
+    CHECK(topology.GetNonManifoldEdgeNum() == nonManifoldEdgeNum);
+    CHECK(topology.IsEdgeManifold() == (nonManifoldEdgeNum == 0));
+    CHECK(topology.IsWatertight() == (faceNum > 0 && boundaryEdgeNum == 0 && nonManifoldEdgeNum == 0));
+
+    /// Half-edges of a face follow each other
+    isSame = true;
+    for (int h = 0; h < 3 * faceNum; h++) {
+        isSame = isSame && MeshTopology::GetFace(h) == h / 3 && MeshTopology::GetPrev(MeshTopology::GetNext(h)) == h &&
+                 GetStartBrute(faceM, MeshTopology::GetNext(h)) == GetEndBrute(faceM, h);
+    }
+    CHECK(isSame);
+}
+
+/// The loops walk every boundary half-edge exactly once, head to tail. A closed loop also uses the half-edge
+/// from its last vertex back to its first; an open chain ends where no unused boundary half-edge leaves.
+/// Returns the number of open chains.
+int CheckBoundaryLoops(const MeshTopology &topology, const Eigen::MatrixX3i &faceM) {
+    std::multiset<Edge> boundarySet;
+    for (const auto &edgeHalf: BuildEdgeHalfMapBrute(faceM)) {
+        if (edgeHalf.second.size() == 1) {
+            int h = edgeHalf.second[0];
+            boundarySet.insert(std::make_pair(GetStartBrute(faceM, h), GetEndBrute(faceM, h)));
+        }
+    }
+    size_t boundaryNum = boundarySet.size();
+
+    int openNum = 0;
+    bool isValid = true;
+    for (int loopID = 0; loopID < topology.GetBoundaryLoopNum(); loopID++) {
+        std::vector<int> verList = ToVector(topology.GetBoundaryLoop(loopID));
+        isValid = isValid && verList.size() >= 2;
+        for (int i = 0; isValid && i + 1 < verList.size(); i++) {
+            auto iterator = boundarySet.find(std::make_pair(verList[i], verList[i + 1]));
+            isValid = iterator != boundarySet.end();
+            if (isValid)
+                boundarySet.erase(iterator);
+        }
+        if (!isValid)
+            break;
+        auto closing = boundarySet.find(std::make_pair(verList.back(), verList.front()));
+        if (closing != boundarySet.end()) {
+            boundarySet.erase(closing);
+            continue;
+        }
+        /// Open: nothing unused may leave its last vertex
+        openNum++;
+        auto next = boundarySet.lower_bound(std::make_pair(verList.back(), std::numeric_limits<int>::min()));
+        isValid = next == boundarySet.end() || next->first != verList.back();
+    }
+    CHECK(isValid);
+    CHECK(boundarySet.empty());
+    CHECK(topology.GetBoundaryEdgeNum() == static_cast<int>(boundaryNum));
+    return openNum;
+}
+
+MeshTopology BuildTopology(const Eigen::MatrixX3i &faceM, int verNum) {
+    MeshTopology topology;
+    topology.Build(faceM, verNum);
+    CheckAdjacency(topology, faceM, verNum);
+    return topology;
+}
+
+Eigen::MatrixX3i ToFaceMatrix(const std::vector<Eigen::Vector3i> &faceList) {
+    Eigen::MatrixX3i faceM(faceList.size(), 3);
+    for (int i = 0; i < faceList.size(); i++)
+        faceM.row(i) = faceList[i].transpose();
+    return faceM;
+}
+
+/// ========================================
+///                 Tests
+/// ========================================
+
+void TestClosedMeshes() {
+    /// A cone has a vertex with a long list of faces; the large sphere is built in parallel chunks
+    Mesh *meshList[] = {MeshCreator::CreateSphere(1.0, 16), MeshCreator::CreateCone(1.0, 0.5, 100),
+                        MeshCreator::CreateSphere(1.0, 200)};
+    for (Mesh *mesh: meshList) {
+        MeshTopology topology = BuildTopology(mesh->GetFaceM(), static_cast<int>(mesh->GetVerM().rows()));
+        CHECK(topology.IsWatertight());
+        CHECK(topology.GetBoundaryLoopNum() == 0);
+        /// Consistently oriented: twins run the other way
+        bool isOpposite = true;
+        for (int h = 0; h < 3 * topology.GetFaceNum(); h++) {
+            int twin = topology.GetTwin(h);
+            isOpposite = isOpposite && twin >= 0 && GetStartBrute(mesh->GetFaceM(), twin) ==
+                                                    GetEndBrute(mesh->GetFaceM(), h);
+        }
+        CHECK(isOpposite);
+        /// Euler characteristic of a sphere
+        CHECK(topology.GetVerNum() - topology.GetEdgeNum() + topology.GetFaceNum() == 2);
+        delete mesh;
+    }
+}
+
+void TestBoundaryLoops() {
+    /// A grid: one loop around it
+    int rows = 6, cols = 9;
+    std::vector<Eigen::Vector3d> verList;
+    for (int i = 0; i < rows; i++) {
+        for (int j = 0; j < cols; j++)
+            verList.emplace_back(j, i, 0);
+    }
+    Mesh *grid = MeshCreator::CreateRectangularSurface(verList, rows, cols);
+    int verNum = rows * cols;
+    MeshTopology topology = BuildTopology(grid->GetFaceM(), verNum);
+    CHECK(topology.GetBoundaryLoopNum() == 1);
+    CHECK(topology.GetBoundaryLoop(0).size() == 2 * (rows - 1) + 2 * (cols - 1));
+    CHECK(CheckBoundaryLoops(topology, grid->GetFaceM()) == 0);
+
+    /// Two triangular holes touching at one vertex, which is left by two boundary half-edges: every loop is
+    /// still closed
+    int touchVer = 2 * cols + 2;
+    int faceA = 2 * (2 * (cols - 1) + 2);
+    int faceB = 2 * (1 * (cols - 1) + 1) + 1;
+    CHECK((grid->GetFaceM().row(faceA).array() == touchVer).any() &&
+          (grid->GetFaceM().row(faceB).array() == touchVer).any());
+    std::vector<Eigen::Vector3i> faceList;
+    for (int i = 0; i < grid->GetFaceM().rows(); i++) {
+        if (i != faceA && i != faceB)
+            faceList.emplace_back(grid->GetFaceM().row(i).transpose());
+    }
+    Eigen::MatrixX3i holeFaceM = ToFaceMatrix(faceList);
+    topology = BuildTopology(holeFaceM, verNum);
+    CHECK(topology.GetBoundaryEdgeNum() == 2 * (rows - 1) + 2 * (cols - 1) + 6);
+    CHECK(topology.GetBoundaryLoopNum() >= 2);
+    CHECK(CheckBoundaryLoops(topology, holeFaceM) == 0);
+    delete grid;
+}
+
+void TestOpenChains() {
+    /// Two faces on one edge with opposite orientations: the edge has two half-edges but they run the same
+    /// way, and the boundary splits into two chains from vertex 1 to vertex 0
+    Eigen::MatrixX3i flipFaceM(2, 3);
+    flipFaceM << 0, 1, 2, 0, 1, 3;
+    MeshTopology topology = BuildTopology(flipFaceM, 4);
+    CHECK(topology.GetTwin(0) == 3 && topology.GetTwin(3) == 0);
+    CHECK(topology.GetBoundaryLoopNum() == 2);
+    CHECK(CheckBoundaryLoops(topology, flipFaceM) == 2);
+    CHECK(ToVector(topology.GetBoundaryLoop(0)) == std::vector<int>({1, 2, 0}));
+    CHECK(ToVector(topology.GetBoundaryLoop(1)) == std::vector<int>({1, 3, 0}));
+
+    /// Three faces on one edge: non-manifold, no twins on it, and its end points are left by two
+    /// boundary half-edges
+    Eigen::MatrixX3i fanFaceM(3, 3);
+    fanFaceM << 0, 1, 2, 1, 0, 3, 0, 1, 4;
+    topology = BuildTopology(fanFaceM, 5);
+    CHECK(topology.GetNonManifoldEdgeNum() == 1 && !topology.IsEdgeManifold());
+    CHECK(topology.GetBoundaryEdgeNum() == 6);
+    CHECK(topology.GetFaceFaces(0).size() == 2);
+    CheckBoundaryLoops(topology, fanFaceM);
+}
+
+void TestRandomMeshes() {
+    /// Spheres with faces removed, flipped and repeated: holes, open chains and non-manifold edges at once
+    std::mt19937 generator(3);
+    std::uniform_real_distribution<double> random(0, 1);
+    int openNum = 0, nonManifoldEdgeNum = 0;
+    for (int trial = 0; trial < 20; trial++) {
+        Mesh *sphere = MeshCreator::CreateSphere(1.0, 12 + 4 * trial);
+        std::vector<Eigen::Vector3i> faceList;
+        for (int i = 0; i < sphere->GetFaceM().rows(); i++) {
+            Eigen::Vector3i face = sphere->GetFaceM().row(i).transpose();
+            double value = random(generator);
+            if (value < 0.1)
+                continue;
+            if (value < 0.15)
+                std::swap(face(1), face(2));
+            faceList.push_back(face);
+            if (value > 0.97)
+                faceList.push_back(face);
+        }
+        Eigen::MatrixX3i faceM = ToFaceMatrix(faceList);
+        MeshTopology topology = BuildTopology(faceM, static_cast<int>(sphere->GetVerM().rows()));
+        openNum += CheckBoundaryLoops(topology, faceM);
+        nonManifoldEdgeNum += topology.GetNonManifoldEdgeNum();
+        delete sphere;
+    }
+    /// Both cases did come up
+    CHECK(openNum > 0 && nonManifoldEdgeNum > 0);
+
+    /// No faces at all
+    MeshTopology topology = BuildTopology(Eigen::MatrixX3i(0, 3), 4);
+    CHECK(topology.GetEdgeNum() == 0 && topology.GetBoundaryLoopNum() == 0 && !topology.IsWatertight());
+}
+
+int main() {
+    TestClosedMeshes();
+    TestBoundaryLoops();
+    TestOpenChains();
+    TestRandomMeshes();
+    return ReportTest("TopologyTest");
+}
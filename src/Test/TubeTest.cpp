@@ -0,0 +1,241 @@
+/// ========================================
+///
+///     TubeTest.cpp
+///
+///     Swept tubes: closed and consistently
+///     oriented surfaces, volumes and frames
+///
+/// ========================================
+
+#include <map>
+
+#include "Mesh/MeshCreator.h"
+#include "Test/TestUtil.h"
+
+typedef std::vector<Eigen::Vector3d> Curve;
+
+/// ========================================
+///                 Helpers
+/// ========================================
+
+/// Each edge is used once in each direction, so the surface is closed and its faces agree on the orientation;
+/// returns V - E + F
+long CheckClosedOriented(const Mesh &mesh) {
+    const Eigen::MatrixX3i &faceM = mesh.GetFaceM();
+    std::map<std::pair<int, int>, int> edgeCountMap;
+    for (long i = 0; i < faceM.rows(); i++) {
+        for (int k = 0; k < 3; k++)
+            edgeCountMap[std::make_pair(faceM(i, k), faceM(i, (k + 1) % 3))]++;
+    }
+    bool isClosed = !edgeCountMap.empty();
+    for (const auto &edgeCount: edgeCountMap) {
+        auto reverseEdge = edgeCountMap.find(std::make_pair(edgeCount.first.second, edgeCount.first.first));
+        isClosed = isClosed && edgeCount.second == 1 && reverseEdge != edgeCountMap.end() && reverseEdge->second == 1;
+    }
+    CHECK(isClosed);
+    return mesh.GetVerM().rows() - static_cast<long>(edgeCountMap.size()) / 2 + faceM.rows();
+}
+
+/// Area of the regular polygon of a ring, i.e. the cross-section of a straight tube
+double GetRingArea(double radius, int radSamp) {
+    return 0.5 * radSamp * radius * radius * sin(2 * M_PI / radSamp);
+}
+
+Curve CreateCircle(double radius, int ptNum) {
+    Curve curve;
+    for (int i = 0; i < ptNum; i++) {
+        double t = 2 * M_PI * i / ptNum;
+        curve.emplace_back(radius * cos(t), radius * sin(t), 0);
+    }
+    return curve;
+}
+
+/// A trefoil knot: closed and not planar, so its rotation-minimizing frames do not close by themselves
+Curve CreateTrefoil(int ptNum) {
+    Curve curve;
+    for (int i = 0; i < ptNum; i++) {
+        double t = 2 * M_PI * i / ptNum;
+        curve.emplace_back(sin(t) + 2 * sin(2 * t), cos(t) - 2 * cos(2 * t), -sin(3 * t));
+    }
+    return curve;
+}
+
+/// ========================================
+///           Reference Frames
+/// ========================================
+
+/// Tangent at each point by central differences (one-sided at the ends of an open curve)
+Curve GetTangents(const Curve &curve, bool isOpen) {
+    int ptNum = static_cast<int>(curve.size());
+    Curve tangentList(ptNum);
+    for (int i = 0; i < ptNum; i++) {
+        int prev = i > 0 ? i - 1 : (isOpen ? 0 : ptNum - 1);
+        int next = i < ptNum - 1 ? i + 1 : (isOpen ? ptNum - 1 : 0);
+        tangentList[i] = (curve[next] - curve[prev]).normalized();
+    }
+    return tangentList;
+}
+
+/// Rotation-minimizing transport of a normal from point i to point j by the double reflection
+Eigen::Vector3d TransportNormal(const Curve &curve, const Curve &tangentList, const Eigen::Vector3d &normal,
+                                int i, int j) {
+    Eigen::Vector3d v1 = curve[j] - curve[i];
+    Eigen::Vector3d normalL = normal - 2 * v1.dot(normal) / v1.squaredNorm() * v1;
+    Eigen::Vector3d tangentL = tangentList[i] - 2 * v1.dot(tangentList[i]) / v1.squaredNorm() * v1;
+    Eigen::Vector3d v2 = tangentList[j] - tangentL;
+    if (v2.squaredNorm() > 0)
+        normalL -= 2 * v2.dot(normalL) / v2.squaredNorm() * v2;
+    return (normalL - normalL.dot(tangentList[j]) * tangentList[j]).normalized();
+}
+
+/// Signed angle by which the normal of the tube at each point is turned from the normal transported from
+/// the previous point (the segment into point 0 closes a closed curve). The first vertex of each ring
+/// is the point moved by the radius along its normal.
+std::vector<double> GetTwistAngles(const Mesh &tube, const Curve &curve, double radius, int radSamp, bool isOpen) {
+    int ptNum = static_cast<int>(curve.size());
+    Curve tangentList = GetTangents(curve, isOpen);
+    Curve normalList(ptNum);
+    for (int i = 0; i < ptNum; i++)
+        normalList[i] = (tube.GetVerM().row(i * radSamp).transpose() - curve[i]) / radius;
+
+    std::vector<double> angleList;
+    for (int j = isOpen ? 1 : 0; j < ptNum; j++) {
+        int i = j > 0 ? j - 1 : ptNum - 1;
+        Eigen::Vector3d transported = TransportNormal(curve, tangentList, normalList[i], i, j);
+        angleList.push_back(atan2(tangentList[j].dot(transported.cross(normalList[j])), transported.dot(normalList[j])));
+    }
+    return angleList;
+}
+
+/// ========================================
+///                 Tests
+/// ========================================
+
+void TestOpenTube() {
+    /// A straight tube is a prism with two caps: its volume is the ring area times the length
+    Eigen::Vector3d startPt(0.3, -0.2, 1.0), endPt(2.1, 0.9, -0.4);
+    double radius = 0.25;
+    for (int radSamp: {3, 8, 31}) {
+        Curve curve;
+        for (int i = 0; i <= 10; i++)
+            curve.push_back(startPt + (endPt - startPt) * i / 10.0);
+        Mesh *tube = MeshCreator::Create3DCurve(curve, radius, radSamp, "open");
+        CHECK(tube->GetVerM().rows() == 11 * radSamp + 2);
+        CHECK(CheckClosedOriented(*tube) == 2);
+        double volume = tube->ComputeMassProperties().volume;
+        CHECK(volume > 0);
+        CHECK(IsClose(volume, GetRingArea(radius, radSamp) * (endPt - startPt).norm(), 1e-9));
+        delete tube;
+    }
+
+    /// A bent open curve keeps its rotation-minimizing frames: no twist between the rings
+    Curve helix;
+    for (int i = 0; i < 60; i++)
+        helix.emplace_back(cos(0.2 * i), sin(0.2 * i), 0.05 * i);
+    Mesh *tube = MeshCreator::Create3DCurve(helix, 0.1, 12, "open");
+    CHECK(CheckClosedOriented(*tube) == 2);
+    CHECK(tube->ComputeMassProperties().volume > 0);
+    std::vector<double> angleList = GetTwistAngles(*tube, helix, 0.1, 12, true);
+    for (double angle: angleList)
+        CHECK(std::abs(angle) < 1e-9);
+    delete tube;
+}
+
+void TestClosedTube() {
+    /// A torus around a circle: genus one, and by Pappus its volume is close to the ring area times the
+    /// length of the circle
+    double radius = 0.2;
+    int radSamp = 16;
+    Curve circle = CreateCircle(2.0, 200);
+    Mesh *torus = MeshCreator::Create3DCurve(circle, radius, radSamp, "closed");
+    CHECK(torus->GetVerM().rows() == 200 * radSamp);
+    CHECK(CheckClosedOriented(*torus) == 0);
+    double volume = torus->ComputeMassProperties().volume;
+    CHECK(volume > 0);
+    CHECK(IsClose(volume, GetRingArea(radius, radSamp) * 2 * M_PI * 2.0, 1e-3));
+    /// A planar curve needs no correction
+    for (double angle: GetTwistAngles(*torus, circle, radius, radSamp, false))
+        CHECK(std::abs(angle) < 1e-9);
+    delete torus;
+
+    /// Around a knot the transported frame comes back turned: the correction is spread evenly over all
+    /// the segments, the closing one included, and is less than half a turn in total
+    Curve trefoil = CreateTrefoil(300);
+    Mesh *knot = MeshCreator::Create3DCurve(trefoil, 0.1, radSamp, "closed");
+    CHECK(CheckClosedOriented(*knot) == 0);
+    CHECK(knot->ComputeMassProperties().volume > 0);
+    std::vector<double> angleList = GetTwistAngles(*knot, trefoil, 0.1, radSamp, false);
+    CHECK(angleList.size() == trefoil.size());
+    double totalAngle = 0;
+    for (double angle: angleList) {
+        CHECK(IsClose(angle, angleList[0], 1e-6, 1e-9));
+        totalAngle += angle;
+    }
+    CHECK(std::abs(totalAngle) > 1e-3 && std::abs(totalAngle) <= M_PI + 1e-9);
+    delete knot;
+}
+
+void TestManyTubes() {
+    /// The tubes of a batch are the tubes of the single curves, offset into one mesh
+    std::vector<Curve> curveList = {CreateCircle(1.0, 40), CreateTrefoil(90), CreateCircle(0.5, 3)};
+    for (int i = 0; i < curveList.size(); i++) {
+        for (Eigen::Vector3d &pt: curveList[i])
+            pt.x() += 10.0 * i;
+    }
+    for (const std::string type: {"open", "closed"}) {
+        Mesh *batch = MeshCreator::CreateTubes(curveList, 0.1, 8, type);
+        long verNum = 0, faceNum = 0;
+        bool isSame = true;
+        for (const Curve &curve: curveList) {
+            Mesh *tube = MeshCreator::Create3DCurve(curve, 0.1, 8, type);
+            long tubeVerNum = tube->GetVerM().rows();
+            long tubeFaceNum = tube->GetFaceM().rows();
+            isSame = isSame && batch->GetVerM().middleRows(verNum, tubeVerNum) == tube->GetVerM() &&
+                     (batch->GetFaceM().middleRows(faceNum, tubeFaceNum).array() - static_cast<int>(verNum)).matrix() ==
+                     tube->GetFaceM();
+            verNum += tubeVerNum;
+            faceNum += tubeFaceNum;
+            delete tube;
+        }
+        CHECK(isSame);
+        CHECK(batch->GetVerM().rows() == verNum && batch->GetFaceM().rows() == faceNum);
+        CHECK(CheckClosedOriented(*batch) == (type == "open" ? 2 : 0) * static_cast<long>(curveList.size()));
+        delete batch;
+    }
+}
+
+void TestInvalidInput() {
+    /// Rings of less than 3 samples enclose no volume: nothing is built
+    Curve circle = CreateCircle(1.0, 10);
+    for (int radSamp: {-1, 0, 1, 2}) {
+        Mesh *tube = MeshCreator::Create3DCurve(circle, 0.1, radSamp, "closed");
+        CHECK(tube->GetVerM().rows() == 0 && tube->GetFaceM().rows() == 0);
+        delete tube;
+    }
+
+    /// A closed curve needs 3 points and an open one 2; shorter curves of a batch are skipped
+    Curve segment = {Eigen::Vector3d(0, 0, 0), Eigen::Vector3d(1, 0, 0)};
+    Mesh *tube = MeshCreator::Create3DCurve(segment, 0.1, 8, "closed");
+    CHECK(tube->GetVerM().rows() == 0 && tube->GetFaceM().rows() == 0);
+    delete tube;
+    tube = MeshCreator::Create3DCurve(segment, 0.1, 8, "open");
+    CHECK(tube->GetVerM().rows() == 2 * 8 + 2 && CheckClosedOriented(*tube) == 2);
+    delete tube;
+
+    Mesh *batch = MeshCreator::CreateTubes({segment, circle, {Eigen::Vector3d(0, 0, 0)}, {}}, 0.1, 8, "closed");
+    CHECK(batch->GetVerM().rows() == 10 * 8);
+    CHECK(CheckClosedOriented(*batch) == 0);
+    delete batch;
+
+    tube = MeshCreator::Create3DCurve(circle, 0.1, 8, "twisted");
+    CHECK(tube->GetVerM().rows() == 0);
+    delete tube;
+}
+
+int main() {
+    TestOpenTube();
+    TestClosedTube();
+    TestManyTubes();
+    TestInvalidInput();
+    return ReportTest("TubeTest");
+}
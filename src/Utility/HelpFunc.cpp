@@ -12,6 +12,8 @@
 
 #include "HelpFunc.h"
 
+#include <cstring>
+
 double GetRandomDouble(double a, double b) {
     static std::mt19937 generator(rand());
     std::uniform_real_distribution<double> distribution(a, b);
@@ -85,6 +87,12 @@ Eigen::Affine3d GetScalingMatrix(double scale) {
     return GetScalingMatrix(Eigen::Vector3d::Ones() * scale);
 }
 
+/// A rotation (orthonormal, no reflection) plus a translation
+bool IsRigidTransform(const Eigen::Affine3d &affineMat, double eps) {
+    Eigen::Matrix3d L = affineMat.linear();
+    return (L.transpose() * L - Eigen::Matrix3d::Identity()).cwiseAbs().maxCoeff() < eps && L.determinant() > 0;
+}
+
 Eigen::Vector3d MultiplyPoint(const Eigen::Affine3d &affineMat, const Eigen::Vector3d &pt) {
     return affineMat * pt;
 }
@@ -126,4 +134,57 @@ Eigen::RowVector3d GetRGB(const std::string &colorName) {
         std::cout << "Unknown color name: " << colorName << std::endl;
         return {0.0, 0.0, 0.0};
     }
-}
\ No newline at end of file
+}
+
+static inline uint64_t RotateLeft(uint64_t x, int r) {
+    return (x << r) | (x >> (64 - r));
+}
+
+static inline uint64_t MixBits(uint64_t h) {
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdULL;
+    h ^= h >> 33;
+    h *= 0xc4ceb9fe1a85ec53ULL;
+    h ^= h >> 33;
+    return h;
+}
+
+/// Word-wise hash with four independent lanes (fast, not cryptographic)
+uint64_t HashBytes(const void *data, size_t size, uint64_t seed) {
+    const uint64_t prime = 0x9E3779B185EBCA87ULL;
+    const auto *bytes = static_cast<const unsigned char *>(data);
+
+    uint64_t lane[4] = {seed, seed + prime, seed - prime, ~seed};
+    size_t i = 0;
+    for (; i + 32 <= size; i += 32) {
+        for (int k = 0; k < 4; k++) {
+            uint64_t word;
+            std::memcpy(&word, bytes + i + 8 * k, 8);
+            lane[k] = RotateLeft((lane[k] ^ word) * prime, 31);
+        }
+    }
+    for (; i + 8 <= size; i += 8) {
+        uint64_t word;
+        std::memcpy(&word, bytes + i, 8);
+        lane[0] = RotateLeft((lane[0] ^ word) * prime, 31);
+    }
+    if (i < size) {
+        uint64_t word = 0;
+        std::memcpy(&word, bytes + i, size - i);
+        lane[1] = RotateLeft((lane[1] ^ word) * prime, 31);
+    }
+
+    uint64_t h = lane[0] ^ RotateLeft(lane[1], 7) ^ RotateLeft(lane[2], 12) ^ RotateLeft(lane[3], 18);
+    return MixBits(h ^ size);
+}
+
+uint64_t HashCombine(uint64_t seed, uint64_t value) {
+    return MixBits(seed ^ RotateLeft(MixBits(value + 0x9E3779B97F4A7C15ULL), 29));
+}
+
+std::string GetUniqueTempPath(const std::string &path) {
+    thread_local std::mt19937_64 generator(std::random_device{}());
+    char suffix[32];
+    snprintf(suffix, sizeof(suffix), ".%016llx.tmp", static_cast<unsigned long long>(generator()));
+    return path + suffix;
+}
@@ -14,10 +14,12 @@
 #define HELPFUNC_H
 
 #include <cfloat>
+#include <cstdint>
 #include <random>
 #include <iostream>
 #include <unordered_map>
 #include <Eigen/Geometry>
+#include <igl/parallel_for.h>
 
 double GetRandomDouble(double a, double b);
 
@@ -34,9 +36,54 @@ Eigen::Affine3d GetRotationMatrix(const Eigen::Vector3d &startVec, const Eigen::
 Eigen::Affine3d GetScalingMatrix(const Eigen::Vector3d &scaleVec);
 Eigen::Affine3d GetScalingMatrix(double scale);
 
+bool IsRigidTransform(const Eigen::Affine3d &affineMat, double eps = 1e-12);
+
 Eigen::Vector3d MultiplyPoint(const Eigen::Affine3d &affineMat, const Eigen::Vector3d &pt);
 Eigen::Vector3d MultiplyVector(const Eigen::Affine3d &affineMat, const Eigen::Vector3d &vec);
 
+/// Rows transformed together by one task
+const int TransformBlockSize = 1024;
+
+/// Apply an affine to every row of a (n,3) vertex matrix of any scalar type and layout.
+/// SoA matrices are transformed column by column (vectorized), AoS matrices row by row;
+/// blocks of rows run in parallel. verM and newVerM may be the same matrix.
+template <typename DerivedIn, typename DerivedOut>
+void TransformVertexMatrix(const Eigen::Affine3d &affineMat,
+                           const Eigen::MatrixBase<DerivedIn> &verM,
+                           Eigen::MatrixBase<DerivedOut> &newVerM) {
+    typedef typename DerivedOut::Scalar Scalar;
+    const Eigen::Matrix<Scalar, 3, 3> L = affineMat.linear().cast<Scalar>();
+    const Eigen::Matrix<Scalar, 3, 1> t = affineMat.translation().cast<Scalar>();
+
+    long verNum = verM.rows();
+    long blockNum = (verNum + TransformBlockSize - 1) / TransformBlockSize;
+    igl::parallel_for(blockNum, [&](long b) {
+        long start = b * TransformBlockSize;
+        long size = std::min<long>(TransformBlockSize, verNum - start);
+
+        if constexpr (DerivedIn::IsRowMajor) {
+            for (long i = start; i < start + size; i++) {
+                Eigen::Matrix<Scalar, 3, 1> p = verM.row(i).transpose().template cast<Scalar>();
+                newVerM.row(i) = (L * p + t).transpose();
+            }
+        } else {
+            Eigen::Array<Scalar, Eigen::Dynamic, 3, Eigen::ColMajor, TransformBlockSize, 3> block(size, 3);
+            auto x = verM.col(0).segment(start, size).array().template cast<Scalar>();
+            auto y = verM.col(1).segment(start, size).array().template cast<Scalar>();
+            auto z = verM.col(2).segment(start, size).array().template cast<Scalar>();
+            for (int j = 0; j < 3; j++)
+                block.col(j) = L(j, 0) * x + L(j, 1) * y + L(j, 2) * z + t(j);
+            newVerM.middleRows(start, size) = block.matrix();
+        }
+    }, 8);
+}
+
 Eigen::RowVector3d GetRGB(const std::string& colorName);
 
+uint64_t HashBytes(const void *data, size_t size, uint64_t seed = 0);
+uint64_t HashCombine(uint64_t seed, uint64_t value);
+
+/// Name for a temporary file next to path, unique across threads and processes
+std::string GetUniqueTempPath(const std::string &path);
+
 #endif //HELPFUNC_H